@@ -0,0 +1,65 @@
+// Counts heap allocations made by the store while loading and churning tasks.
+#include <iostream>
+#include <iomanip>
+#include "alloc_counter.h"
+#include "bench_common.h"
+#include "task_manager.h"
+
+static void report(const char* phase, std::size_t tasks, const AllocationStats& before, const AllocationStats& after) {
+	std::size_t allocations = after.allocations - before.allocations;
+	std::cout << std::left << std::setw(10) << tasks << std::setw(16) << phase << std::right
+		<< std::setw(14) << allocations << std::fixed << std::setprecision(2)
+		<< std::setw(14) << static_cast<double>(allocations) / tasks
+		<< std::setw(12) << (static_cast<double>(after.live_bytes) - static_cast<double>(before.live_bytes)) / (1024.0 * 1024.0)
+		<< std::endl;
+}
+
+int main(int argc, char** argv) {
+	std::vector<std::size_t> sizes = bench_sizes(argc, argv, { 100000, 1000000 });
+
+	std::cout << std::left << std::setw(10) << "tasks" << std::setw(16) << "phase" << std::right
+		<< std::setw(14) << "allocations" << std::setw(14) << "per task" << std::setw(12) << "heap MB" << std::endl;
+
+	for (std::size_t count : sizes) {
+		std::string path = "bench_alloc_" + std::to_string(count) + ".json";
+		write_json_store(path, count);
+		{
+			TaskManager converter(path);
+			converter.export_snapshot(path + ".bin");
+		}
+
+		AllocationStats before = allocation_stats();
+		auto manager = std::make_unique<TaskManager>(path + ".bin");
+		AllocationStats after = allocation_stats();
+		report("load", count, before, after);
+
+		// Churn half of the store: removals, re-adds and description edits
+		// all append journal records too, which are part of the count.
+		std::size_t half = count / 2;
+		before = allocation_stats();
+		for (std::size_t id = 1; id <= count; id += 2) {
+			manager->remove_task(static_cast<int>(id));
+		}
+		after = allocation_stats();
+		report("remove half", half, before, after);
+
+		before = allocation_stats();
+		for (std::size_t i = 0; i < half; i++) {
+			manager->add_task(bench_description(i));
+		}
+		after = allocation_stats();
+		report("add half", half, before, after);
+
+		before = allocation_stats();
+		for (std::size_t id = 2; id <= count; id += 2) {
+			manager->update_task_description(static_cast<int>(id), bench_description(id + count));
+		}
+		after = allocation_stats();
+		report("edit half", half, before, after);
+
+		manager.reset();
+		remove_store(path);
+		remove_store(path + ".bin");
+	}
+	return 0;
+}
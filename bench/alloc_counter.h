@@ -0,0 +1,79 @@
+#pragma once
+// Replaces the global allocation functions with counting versions. Include
+// this from exactly one translation unit of a benchmark program.
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+struct AllocationStats {
+	std::size_t allocations;
+	std::size_t live_bytes;
+};
+
+namespace alloc_counter {
+	inline std::atomic<std::size_t> allocations{ 0 };
+	inline std::atomic<std::size_t> live_bytes{ 0 };
+	// Every block carries its size in front of it so that delete can account for it
+	constexpr std::size_t header = alignof(std::max_align_t);
+}
+
+inline AllocationStats allocation_stats() {
+	return { alloc_counter::allocations.load(), alloc_counter::live_bytes.load() };
+}
+
+void* operator new(std::size_t size) {
+	void* block = std::malloc(size + alloc_counter::header);
+	if (!block) {
+		throw std::bad_alloc();
+	}
+	*static_cast<std::size_t*>(block) = size;
+	alloc_counter::allocations++;
+	alloc_counter::live_bytes += size;
+	return static_cast<char*>(block) + alloc_counter::header;
+}
+
+void operator delete(void* ptr) noexcept {
+	if (!ptr) {
+		return;
+	}
+	void* block = static_cast<char*>(ptr) - alloc_counter::header;
+	alloc_counter::live_bytes -= *static_cast<std::size_t*>(block);
+	std::free(block);
+}
+
+// Over-aligned requests (e.g. from std::pmr::new_delete_resource) keep the
+// size in the word just before the returned pointer.
+void* operator new(std::size_t size, std::align_val_t align) {
+	std::size_t alignment = static_cast<std::size_t>(align) < alloc_counter::header
+		? alloc_counter::header : static_cast<std::size_t>(align);
+	std::size_t total = (size + 2 * alignment - 1) / alignment * alignment;
+	char* block = static_cast<char*>(std::aligned_alloc(alignment, total));
+	if (!block) {
+		throw std::bad_alloc();
+	}
+	*reinterpret_cast<std::size_t*>(block + alignment - sizeof(std::size_t)) = size;
+	alloc_counter::allocations++;
+	alloc_counter::live_bytes += size;
+	return block + alignment;
+}
+
+void operator delete(void* ptr, std::align_val_t align) noexcept {
+	if (!ptr) {
+		return;
+	}
+	std::size_t alignment = static_cast<std::size_t>(align) < alloc_counter::header
+		? alloc_counter::header : static_cast<std::size_t>(align);
+	char* block = static_cast<char*>(ptr) - alignment;
+	alloc_counter::live_bytes -= *reinterpret_cast<std::size_t*>(block + alignment - sizeof(std::size_t));
+	std::free(block);
+}
+
+void* operator new[](std::size_t size) { return operator new(size); }
+void* operator new[](std::size_t size, std::align_val_t align) { return operator new(size, align); }
+void operator delete[](void* ptr, std::align_val_t align) noexcept { operator delete(ptr, align); }
+void operator delete(void* ptr, std::size_t, std::align_val_t align) noexcept { operator delete(ptr, align); }
+void operator delete[](void* ptr, std::size_t, std::align_val_t align) noexcept { operator delete(ptr, align); }
+void operator delete[](void* ptr) noexcept { operator delete(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { operator delete(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept { operator delete(ptr); }
@@ -0,0 +1,59 @@
+#pragma once
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "task.h"
+
+// Runs `fn` once and returns the elapsed wall-clock time in milliseconds.
+template <typename Fn>
+double time_ms(Fn&& fn) {
+	auto start = std::chrono::steady_clock::now();
+	fn();
+	auto end = std::chrono::steady_clock::now();
+	return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+// Task counts from the command line, or the defaults.
+inline std::vector<std::size_t> bench_sizes(int argc, char** argv, std::vector<std::size_t> defaults) {
+	if (argc < 2) {
+		return defaults;
+	}
+	std::vector<std::size_t> sizes;
+	for (int i = 1; i < argc; i++) {
+		sizes.push_back(std::strtoull(argv[i], nullptr, 10));
+	}
+	return sizes;
+}
+
+inline std::string bench_description(std::size_t i) {
+	return "Benchmark task " + std::to_string(i) + ": review the deployment checklist and update the runbook";
+}
+
+// Writes a tasks.json-style snapshot with `count` tasks in mixed states.
+inline void write_json_store(const std::string& path, std::size_t count) {
+	nlohmann::json j_tasks = nlohmann::json::array();
+	for (std::size_t i = 1; i <= count; i++) {
+		nlohmann::json j_task;
+		j_task["id"] = i;
+		j_task["description"] = bench_description(i);
+		j_task["status"] = status_to_string(static_cast<TaskStatus>(i % 3));
+		j_task["created_at"] = 1672567200 + static_cast<std::time_t>(i);
+		j_task["updated_at"] = 1672567200 + static_cast<std::time_t>(i * 2);
+		j_tasks.push_back(std::move(j_task));
+	}
+	nlohmann::json j_root;
+	j_root["next_id"] = count + 1;
+	j_root["tasks"] = std::move(j_tasks);
+	std::ofstream file(path, std::ios::binary);
+	file << j_root.dump(4);
+}
+
+inline void remove_store(const std::string& path) {
+	std::remove(path.c_str());
+	std::remove((path + ".journal").c_str());
+}
@@ -0,0 +1,92 @@
+// Measures the task-tracker executable as automation runs it: the cold
+// latency of one-shot commands against stores of several sizes, and 1000
+// additions run as one-shot processes, piped through the REPL, or as one
+// --script. Each run is a fresh process, started with posix_spawn and its
+// output sent to /dev/null.
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <iostream>
+#include <iomanip>
+#include "bench_common.h"
+
+extern char** environ;
+
+// Runs the executable with `args`, stdin from `input` (or /dev/null), and
+// returns its exit code.
+static int run(std::vector<std::string> args, const char* input = "/dev/null") {
+	args.insert(args.begin(), TASK_TRACKER_EXE);
+	std::vector<char*> argv;
+	for (std::string& arg : args) {
+		argv.push_back(arg.data());
+	}
+	argv.push_back(nullptr);
+	posix_spawn_file_actions_t actions;
+	posix_spawn_file_actions_init(&actions);
+	posix_spawn_file_actions_addopen(&actions, 0, input, O_RDONLY, 0);
+	posix_spawn_file_actions_addopen(&actions, 1, "/dev/null", O_WRONLY, 0);
+	posix_spawn_file_actions_addopen(&actions, 2, "/dev/null", O_WRONLY, 0);
+	pid_t pid = 0;
+	int status = -1;
+	if (posix_spawn(&pid, TASK_TRACKER_EXE, &actions, nullptr, argv.data(), environ) == 0) {
+		waitpid(pid, &status, 0);
+	}
+	posix_spawn_file_actions_destroy(&actions);
+	return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+int main(int argc, char** argv) {
+	std::vector<std::size_t> sizes = bench_sizes(argc, argv, { 0, 10000, 100000 });
+	const int repeats = 20;
+	const int commands = 1000;
+
+	std::filesystem::path dir = std::filesystem::temp_directory_path() / "bench_cli";
+	std::filesystem::create_directories(dir);
+	std::filesystem::current_path(dir);
+
+	std::cout << std::left << std::setw(10) << "tasks" << std::setw(30) << "run"
+		<< std::right << std::setw(12) << "ms" << std::endl;
+	auto row = [](std::size_t count, const std::string& name, double ms) {
+		std::cout << std::left << std::setw(10) << count << std::setw(30) << name
+			<< std::right << std::fixed << std::setprecision(2) << std::setw(12) << ms << std::endl;
+	};
+
+	for (std::size_t count : sizes) {
+		remove_store("tasks.json");
+		write_json_store("tasks.json", count);
+		run({ "--list", "--limit", "1" }); // warm the page cache and the journal
+
+		row(count, "--get 1 (each)", time_ms([&] {
+			for (int i = 0; i < repeats; i++) {
+				run({ "--get", "1" });
+			}
+		}) / repeats);
+		row(count, "--add (each)", time_ms([&] {
+			for (int i = 0; i < repeats; i++) {
+				run({ "--add", "Cold start task" });
+			}
+		}) / repeats);
+
+		std::string script = "bench_cli_script.txt";
+		{
+			std::ofstream file(script);
+			for (int i = 0; i < commands; i++) {
+				file << "--add \"Scripted task " << i << "\"\n";
+			}
+		}
+		if (count <= 10000) {
+			row(count, "1000 x one-shot --add", time_ms([&] {
+				for (int i = 0; i < commands; i++) {
+					run({ "--add", "One-shot task" });
+				}
+			}));
+		}
+		row(count, "1000 --add piped to the REPL", time_ms([&] { run({}, script.c_str()); }));
+		row(count, "1000 --add via --script", time_ms([&] { run({ "--script", script }); }));
+		std::remove(script.c_str());
+	}
+	remove_store("tasks.json");
+	std::filesystem::current_path(dir.parent_path());
+	std::filesystem::remove_all(dir);
+	return 0;
+}
@@ -0,0 +1,58 @@
+// Measures the per-line cost of reading REPL and script commands: splitting
+// a line with std::quoted into strings (what the REPL did before handing the
+// result to cxxopts, whose parse came on top), against CommandLexer plus
+// parse_command. The argument is the number of lines.
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include "bench_common.h"
+#include "command_line.h"
+
+int main(int argc, char** argv) {
+	std::size_t count = bench_sizes(argc, argv, { 1000000 })[0];
+	const std::vector<std::string> lines = {
+		"--add \"Write the quarterly report\"",
+		"--update 42 --status IN_PROGRESS",
+		"--update 42 --desc \"Say \\\"hi\\\" to the team\" -s DONE",
+		"--list --limit 20 --sort updated:desc",
+		"-g 1234",
+	};
+
+	std::size_t tokens = 0;
+	double quoted = time_ms([&] {
+		for (std::size_t i = 0; i < count; i++) {
+			std::istringstream iss(lines[i % lines.size()]);
+			std::vector<std::string> args;
+			std::string arg;
+			while (iss >> std::quoted(arg)) {
+				args.push_back(arg);
+			}
+			std::vector<char*> c_argv;
+			for (std::string& s : args) {
+				c_argv.push_back(s.data());
+			}
+			tokens += c_argv.size();
+		}
+	});
+
+	std::size_t options = 0;
+	std::string line;
+	double parsed = time_ms([&] {
+		for (std::size_t i = 0; i < count; i++) {
+			line = lines[i % lines.size()];
+			CommandLexer lexer(line);
+			ParsedCommand command = parse_command(lexer);
+			options += command.count(CommandOption::Status) + command.count(CommandOption::Add);
+		}
+	});
+
+	std::cout << std::left << std::setw(34) << "step" << std::right << std::setw(12) << "ms"
+		<< std::setw(14) << "lines/s" << std::endl;
+	for (auto [name, ms] : { std::pair{ "std::quoted into strings", quoted },
+		std::pair{ "CommandLexer + parse_command", parsed } }) {
+		std::cout << std::left << std::setw(34) << name << std::right << std::fixed << std::setprecision(2)
+			<< std::setw(12) << ms << std::setw(14) << std::setprecision(0) << count / (ms / 1000) << std::endl;
+	}
+	std::cerr << tokens << " " << options << std::endl;
+	return 0;
+}
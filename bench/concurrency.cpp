@@ -0,0 +1,64 @@
+// Measures ConcurrentTaskManager throughput with 1..N threads for a read-only
+// workload and for a mix of 95% reads / 5% status updates.
+#include <atomic>
+#include <iostream>
+#include <iomanip>
+#include <thread>
+#include "bench_common.h"
+#include "concurrent_task_manager.h"
+
+static double run(ConcurrentTaskManager& manager, int threads, int write_percent, std::size_t count) {
+	const int ops_per_thread = 200000;
+	std::vector<std::thread> workers;
+	double elapsed = time_ms([&] {
+		for (int t = 0; t < threads; t++) {
+			workers.emplace_back([&, t] {
+				std::uint32_t seed = 2654435761u * static_cast<std::uint32_t>(t + 1);
+				std::size_t found = 0;
+				for (int i = 0; i < ops_per_thread; i++) {
+					seed = seed * 1664525u + 1013904223u;
+					int id = 1 + static_cast<int>(seed % count);
+					if (static_cast<int>((seed >> 16) % 100) < write_percent) {
+						manager.update_task_status(id, (seed & 1) ? "DONE" : "IN_PROGRESS");
+					}
+					else {
+						found += manager.get_task(id).has_value();
+					}
+				}
+				if (found == 0 && write_percent < 100) {
+					std::cerr << "no task found" << std::endl;
+				}
+			});
+		}
+		for (std::thread& worker : workers) {
+			worker.join();
+		}
+	});
+	return threads * ops_per_thread / elapsed * 1000.0;
+}
+
+int main(int argc, char** argv) {
+	std::vector<std::size_t> sizes = bench_sizes(argc, argv, { 100000 });
+	unsigned max_threads = std::max(4u, std::thread::hardware_concurrency());
+
+	std::cout << std::left << std::setw(10) << "tasks" << std::setw(10) << "threads" << std::right
+		<< std::setw(18) << "read ops/s" << std::setw(18) << "95/5 ops/s" << std::endl;
+
+	for (std::size_t count : sizes) {
+		std::string path = "bench_concurrency_" + std::to_string(count) + ".json";
+		write_json_store(path, count);
+		{
+			TaskManagerOptions options;
+			options.async_persistence = true; // keep disk writes out of the lock
+			ConcurrentTaskManager manager(path, options);
+			for (unsigned threads = 1; threads <= max_threads; threads *= 2) {
+				double reads = run(manager, static_cast<int>(threads), 0, count);
+				double mixed = run(manager, static_cast<int>(threads), 5, count);
+				std::cout << std::left << std::setw(10) << count << std::setw(10) << threads << std::right << std::fixed
+					<< std::setprecision(0) << std::setw(18) << reads << std::setw(18) << mixed << std::endl;
+			}
+		}
+		remove_store(path);
+	}
+	return 0;
+}
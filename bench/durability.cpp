@@ -0,0 +1,40 @@
+// Measures what each durability level costs per mutation and per snapshot.
+#include <iostream>
+#include <iomanip>
+#include "bench_common.h"
+#include "task_manager.h"
+
+int main(int argc, char** argv) {
+	std::vector<std::size_t> sizes = bench_sizes(argc, argv, { 10000, 100000 });
+	const int mutations = 2000;
+
+	std::cout << std::left << std::setw(10) << "tasks" << std::setw(10) << "level" << std::right
+		<< std::setw(16) << "mutation us" << std::setw(16) << "snapshot ms" << std::endl;
+
+	for (std::size_t count : sizes) {
+		for (Durability level : { Durability::None, Durability::Flush, Durability::Fsync }) {
+			std::string path = "bench_durability_" + std::to_string(count) + ".json";
+			write_json_store(path, count);
+
+			TaskManagerOptions options;
+			options.durability = level;
+			double mutate, snapshot;
+			{
+				TaskManager manager(path, options);
+				mutate = time_ms([&] {
+					for (int i = 0; i < mutations; i++) {
+						manager.update_task_status(1 + i % static_cast<int>(count), i % 2 ? "DONE" : "IN_PROGRESS");
+					}
+				});
+				snapshot = time_ms([&] { manager.compact(); });
+			}
+
+			const char* name = level == Durability::None ? "none" : level == Durability::Flush ? "flush" : "fsync";
+			std::cout << std::left << std::setw(10) << count << std::setw(10) << name << std::right << std::fixed
+				<< std::setprecision(2) << std::setw(16) << mutate * 1000.0 / mutations
+				<< std::setprecision(1) << std::setw(16) << snapshot << std::endl;
+			remove_store(path);
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,45 @@
+// Compares writing the whole store to a file: export_snapshot() (which
+// encodes one string holding the snapshot) against export_tasks() streaming
+// JSON lines, CSV and TSV through a 64 KiB buffer.
+#include <filesystem>
+#include <iostream>
+#include <iomanip>
+#include "bench_common.h"
+#include "task_manager.h"
+#include "ui.h"
+
+int main(int argc, char** argv) {
+	std::vector<std::size_t> sizes = bench_sizes(argc, argv, { 100000, 1000000 });
+
+	std::cout << std::left << std::setw(10) << "tasks" << std::setw(18) << "method"
+		<< std::right << std::setw(10) << "ms" << std::setw(10) << "MB" << std::setw(10) << "MB/s" << std::endl;
+
+	for (std::size_t count : sizes) {
+		std::string path = "bench_export_" + std::to_string(count) + ".json";
+		std::string out_path = "bench_export_" + std::to_string(count) + ".out";
+		write_json_store(path, count);
+		{
+			TaskManager manager(path);
+			auto row = [&](const char* method, double ms) {
+				double mb = static_cast<double>(std::filesystem::file_size(out_path)) / (1024 * 1024);
+				std::cout << std::left << std::setw(10) << count << std::setw(18) << method
+					<< std::right << std::fixed << std::setprecision(2) << std::setw(10) << ms
+					<< std::setw(10) << mb << std::setw(10) << mb / (ms / 1000) << std::endl;
+			};
+
+			std::remove(out_path.c_str());
+			row("export_snapshot", time_ms([&] { manager.export_snapshot(out_path, SnapshotFormat::Json); }));
+			for (auto [name, style] : { std::pair{ "jsonl", RenderStyle::JsonLines },
+				std::pair{ "csv", RenderStyle::Csv }, std::pair{ "tsv", RenderStyle::Tsv } }) {
+				std::remove(out_path.c_str());
+				row(name, time_ms([&] {
+					std::ofstream file(out_path, std::ios::binary);
+					export_tasks(manager, file, style);
+				}));
+			}
+		}
+		std::remove(out_path.c_str());
+		remove_store(path);
+	}
+	return 0;
+}
@@ -0,0 +1,59 @@
+// Compares substring filtering over every description: the naive
+// std::string_view::find loop over list_tasks(), each SubstringMatcher
+// kernel over the same list, and TaskManager::filter_contains().
+#include <iostream>
+#include <iomanip>
+#include "bench_common.h"
+#include "task_manager.h"
+
+int main(int argc, char** argv) {
+	std::vector<std::size_t> sizes = bench_sizes(argc, argv, { 100000, 1000000 });
+	// every description, one description, none
+	const char* needles[] = { "runbook", "task 77777:", "rollback plan" };
+
+	std::cout << "best kernel: " << scan_kernel_name(best_scan_kernel()) << std::endl;
+	std::cout << std::left << std::setw(10) << "tasks" << std::setw(16) << "needle" << std::setw(16) << "method"
+		<< std::right << std::setw(10) << "ms" << std::setw(10) << "matches" << std::endl;
+
+	for (std::size_t count : sizes) {
+		std::string path = "bench_filter_" + std::to_string(count) + ".json";
+		write_json_store(path, count);
+		{
+			TaskManager manager(path);
+			for (const char* needle : needles) {
+				auto row = [&](const char* method, double ms, std::size_t matches) {
+					std::cout << std::left << std::setw(10) << count << std::setw(16) << needle << std::setw(16) << method
+						<< std::right << std::fixed << std::setprecision(2) << std::setw(10) << ms
+						<< std::setw(10) << matches << std::endl;
+				};
+
+				std::size_t matches = 0;
+				double ms = time_ms([&] {
+					for (const Task* task : manager.list_tasks()) {
+						matches += task->get_description().find(needle) != std::string_view::npos;
+					}
+				});
+				row("naive find", ms, matches);
+
+				for (ScanKernel kernel : { ScanKernel::Scalar, ScanKernel::Sse2, ScanKernel::Avx2 }) {
+					if (!scan_kernel_supported(kernel)) {
+						continue;
+					}
+					SubstringMatcher matcher(needle, kernel);
+					matches = 0;
+					ms = time_ms([&] {
+						for (const Task* task : manager.list_tasks()) {
+							matches += matcher(task->get_description());
+						}
+					});
+					row(scan_kernel_name(kernel), ms, matches);
+				}
+
+				ms = time_ms([&] { matches = manager.filter_contains(needle).size(); });
+				row("filter_contains", ms, matches);
+			}
+		}
+		remove_store(path);
+	}
+	return 0;
+}
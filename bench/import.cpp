@@ -0,0 +1,66 @@
+// Measures importing tasks from JSON lines, CSV and TSV files: parsing
+// alone (ImportReader), and TaskManager::import_stream() into an empty store
+// including its single snapshot write. The files are written and read once
+// before timing, so they come from a warm page cache.
+#include <iostream>
+#include <iomanip>
+#include "bench_common.h"
+#include "task_manager.h"
+#include "ui.h"
+
+int main(int argc, char** argv) {
+	std::vector<std::size_t> sizes = bench_sizes(argc, argv, { 100000, 1000000 });
+
+	std::cout << std::left << std::setw(10) << "tasks" << std::setw(8) << "format" << std::setw(22) << "step"
+		<< std::right << std::setw(10) << "ms" << std::setw(14) << "tasks/s" << std::endl;
+
+	for (std::size_t count : sizes) {
+		std::string path = "bench_import_" + std::to_string(count) + ".json";
+		std::string data_path = "bench_import_" + std::to_string(count) + ".data";
+		write_json_store(path, count);
+		for (auto [name, style] : { std::pair{ "jsonl", RenderStyle::JsonLines },
+			std::pair{ "csv", RenderStyle::Csv }, std::pair{ "tsv", RenderStyle::Tsv } }) {
+			{
+				TaskManager source(path);
+				std::ofstream data(data_path, std::ios::binary);
+				export_tasks(source, data, style);
+			}
+			auto row = [&](const char* step, double ms) {
+				std::cout << std::left << std::setw(10) << count << std::setw(8) << name << std::setw(22) << step
+					<< std::right << std::fixed << std::setprecision(2) << std::setw(10) << ms
+					<< std::setw(14) << std::setprecision(0) << count / (ms / 1000) << std::endl;
+			};
+
+			std::size_t records = 0;
+			auto parse = [&] {
+				std::ifstream data(data_path, std::ios::binary);
+				ImportReader reader(data, ImportFormat::Auto);
+				ImportRecord record;
+				records = 0;
+				while (reader.next(record) != ImportReader::Result::End) {
+					records++;
+				}
+			};
+			parse();
+			row("parse", time_ms(parse));
+
+			for (const char* store : { "bench_import_store.json", "bench_import_store.bin" }) {
+				remove_store(store);
+				std::ofstream(store) << (std::string(store).ends_with(".bin") ? "" : "[]");
+				TaskManager manager(store);
+				std::ifstream data(data_path, std::ios::binary);
+				ImportResult result;
+				double ms = time_ms([&] { result = manager.import_stream(data); });
+				row(std::string(store).ends_with(".bin") ? "import+save (binary)" : "import+save (json)", ms);
+				if (result.imported != count || records != count) {
+					std::cerr << "imported " << result.imported << " of " << count << std::endl;
+					return 1;
+				}
+				remove_store(store);
+			}
+		}
+		std::remove(data_path.c_str());
+		remove_store(path);
+	}
+	return 0;
+}
@@ -0,0 +1,42 @@
+// Measures how JSON snapshot loading and JSON/binary snapshot saving scale
+// with TaskManagerOptions::threads. Thread counts above the number of cores
+// only add overhead.
+#include <iostream>
+#include <iomanip>
+#include <thread>
+#include "bench_common.h"
+#include "task_manager.h"
+
+int main(int argc, char** argv) {
+	std::vector<std::size_t> sizes = bench_sizes(argc, argv, { 100000, 1000000 });
+	const unsigned thread_counts[] = { 1, 2, 4, 8, 16 };
+
+	std::cout << "cores: " << std::thread::hardware_concurrency() << std::endl;
+	std::cout << std::left << std::setw(10) << "tasks" << std::setw(9) << "threads"
+		<< std::right << std::setw(14) << "json load ms" << std::setw(14) << "json save ms"
+		<< std::setw(14) << "bin save ms" << std::endl;
+
+	for (std::size_t count : sizes) {
+		std::string json_path = "bench_parallel_" + std::to_string(count) + ".json";
+		std::string bin_path = "bench_parallel_" + std::to_string(count) + ".bin";
+		write_json_store(json_path, count);
+
+		for (unsigned threads : thread_counts) {
+			TaskManagerOptions options;
+			options.threads = threads;
+			std::unique_ptr<TaskManager> manager;
+			double load = time_ms([&] { manager = std::make_unique<TaskManager>(json_path, options); });
+			// rewrites the same bytes, so every row loads the same file
+			double json_save = time_ms([&] { manager->compact(); });
+			double bin_save = time_ms([&] { manager->export_snapshot(bin_path); });
+
+			std::cout << std::left << std::setw(10) << count << std::setw(9) << threads << std::right
+				<< std::fixed << std::setprecision(1) << std::setw(14) << load << std::setw(14) << json_save
+				<< std::setw(14) << bin_save << std::endl;
+		}
+
+		remove_store(json_path);
+		remove_store(bin_path);
+	}
+	return 0;
+}
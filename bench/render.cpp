@@ -0,0 +1,67 @@
+// Compares listing output: the line-by-line writer print_task used before
+// (std::endl after every line, asctime(localtime()) per timestamp) against
+// print_tasks() in the detailed and table styles. Listings go to stdout and
+// timings to stderr, so run it against each kind of output:
+//   bench_render                      (terminal)
+//   bench_render | cat > /dev/null    (pipe)
+//   bench_render > /dev/null          (file)
+#include <ctime>
+#include <iostream>
+#include <iomanip>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "bench_common.h"
+#include "task_manager.h"
+#include "ui.h"
+
+static void print_legacy(const std::vector<const Task*>& tasks) {
+	for (const Task* task : tasks) {
+		std::cout << "-------------------------" << std::endl;
+		std::cout << "Task ID: " << task->get_id() << std::endl;
+		std::cout << "Description: " << task->get_description() << std::endl;
+		std::cout << "Status: " << status_to_string(task->get_status()) << std::endl;
+		std::time_t created_at = task->get_created_at();
+		std::time_t updated_at = task->get_updated_at();
+		std::cout << "Created At: " << std::asctime(std::localtime(&created_at));
+		std::cout << "Updated At: " << std::asctime(std::localtime(&updated_at));
+		std::cout << "-------------------------" << std::endl;
+		std::cout << "------------------------" << std::endl;
+	}
+}
+
+static const char* output_kind() {
+	struct stat info;
+	if (isatty(STDOUT_FILENO)) {
+		return "terminal";
+	}
+	if (fstat(STDOUT_FILENO, &info) == 0 && S_ISFIFO(info.st_mode)) {
+		return "pipe";
+	}
+	return "file";
+}
+
+int main(int argc, char** argv) {
+	std::vector<std::size_t> sizes = bench_sizes(argc, argv, { 10000, 100000 });
+
+	std::cerr << "stdout is a " << output_kind() << std::endl;
+	std::cerr << std::left << std::setw(10) << "tasks" << std::setw(16) << "method"
+		<< std::right << std::setw(10) << "ms" << std::endl;
+
+	for (std::size_t count : sizes) {
+		std::string path = "bench_render_" + std::to_string(count) + ".json";
+		write_json_store(path, count);
+		{
+			TaskManager manager(path);
+			std::vector<const Task*> tasks = manager.list_tasks();
+			auto row = [&](const char* method, double ms) {
+				std::cerr << std::left << std::setw(10) << count << std::setw(16) << method
+					<< std::right << std::fixed << std::setprecision(2) << std::setw(10) << ms << std::endl;
+			};
+			row("legacy", time_ms([&] { print_legacy(tasks); }));
+			row("detailed", time_ms([&] { print_tasks(tasks); }));
+			row("table", time_ms([&] { print_tasks(tasks, RenderStyle::Table); }));
+		}
+		remove_store(path);
+	}
+	return 0;
+}
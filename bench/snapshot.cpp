@@ -0,0 +1,65 @@
+// Compares load/save time and file size of the JSON and binary snapshot formats,
+// and of JSON and binary snapshots loaded through a memory mapping.
+#include <iostream>
+#include <iomanip>
+#include "bench_common.h"
+#include "task_manager.h"
+
+int main(int argc, char** argv) {
+	std::vector<std::size_t> sizes = bench_sizes(argc, argv, { 10000, 100000, 1000000 });
+
+	std::cout << std::left << std::setw(10) << "tasks" << std::setw(8) << "format"
+		<< std::right << std::setw(12) << "load ms" << std::setw(12) << "save ms"
+		<< std::setw(14) << "file bytes" << std::endl;
+
+	for (std::size_t count : sizes) {
+		std::string json_path = "bench_snapshot_" + std::to_string(count) + ".json";
+		std::string bin_path = "bench_snapshot_" + std::to_string(count) + ".bin";
+		write_json_store(json_path, count);
+
+		double json_load = 0, json_save = 0, bin_load = 0, bin_save = 0, mmap_load = 0, mmap_save = 0;
+		double json_mmap_load = 0, json_mmap_save = 0;
+		{
+			std::unique_ptr<TaskManager> manager;
+			json_load = time_ms([&] { manager = std::make_unique<TaskManager>(json_path); });
+			json_save = time_ms([&] { manager->compact(); });
+			manager->export_snapshot(bin_path);
+		}
+		{
+			std::unique_ptr<TaskManager> manager;
+			bin_load = time_ms([&] { manager = std::make_unique<TaskManager>(bin_path); });
+			bin_save = time_ms([&] { manager->compact(); });
+		}
+		{
+			TaskManagerOptions options;
+			options.memory_map = true;
+			std::unique_ptr<TaskManager> manager;
+			mmap_load = time_ms([&] { manager = std::make_unique<TaskManager>(bin_path, options); });
+			// includes copying every description out of the mapping
+			mmap_save = time_ms([&] { manager->compact(); });
+		}
+
+		{
+			TaskManagerOptions options;
+			options.memory_map = true;
+			std::unique_ptr<TaskManager> manager;
+			// only ids, statuses and timestamps are parsed; descriptions stay in the file
+			json_mmap_load = time_ms([&] { manager = std::make_unique<TaskManager>(json_path, options); });
+			json_mmap_save = time_ms([&] { manager->compact(); });
+		}
+
+		auto row = [count](const char* format, double load, double save, std::uintmax_t bytes) {
+			std::cout << std::left << std::setw(10) << count << std::setw(8) << format << std::right
+				<< std::fixed << std::setprecision(1) << std::setw(12) << load << std::setw(12) << save
+				<< std::setw(14) << bytes << std::endl;
+		};
+		row("json", json_load, json_save, std::filesystem::file_size(json_path));
+		row("binary", bin_load, bin_save, std::filesystem::file_size(bin_path));
+		row("mmap", mmap_load, mmap_save, std::filesystem::file_size(bin_path));
+		row("json-mm", json_mmap_load, json_mmap_save, std::filesystem::file_size(json_path));
+
+		remove_store(json_path);
+		remove_store(bin_path);
+	}
+	return 0;
+}
@@ -0,0 +1,48 @@
+// Measures the memory footprint of a loaded store and the cost of walking it.
+#include <iostream>
+#include <iomanip>
+#include "alloc_counter.h"
+#include "bench_common.h"
+#include "task_manager.h"
+
+int main(int argc, char** argv) {
+	std::vector<std::size_t> sizes = bench_sizes(argc, argv, { 100000, 1000000 });
+
+	std::cout << std::left << std::setw(10) << "tasks" << std::right << std::setw(12) << "load ms"
+		<< std::setw(12) << "heap MB" << std::setw(12) << "list ms" << std::setw(14) << "by-status ms"
+		<< std::setw(12) << "scan ms" << std::endl;
+
+	for (std::size_t count : sizes) {
+		std::string path = "bench_storage_" + std::to_string(count) + ".json";
+		write_json_store(path, count);
+		{
+			// Convert once so that loading measures the store, not the JSON parser
+			TaskManager converter(path);
+			converter.export_snapshot(path + ".bin");
+		}
+
+		AllocationStats before = allocation_stats();
+		std::unique_ptr<TaskManager> manager;
+		double load = time_ms([&] { manager = std::make_unique<TaskManager>(path + ".bin"); });
+		AllocationStats after = allocation_stats();
+
+		std::size_t listed = 0, in_progress = 0, bytes = 0;
+		double list = time_ms([&] { listed = manager->list_tasks().size(); });
+		double by_status = time_ms([&] { in_progress = manager->list_tasks(TaskStatus::IN_PROGRESS).size(); });
+		double scan = time_ms([&] {
+			for (const Task* task : manager->list_tasks()) {
+				bytes += task->get_description().size() + static_cast<std::size_t>(task->get_status() == TaskStatus::DONE);
+			}
+		});
+
+		std::cout << std::left << std::setw(10) << count << std::right << std::fixed << std::setprecision(1)
+			<< std::setw(12) << load << std::setw(12) << (after.live_bytes - before.live_bytes) / (1024.0 * 1024.0)
+			<< std::setw(12) << list << std::setw(14) << by_status << std::setw(12) << scan
+			<< "   (" << after.allocations - before.allocations << " allocations, " << listed << " listed, " << in_progress << " in progress, " << bytes << " bytes)" << std::endl;
+
+		manager.reset();
+		remove_store(path);
+		remove_store(path + ".bin");
+	}
+	return 0;
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Performs snapshot and journal writes on a background thread so that the
+// thread mutating the store never waits for the disk. Submitted work is
+// written in order and coalesced: records are gathered for up to `interval`
+// (or until `max_pending` are waiting) and written together, and a snapshot
+// supersedes every record and snapshot still waiting before it. Superseded
+// records are only dropped once the snapshot is written; if writing it
+// fails, they are appended to the journal instead, followed by the records
+// submitted after the snapshot.
+class BackgroundWriter {
+
+public:
+	// `fingerprint` is whatever was submitted with the snapshot.
+	using SnapshotWriter = std::function<void(const std::string& snapshot, std::uint64_t fingerprint)>;
+	using RecordWriter = std::function<void(const std::string& lines, std::size_t count)>;
+
+	BackgroundWriter(SnapshotWriter write_snapshot, RecordWriter write_records,
+		std::chrono::milliseconds interval, std::size_t max_pending);
+	~BackgroundWriter(); // flushes, then stops the thread
+
+	BackgroundWriter(const BackgroundWriter&) = delete; // Disable copy constructor
+	BackgroundWriter& operator=(const BackgroundWriter&) = delete; // Disable copy assignment
+
+	// `lines` holds `count` newline-terminated journal records.
+	// Both queue their work, then rethrow the first error the writer thread
+	// hit since one was last reported, so that a failed write surfaces on
+	// the next mutation rather than only at flush() or exit.
+	void submit_records(std::string lines, std::size_t count);
+	void submit_snapshot(std::string snapshot, std::uint64_t fingerprint);
+
+	// Blocks until everything submitted so far has been written. Rethrows the
+	// first error the writer thread hit since one was last reported.
+	void flush();
+
+private:
+	SnapshotWriter write_snapshot;
+	RecordWriter write_records;
+	std::chrono::milliseconds interval;
+	std::size_t max_pending;
+
+	std::mutex mutex;
+	std::condition_variable wake;    // signals the writer thread
+	std::condition_variable written; // signals flush()
+	bool has_snapshot = false;
+	std::string snapshot;
+	std::uint64_t snapshot_fingerprint = 0;
+	std::string lines;
+	std::size_t pending_records = 0;
+	// Records the waiting snapshot supersedes, written if the snapshot fails.
+	std::string superseded;
+	std::size_t superseded_records = 0;
+	std::uint64_t submitted = 0;     // submissions so far
+	std::uint64_t completed = 0;     // submissions written (or failed)
+	std::size_t flush_waiters = 0;
+	bool stopping = false;
+	std::exception_ptr error;
+
+	std::thread thread; // started last, once the members above exist
+
+	bool dirty() const { return has_snapshot || pending_records > 0; }
+	void report_error(std::unique_lock<std::mutex>& lock);
+	void run();
+};
@@ -0,0 +1,79 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+// The options of the task-tracker command line, in the order of the table
+// in command_line.cpp.
+enum class CommandOption {
+	List, Get, Add, Remove, Search, Update, RemoveLast, Clear, Begin, Commit, Rollback,
+	Desc, Status, Since, Until, By, Limit, After, Table, Format, Export, Import, RemapIds,
+	Script, Yes, Sort, Help
+};
+inline constexpr std::size_t command_option_count = static_cast<std::size_t>(CommandOption::Help) + 1;
+
+// The long name, e.g. "r-last" for RemoveLast.
+std::string_view option_name(CommandOption option);
+
+// A malformed command: unknown option, missing or invalid argument.
+class CommandLineError : public std::runtime_error {
+public:
+	using std::runtime_error::runtime_error;
+};
+
+// Splits a REPL line into tokens exactly as repeated `>> std::quoted(token)`
+// does: blanks separate tokens; a token starting with '"' runs to the next
+// unescaped '"', a backslash escaping the character after it; a quote left
+// open drops its token. Escapes are removed in place, so every token is a
+// view into the line and nothing is copied.
+class CommandLexer {
+
+public:
+	explicit CommandLexer(std::string& line) : line(line) {}
+
+	bool next(std::string_view& token);
+	// The token next() returns next, without consuming it.
+	bool peek(std::string_view& token);
+
+private:
+	bool lex(std::string_view& token);
+
+	std::string& line;
+	std::size_t at = 0;
+	std::optional<std::string_view> pending;
+};
+
+// The options of one command. Values are views into the parsed line or
+// argv, so they are valid only as long as that is.
+class ParsedCommand {
+
+public:
+	// How often the option was given; like cxxopts, the last value wins.
+	std::size_t count(CommandOption option) const { return counts[index(option)]; }
+	std::string_view value(CommandOption option) const { return values[index(option)]; }
+	// The value of an option that takes an integer, checked while parsing.
+	int integer(CommandOption option) const { return integers[index(option)]; }
+	// No options at all, which the CLI treats as --list.
+	bool empty() const { return options == 0; }
+
+private:
+	friend class CommandParser;
+	static std::size_t index(CommandOption option) { return static_cast<std::size_t>(option); }
+
+	std::array<std::size_t, command_option_count> counts{};
+	std::array<std::string_view, command_option_count> values{};
+	std::array<int, command_option_count> integers{};
+	std::size_t options = 0;
+};
+
+// Parse the syntax cxxopts accepts for these options: "--name", "--name value",
+// "--name=value", "-a value", "-avalue", grouped flags such as "-lc", and "--"
+// ending the options. Words that are not options are ignored, as cxxopts
+// leaves them unmatched. Option names are looked up in a perfect hash table
+// built at compile time. Throws CommandLineError.
+ParsedCommand parse_command(CommandLexer& lexer);
+// The process arguments; argv[0] is skipped.
+ParsedCommand parse_command(int argc, const char* const argv[]);
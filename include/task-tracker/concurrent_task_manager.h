@@ -0,0 +1,94 @@
+#pragma once
+#include <cstddef>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "task.h"
+#include "task_manager.h"
+
+// TaskManager that can be shared between threads. Readers (get, list, count)
+// hold a shared lock and run in parallel with each other; mutations take the
+// lock exclusively. Results are TaskData copies rather than Task pointers, so
+// they stay valid when another thread changes or removes the task.
+//
+// Mutations still write the journal under the lock; with
+// TaskManagerOptions::async_persistence that I/O moves to the background
+// writer and writers only hold the lock for the in-memory change.
+//
+// Shards of a sharded store are all read when it is opened and whenever it
+// is reloaded (lazy_shards is always turned off). Readers that share the lock
+// could not load them lazily; with every shard loaded, the const TaskManager
+// methods they call change nothing (see TaskManager::load_all_shards()).
+class ConcurrentTaskManager {
+
+public:
+	explicit ConcurrentTaskManager(const std::string& filename = "tasks.json", TaskManagerOptions options = TaskManagerOptions());
+
+	ConcurrentTaskManager(const ConcurrentTaskManager&) = delete; // Disable copy constructor
+	ConcurrentTaskManager& operator=(const ConcurrentTaskManager&) = delete; // Disable copy assignment
+
+	std::optional<TaskData> get_task(int id) const;
+	std::vector<TaskData> list_tasks() const;
+	std::vector<TaskData> list_tasks(TaskStatus statu) const;
+	// Sorting by time builds the time indexes under the exclusive lock on first use.
+	std::vector<TaskData> list_tasks(ListOrder order, std::size_t limit,
+		std::optional<TaskCursor> after = std::nullopt, std::optional<TaskStatus> statu = std::nullopt) const;
+	std::size_t count_tasks(TaskStatus statu) const;
+	bool IsEmpty() const;
+	// The first call builds the text index under the exclusive lock; later
+	// ones only need the shared lock.
+	std::vector<TaskData> search(std::string_view query) const;
+	std::vector<TaskData> filter_contains(std::string_view text) const;
+	// Builds the time indexes under the exclusive lock on first use, like search().
+	std::vector<TaskData> list_tasks_between(TimeField field, std::time_t from, std::time_t to) const;
+	// Taken under the shared lock; walking it needs no lock at all.
+	TaskSnapshot snapshot() const;
+
+	TaskData add_task(std::string_view description);
+	std::vector<TaskData> add_tasks(std::span<const std::string> descriptions);
+	bool remove_task(int id);
+	bool remove_last_task();
+	bool clear_all_tasks();
+	std::optional<TaskData> update_task_status(int id, std::string_view new_status);
+	std::optional<TaskData> update_task_description(int id, std::string_view new_description);
+	std::size_t update_status_bulk(std::span<const int> ids, TaskStatus status);
+	// Holds the exclusive lock while the whole stream is read.
+	ImportResult import_stream(std::istream& input, ImportOptions import_options = ImportOptions());
+
+	void compact();
+	void flush();
+	// Encodes and writes a snapshot, so writers only wait while it is taken.
+	void export_snapshot(const std::string& path, SnapshotFormat format = SnapshotFormat::Auto) const;
+
+	// Runs `fn(const TaskManager&)` under the shared lock, for readers that
+	// want to walk tasks in place instead of copying them. Pointers obtained
+	// inside must not be kept after `fn` returns. The const methods that build
+	// an index on first use (search(), list_tasks_between() and time-ordered
+	// list_tasks()) must go through this class's own versions instead.
+	template <typename Fn>
+	decltype(auto) read(Fn&& fn) const {
+		std::shared_lock<std::shared_mutex> lock(mutex);
+		return fn(static_cast<const TaskManager&>(manager));
+	}
+
+	// Runs `fn(TaskManager&)` under the exclusive lock, e.g. to apply several
+	// mutations atomically with a Transaction.
+	template <typename Fn>
+	decltype(auto) write(Fn&& fn) {
+		std::unique_lock<std::shared_mutex> lock(mutex);
+		return fn(manager);
+	}
+
+private:
+	mutable std::shared_mutex mutex;
+	TaskManager manager;
+	Durability durability;
+	unsigned threads;
+
+	static TaskManagerOptions eager_shards(TaskManagerOptions options);
+	static std::vector<TaskData> copy_tasks(const std::vector<const Task*>& tasks);
+};
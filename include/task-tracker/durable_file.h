@@ -0,0 +1,46 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// How far a write has to get before the call that made it returns.
+enum class Durability {
+	None,  // may stay in process buffers until they fill up or the file is closed
+	Flush, // handed to the OS: survives the process crashing or being killed
+	Fsync  // on the disk: also survives an OS crash or power loss
+};
+
+// Replaces `path` with `content` without ever exposing a partly written file:
+// the bytes go to `path + ".tmp"`, which is then renamed over `path`, so a
+// crash at any point leaves either the old or the new contents. With
+// Durability::Fsync the temp file is synced before the rename and the
+// directory after it. Throws std::runtime_error.
+void write_file_atomically(const std::string& path, std::string_view content, Durability durability);
+
+// Append-only file whose writes are buffered in memory until flush(), which
+// hands them to the OS, or sync(), which also waits for the disk.
+class AppendFile {
+
+public:
+	AppendFile() = default;
+	~AppendFile();
+
+	AppendFile(const AppendFile&) = delete; // Disable copy constructor
+	AppendFile& operator=(const AppendFile&) = delete; // Disable copy assignment
+
+	// Throws std::runtime_error when the file cannot be opened.
+	void open(const std::string& path, bool truncate);
+	bool is_open() const { return fd >= 0; }
+	void close();
+
+	void write(std::string_view bytes);
+	void flush();
+	void sync();
+
+private:
+	static constexpr std::size_t buffer_limit = 64 * 1024;
+
+	int fd = -1;
+	std::string path;
+	std::string buffer;
+};
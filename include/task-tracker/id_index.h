@@ -0,0 +1,41 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Open-addressing hash map from task id to slot. Entries are stored inline
+// (8 bytes each) with linear probing, so unlike std::unordered_map there is
+// no allocation per task; erase shifts later entries back instead of leaving
+// tombstones.
+class IdIndex {
+
+public:
+	IdIndex() = default;
+
+	// Returns the slot of `id`, or nullptr when it is not indexed.
+	std::uint32_t* find(int id);
+	const std::uint32_t* find(int id) const;
+
+	void insert_or_assign(int id, std::uint32_t slot);
+	bool erase(int id);
+	void clear();
+
+	std::size_t size() const { return count; }
+	bool empty() const { return count == 0; }
+
+private:
+	struct Entry {
+		int id;
+		std::uint32_t slot;
+	};
+	// Marks an empty entry; a task that really uses this id is kept aside
+	static constexpr int empty_id = -2147483647 - 1;
+
+	std::vector<Entry> entries; // size is zero or a power of two
+	std::size_t count = 0;
+	bool has_empty_id = false;
+	std::uint32_t empty_id_slot = 0;
+
+	std::size_t home(int id) const;
+	void grow();
+};
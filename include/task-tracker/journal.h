@@ -0,0 +1,77 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <istream>
+#include <string>
+#include <string_view>
+#include <nlohmann/json.hpp>
+#include "durable_file.h"
+
+// Append-only operation log kept next to the task snapshot.
+// Every line is one JSON record; the first line is a header naming the
+// snapshot (by fingerprint) that the records must be replayed on top of.
+// Version 1 headers, written before SnapshotFingerprint, named it by a hash
+// of the whole snapshot file.
+class Journal {
+
+public:
+	explicit Journal(std::string path, Durability durability = Durability::Flush);
+	~Journal();
+
+	Journal(const Journal&) = delete; // Disable copy constructor
+	Journal& operator=(const Journal&) = delete; // Disable copy assignment
+
+	// Feeds every record to `apply`. Returns false (and applies nothing) when the
+	// journal is missing or was written against a different snapshot. A last
+	// line without its newline is a torn write and is cut off; any other record
+	// that fails to parse or apply throws std::runtime_error and leaves the
+	// file as it is.
+	// A version 1 journal is compared with `legacy_fingerprint()` instead and,
+	// once replayed, rewritten with a current header.
+	bool replay(std::uint64_t snapshot_fingerprint, const std::function<std::uint64_t()>& legacy_fingerprint,
+		const std::function<void(const nlohmann::json&)>& apply);
+
+	// Drops all records and starts a new journal for the given snapshot.
+	void reset(std::uint64_t snapshot_fingerprint);
+
+	// Each append is made as durable as the journal's Durability level asks.
+	void append(const nlohmann::json& record);
+	// Writes `count` records that were already serialized, one per line.
+	void append_lines(std::string_view lines, std::size_t count);
+
+	// While a batch is open, append() only buffers records in memory;
+	// commit_batch() writes them all with a single flush and discard_batch()
+	// forgets them.
+	void begin_batch();
+	void commit_batch();
+	void discard_batch();
+	// Closes the batch and hands its records over instead of writing them.
+	std::string take_batch();
+	bool in_batch() const { return batching; }
+	std::size_t pending() const { return pending_records; }
+	// The records buffered so far, one per line.
+	std::string_view batch_lines() const { return batch; }
+
+	// Pushes buffered records out, for Durability::None.
+	void flush();
+
+	std::size_t size() const { return records; }
+	const std::string& get_path() const { return path; }
+
+	static std::uint64_t fingerprint(std::string_view bytes);
+	static std::uint64_t fingerprint(std::istream& input); // reads to the end
+
+private:
+	std::string path;
+	Durability durability;
+	AppendFile out;
+	std::size_t records = 0;
+	bool batching = false;
+	std::string batch;
+	std::size_t pending_records = 0;
+
+	void open_for_append();
+	void finish_write();
+	std::string header_line(std::uint64_t snapshot_fingerprint) const;
+	[[noreturn]] void damaged(std::size_t line_number, const std::string& reason) const;
+};
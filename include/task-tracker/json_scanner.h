@@ -0,0 +1,199 @@
+#pragma once
+#include <cctype>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string_view>
+
+// Cursor over JSON text for the hand-written readers of task records
+// (scan_json_snapshot, JSON-lines import). Every method returns false at
+// input it does not expect.
+class JsonScanner {
+
+public:
+	explicit JsonScanner(std::string_view text) : at(text.data()), end(text.data() + text.size()) {}
+
+	bool consume(char c) {
+		skip_space();
+		if (at == end || *at != c) {
+			return false;
+		}
+		at++;
+		return true;
+	}
+
+	bool finished() {
+		skip_space();
+		return at == end;
+	}
+
+	// Where the next token starts.
+	const char* position() {
+		skip_space();
+		return at;
+	}
+
+	void seek(const char* to) { at = to; }
+
+	// `raw` views the bytes between the quotes.
+	bool string(std::string_view& raw, bool& escaped) {
+		if (!consume('"')) {
+			return false;
+		}
+		const char* begin = at;
+		escaped = false;
+		bool ascii = true;
+		while (at != end && *at != '"') {
+			unsigned char c = static_cast<unsigned char>(*at);
+			if (c < 0x20) {
+				return false;
+			}
+			if (c == '\\') {
+				escaped = true;
+				at++;
+				if (at == end) {
+					return false;
+				}
+			}
+			ascii = ascii && c < 0x80;
+			at++;
+		}
+		if (at == end) {
+			return false;
+		}
+		raw = std::string_view(begin, static_cast<std::size_t>(at - begin));
+		at++;
+		// Saving goes through nlohmann::json, which rejects invalid UTF-8
+		return ascii || valid_utf8(raw);
+	}
+
+	bool integer(std::int64_t& value) {
+		skip_space();
+		bool negative = at != end && *at == '-';
+		if (negative) {
+			at++;
+		}
+		if (at == end || *at < '0' || *at > '9') {
+			return false;
+		}
+		std::uint64_t magnitude = 0;
+		while (at != end && *at >= '0' && *at <= '9') {
+			if (magnitude > (std::numeric_limits<std::uint64_t>::max() - 9) / 10) {
+				return false;
+			}
+			magnitude = magnitude * 10 + static_cast<std::uint64_t>(*at - '0');
+			at++;
+		}
+		if (at != end && (*at == '.' || *at == 'e' || *at == 'E')) {
+			return false;
+		}
+		if (magnitude > static_cast<std::uint64_t>(std::numeric_limits<std::int64_t>::max())) {
+			return false;
+		}
+		value = negative ? -static_cast<std::int64_t>(magnitude) : static_cast<std::int64_t>(magnitude);
+		return true;
+	}
+
+	bool skip_value(int depth = 0) {
+		skip_space();
+		if (at == end || depth > 64) {
+			return false;
+		}
+		std::string_view raw;
+		bool escaped = false;
+		switch (*at) {
+		case '"':
+			return string(raw, escaped);
+		case '{':
+			at++;
+			if (consume('}')) {
+				return true;
+			}
+			do {
+				if (!string(raw, escaped) || !consume(':') || !skip_value(depth + 1)) {
+					return false;
+				}
+			} while (consume(','));
+			return consume('}');
+		case '[':
+			at++;
+			if (consume(']')) {
+				return true;
+			}
+			do {
+				if (!skip_value(depth + 1)) {
+					return false;
+				}
+			} while (consume(','));
+			return consume(']');
+		case 't':
+			return literal("true");
+		case 'f':
+			return literal("false");
+		case 'n':
+			return literal("null");
+		default:
+			return number();
+		}
+	}
+
+	// Whether `text` is well-formed UTF-8 (RFC 3629): no overlong forms, no
+	// surrogates and nothing above U+10FFFF. Also used for text that does not
+	// come through the scanner, such as CSV and TSV fields.
+	static bool valid_utf8(std::string_view text) {
+		std::size_t i = 0;
+		while (i < text.size()) {
+			unsigned char c = static_cast<unsigned char>(text[i]);
+			if (c < 0x80) {
+				i++;
+				continue;
+			}
+			// C0, C1 and F5..FF only start overlong or out-of-range sequences.
+			std::size_t length = c < 0xc2 ? 0 : c < 0xe0 ? 2 : c < 0xf0 ? 3 : c < 0xf5 ? 4 : 0;
+			if (length == 0 || i + length > text.size()) {
+				return false;
+			}
+			// The second byte's range depends on the lead for E0, ED, F0 and F4.
+			unsigned char second = static_cast<unsigned char>(text[i + 1]);
+			unsigned char low = c == 0xe0 ? 0xa0 : c == 0xf0 ? 0x90 : 0x80;
+			unsigned char high = c == 0xed ? 0x9f : c == 0xf4 ? 0x8f : 0xbf;
+			if (second < low || second > high) {
+				return false;
+			}
+			for (std::size_t k = 2; k < length; k++) {
+				if ((static_cast<unsigned char>(text[i + k]) >> 6) != 0x2) {
+					return false;
+				}
+			}
+			i += length;
+		}
+		return true;
+	}
+
+private:
+	const char* at;
+	const char* end;
+
+	void skip_space() {
+		while (at != end && (*at == ' ' || *at == '\n' || *at == '\r' || *at == '\t')) {
+			at++;
+		}
+	}
+
+	bool literal(std::string_view word) {
+		if (static_cast<std::size_t>(end - at) < word.size() || std::string_view(at, word.size()) != word) {
+			return false;
+		}
+		at += word.size();
+		return true;
+	}
+
+	bool number() {
+		const char* begin = at;
+		while (at != end && (std::isdigit(static_cast<unsigned char>(*at)) || *at == '-' || *at == '+'
+			|| *at == '.' || *at == 'e' || *at == 'E')) {
+			at++;
+		}
+		return at != begin;
+	}
+};
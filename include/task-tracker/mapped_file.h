@@ -0,0 +1,26 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// Read-only memory mapping of a whole file. Pages are faulted in by the OS
+// on first access, so untouched parts of the file cost no memory.
+class MappedFile {
+
+public:
+	explicit MappedFile(const std::string& path); // throws std::runtime_error
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete; // Disable copy constructor
+	MappedFile& operator=(const MappedFile&) = delete; // Disable copy assignment
+
+	std::string_view view() const { return std::string_view(data, length); }
+
+private:
+	const char* data = nullptr;
+	std::size_t length = 0;
+#ifdef _WIN32
+	void* file_handle = nullptr;
+	void* mapping_handle = nullptr;
+#endif
+};
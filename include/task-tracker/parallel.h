@@ -0,0 +1,18 @@
+#pragma once
+#include <cstddef>
+#include <functional>
+
+// Number of threads to use for a `threads` setting of 0 (one per core) or more.
+unsigned resolve_threads(unsigned threads);
+
+// Splits [0, count) into contiguous ranges of at least `min_chunk` items, at
+// most one per thread, and runs `fn(begin, end)` on each: the calling thread
+// takes the first range and a thread is started for each of the others.
+// Range `chunk` covers the items just before those of range chunk + 1, so
+// per-range results can be merged in item order. Every range has finished
+// when it returns; the first exception thrown by `fn` is rethrown.
+void parallel_for(std::size_t count, unsigned threads, std::size_t min_chunk,
+	const std::function<void(std::size_t chunk, std::size_t begin, std::size_t end)>& fn);
+
+// Number of ranges parallel_for() splits `count` items into.
+std::size_t parallel_chunks(std::size_t count, unsigned threads, std::size_t min_chunk);
@@ -0,0 +1,100 @@
+#pragma once
+#include <cstddef>
+#include <ctime>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "task.h"
+
+enum class RenderStyle {
+	Detailed,  // the multi-line block print_task has always written
+	Table,     // one line per task, under a header
+	JsonLines, // one JSON object per line, with the snapshot's field names
+	Csv,       // RFC 4180, under a header; times are Unix timestamps
+	Tsv        // like Csv, with \t \n \r and \\ escaped instead of quoting
+};
+
+// Accepts "text", "table", "jsonl", "csv" and "tsv".
+bool parse_render_style(std::string_view name, RenderStyle& style);
+// Detailed and Table are for people; the others print nothing but records.
+inline bool is_human_readable(RenderStyle style) {
+	return style == RenderStyle::Detailed || style == RenderStyle::Table;
+}
+
+// Formats local times without calling std::localtime for every value. The
+// broken-down time of the last local hour seen is kept, and times within
+// that hour are derived from it. UTC offsets do not only change on whole
+// hours (Lord Howe Island shifts by 30 minutes, and historical offsets have
+// odd minutes), so an hour is only cached after checking that its first and
+// last second have the same offset as the time that filled it; an hour
+// with a change in it is not cached. Not thread-safe: each renderer owns
+// one.
+class TimestampCache {
+
+public:
+	// Same text as std::asctime, e.g. "Sun Jan  1 10:00:00 2023\n".
+	void append_asctime(std::string& out, std::time_t time);
+	// "2023-01-01 10:00".
+	void append_short(std::string& out, std::time_t time);
+
+	std::size_t misses() const { return miss_count; }
+
+private:
+	const std::tm& local(std::time_t time);
+
+	bool valid = false;
+	std::time_t hour_start = 0;
+	std::tm hour_tm{};
+	std::tm current{};
+	std::size_t miss_count = 0;
+};
+
+// Renders tasks into a reusable buffer that is written out with one call per
+// batch instead of a flush per line. Each thread should use its own renderer
+// (the print_* functions keep one per thread); writes to the same stream from
+// several renderers are serialized, so batches do not interleave.
+class TaskRenderer {
+
+public:
+	// Buffered output beyond this is written out while rendering, which keeps
+	// memory bounded for long listings.
+	static constexpr std::size_t flush_threshold = 64 * 1024;
+
+	explicit TaskRenderer(RenderStyle style = RenderStyle::Detailed) : style(style) {}
+
+	RenderStyle get_style() const { return style; }
+	void set_style(RenderStyle new_style) { style = new_style; }
+
+	// Appends one task in the current style; a null task renders as
+	// "Task is null.".
+	void append(const Task* task);
+	// The column names of Table, Csv and Tsv; nothing for the other styles.
+	void append_header();
+	// Appends a task as an entry of a listing (with the separator
+	// print_tasks writes after detailed entries), and writes to `out` when
+	// the buffer is full. A listing is streamed as append_header(), one
+	// append_listed() per task and write().
+	void append_listed(const Task* task, std::ostream& out);
+	// A whole listing; an empty one says so unless the style is machine
+	// readable.
+	void append_tasks(const std::vector<const Task*>& tasks, std::ostream& out);
+	void append_line(std::string_view line);
+
+	std::string_view view() const { return buffer; }
+	// Writes the buffer with a single call and empties it, keeping its
+	// capacity for the next batch.
+	void write(std::ostream& out);
+	void clear() { buffer.clear(); }
+
+private:
+	void append_detailed(const Task& task);
+	void append_row(const Task& task);
+	void append_record(const Task& task);
+	void append_field(std::string_view text);
+	void append_padded(std::string_view text, std::size_t width);
+
+	RenderStyle style;
+	std::string buffer;
+	TimestampCache times;
+};
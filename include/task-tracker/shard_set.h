@@ -0,0 +1,72 @@
+#pragma once
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <string_view>
+
+// Layout of a sharded store: tasks are split by id into shards of
+// `shard_size` consecutive ids, and each non-empty shard is an ordinary task
+// snapshot in its own file next to the manifest. The manifest (a one-line
+// JSON object at the store's path) lists those shards with their task count
+// per status, so counting does not have to read them.
+//
+// The manifest is rewritten after the shard files it lists. A crash in
+// between leaves the old manifest and journal, and replaying the journal
+// (whose records carry full task states) over the newer shard files gives
+// the same tasks.
+class ShardSet {
+
+public:
+	struct Shard {
+		bool listed = false; // has a file named in the manifest
+		bool loaded = false; // its tasks are in the TaskManager
+		bool dirty = false;  // changed since the manifest was written
+		std::array<std::size_t, 3> counts{}; // tasks per status, as listed
+	};
+
+	ShardSet() = default;
+	ShardSet(std::string manifest_path, std::size_t shard_size);
+
+	bool enabled() const { return shard_size > 0; }
+	std::size_t get_shard_size() const { return shard_size; }
+
+	// Shards are numbered by floor(id / shard_size), so negative ids work too.
+	std::int64_t shard_of(int id) const;
+	std::string path(std::int64_t index) const;
+
+	// Creates an empty, unlisted shard when needed, so it is for mutations
+	// only. find() never creates one: a shard that is not there has no tasks.
+	Shard& at(std::int64_t index) { return shards[index]; }
+	const Shard* find(std::int64_t index) const {
+		auto found = shards.find(index);
+		return found == shards.end() ? nullptr : &found->second;
+	}
+	Shard* find(std::int64_t index) {
+		auto found = shards.find(index);
+		return found == shards.end() ? nullptr : &found->second;
+	}
+	const std::map<std::int64_t, Shard>& all() const { return shards; }
+	std::map<std::int64_t, Shard>& all() { return shards; }
+
+	// Whether every listed shard is loaded.
+	bool all_loaded() const;
+	// Tasks in listed shards that are not loaded yet.
+	std::size_t unloaded_count() const;
+	std::size_t unloaded_count(std::size_t status_slot) const;
+
+	// Reads `path` into `manifest` if it holds a shard manifest.
+	static bool read_manifest(const std::string& path, std::string& manifest);
+	// Throws std::runtime_error on a malformed manifest.
+	void decode(std::string_view manifest, int& next_id);
+	// Bumps the generation, so that every manifest (and the journal that
+	// names it by fingerprint) differs from the ones before it.
+	std::string encode(int next_id);
+
+private:
+	std::string manifest_path;
+	std::size_t shard_size = 0;
+	std::uint64_t generation = 0;
+	std::map<std::int64_t, Shard> shards;
+};
@@ -0,0 +1,112 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <istream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "task.h"
+
+enum class SnapshotFormat {
+	Auto,   // pick by file extension (see format_for_path)
+	Json,
+	Binary
+};
+
+// Binary snapshot layout (all integers little-endian):
+//
+//   header  : magic "TTSB", u32 version, u64 task count, i64 next_id, u64 blob size
+//   records : one fixed-width record per task
+//             i32 id, u8 status, 3 bytes padding, i64 created_at, i64 updated_at,
+//             u64 description offset, u32 description length, u32 reserved
+//   blob    : description bytes, back to back
+namespace binary_snapshot {
+	constexpr char magic[4] = { 'T', 'T', 'S', 'B' };
+	constexpr std::uint32_t version = 1;
+	constexpr std::size_t header_size = 32;
+	constexpr std::size_t record_size = 40;
+}
+
+// One decoded record. When `in_place` is set, `description` views the
+// snapshot bytes; otherwise it is only valid during the callback.
+struct SnapshotRecord {
+	int id;
+	TaskStatus status;
+	std::time_t created_at;
+	std::time_t updated_at;
+	std::string_view description;
+	bool in_place = true;
+};
+
+// Names a snapshot in the journal header. It is computed from what loading
+// decodes anyway (the number of tasks and each task's id, status, times and
+// description length, in order) and never from description text, so a
+// mapped snapshot's description pages are not read at load. The same tasks
+// give the same value in either format.
+class SnapshotFingerprint {
+
+public:
+	void add(const SnapshotRecord& record) {
+		add(record.id, record.status, record.created_at, record.updated_at, record.description.size());
+	}
+	void add(const Task& task) {
+		add(task.get_id(), task.get_status(), task.get_created_at(), task.get_updated_at(), task.get_description().size());
+	}
+	std::uint64_t value() const;
+
+private:
+	void add(int id, TaskStatus status, std::time_t created_at, std::time_t updated_at, std::size_t length);
+	void mix(std::uint64_t word);
+
+	std::uint64_t hash = 14695981039346656037ull;
+	std::uint64_t count = 0;
+};
+
+std::uint64_t snapshot_fingerprint(const std::vector<const Task*>& tasks);
+
+// ".bin" and ".tdb" files use the binary format, everything else JSON.
+SnapshotFormat format_for_path(const std::string& path);
+
+bool is_binary_snapshot(std::string_view bytes);
+
+// Appends `text` as a JSON string literal, escaped as nlohmann::json does.
+void append_json_string(std::string& out, std::string_view text);
+
+// The encoders split large task lists into chunks that are written on up to
+// `threads` threads (0: one per core); the output does not depend on it.
+// The JSON encoder writes what nlohmann::json::dump(4) would.
+std::string encode_binary_snapshot(int next_id, const std::vector<const Task*>& tasks, unsigned threads = 1);
+std::string encode_json_snapshot(int next_id, const std::vector<const Task*>& tasks, unsigned threads = 1);
+// Picks one of the above; `format` must not be Auto.
+std::string encode_snapshot(SnapshotFormat format, int next_id, const std::vector<const Task*>& tasks,
+	unsigned threads = 1);
+
+// Throws std::runtime_error when the snapshot is truncated or inconsistent.
+void decode_binary_snapshot(std::string_view bytes, int& next_id,
+	const std::function<void(const SnapshotRecord&)>& emit);
+
+// Streams a tasks.json snapshot and emits each task as soon as its record has
+// been read, without building a DOM. Malformed records are described through
+// `report` and skipped. A syntax error stops the load (the tasks emitted so far
+// are kept) and makes the function return false.
+bool decode_json_snapshot(std::istream& input, int& next_id,
+	const std::function<void(const SnapshotRecord&)>& emit,
+	const std::function<void(const std::string&)>& report);
+bool decode_json_snapshot(std::string_view bytes, int& next_id,
+	const std::function<void(const SnapshotRecord&)>& emit,
+	const std::function<void(const std::string&)>& report);
+
+// Fast path for a tasks.json snapshot that is kept in memory (e.g. mapped):
+// only ids, statuses and timestamps are decoded, and a description without
+// escape sequences is emitted in place, as the bytes between its quotes, so
+// its text is not copied. Every byte is still read, to find the closing
+// quote and to check that the text is UTF-8.
+// Returns false, possibly after emitting some records, at anything it does
+// not expect (e.g. a malformed record); decode_json_snapshot then has to
+// read the snapshot instead, and reports the problem.
+//
+// With `threads` other than 1, a large tasks array is scanned in chunks on
+// that many threads (0: one per core); records are still emitted in order,
+// on the calling thread, once every chunk has been scanned.
+bool scan_json_snapshot(std::string_view bytes, int& next_id,
+	const std::function<void(const SnapshotRecord&)>& emit, unsigned threads = 1);
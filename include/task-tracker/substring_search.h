@@ -0,0 +1,35 @@
+#pragma once
+#include <string>
+#include <string_view>
+
+// Instruction sets SubstringMatcher can search with.
+enum class ScanKernel {
+	Scalar, // std::string_view::find
+	Sse2,   // 16 bytes per step
+	Avx2    // 32 bytes per step
+};
+
+// The widest kernel this CPU (and OS) supports, detected once.
+ScanKernel best_scan_kernel();
+bool scan_kernel_supported(ScanKernel kernel);
+const char* scan_kernel_name(ScanKernel kernel);
+
+// Case-sensitive substring test for many texts against one needle. The SIMD
+// kernels compare a block of text with the needle's first byte and the block
+// `needle.size() - 1` bytes further on with its last byte, and only compare
+// the rest of the needle where both match; that pair rarely matches by
+// chance, so most blocks cost two loads and compares.
+class SubstringMatcher {
+
+public:
+	// A kernel the CPU does not support is replaced by best_scan_kernel().
+	explicit SubstringMatcher(std::string_view needle, ScanKernel kernel = best_scan_kernel());
+
+	bool operator()(std::string_view text) const;
+	ScanKernel kernel() const { return used; }
+
+private:
+	std::string needle;
+	ScanKernel used;
+	bool (*search)(std::string_view text, std::string_view needle);
+};
@@ -1,15 +1,32 @@
 #pragma once
+#include <cstdint>
+#include <memory>
 #include <string>
+#include <string_view>
 #include <ctime>
+#include <limits>
 #include <stdexcept>
 
-enum class TaskStatus {
+enum class TaskStatus : std::uint8_t {
 	TO_DO,
 	IN_PROGRESS,
 	DONE
 };
 
-// ַתΪTaskStatusöֵ
+// 任务 ID 从 1 到 INT_MAX - 1, 这样任何任务之后的下一个 ID 仍然是 int
+inline bool valid_task_id(std::int64_t id) {
+	return id >= 1 && id < std::numeric_limits<int>::max();
+}
+
+// 将字符串转换为TaskStatus枚举值, 无效时返回 false 而不抛出异常
+inline bool parse_status(std::string_view s, TaskStatus& status) {
+	if (s == "IN_PROGRESS") { status = TaskStatus::IN_PROGRESS; return true; }
+	if (s == "DONE") { status = TaskStatus::DONE; return true; }
+	if (s == "TO_DO") { status = TaskStatus::TO_DO; return true; }
+	return false;
+}
+
+// 将字符串转换为TaskStatus枚举值
 inline TaskStatus string_to_status(const std::string& s) {
 	if (s == "IN_PROGRESS") return TaskStatus::IN_PROGRESS;
 	if (s == "DONE") return TaskStatus::DONE;
@@ -17,7 +34,7 @@ inline TaskStatus string_to_status(const std::string& s) {
 	throw std::invalid_argument("Invalid status string");
 }
 
-// TaskStatusöֵתΪַ
+// 将TaskStatus枚举值转换为字符串
 inline std::string status_to_string(TaskStatus status) {
 	switch (status) {
 	case TaskStatus::TO_DO: return "TO_DO";
@@ -30,29 +47,64 @@ inline std::string status_to_string(TaskStatus status) {
 class Task {
 
 public:
-	Task(int id, const std::string description);
-	Task(int id, const std::string description, TaskStatus statu, std::time_t creat, std::time_t update);
+	Task(int id, std::string_view description);
+	Task(int id, std::string_view description, TaskStatus statu, std::time_t creat, std::time_t update);
 	~Task();
 
 	Task(const Task&) = delete; // Disable copy constructor
 	Task& operator=(const Task&) = delete; // Disable copy assignment
 
 
-	void update_status(const std::string); // Update task status
-	void update_description(const std::string); // Update task description
+	void update_status(std::string_view); // Update task status
+	void update_status(TaskStatus);
+	void update_description(std::string_view); // Update task description
+
+	// 描述直接引用别处的字节 (例如内存映射的快照) 而不复制;
+	// 这些字节必须比任务活得久, 否则先用 own_description() 复制一份
+	void borrow_description(std::string_view text);
+	void own_description();
+	bool owns_description() const { return !borrowed; }
 
-	// --- Getters (Ϊ) ---
+	// --- Getters (为测试添加) ---
 	const int& get_id() const { return id; }
-	const std::string& get_description() const { return description; }
+	std::string_view get_description() const { return description; }
 	TaskStatus get_status() const { return status; }
 	std::time_t get_created_at() const { return created_at; }
 	std::time_t get_updated_at() const { return updated_at; }
+	// 最后一次写入任务时 TaskManager 的 epoch (见 TaskManager::snapshot)
+	std::uint64_t get_version() const { return version; }
 
 private:
-	int id;
-	std::string description;
-	TaskStatus status;
+	friend class TaskStore;
+	friend class TaskManager;
+
+	// 指向 owned_description 或 TaskStore 保管的内存;
+	// borrowed 为 true 时指向的内存可能比任务先释放
+	std::string_view description;
+	std::unique_ptr<char[]> owned_description;
 
 	std::time_t created_at;
 	std::time_t updated_at;
+	std::uint64_t version = 0;
+
+	int id;
+	TaskStatus status;
+	bool borrowed = false;
+
+	void assign_owned(std::string_view text);
+};
+
+// 任务状态的副本; 与 Task* 不同, 之后存储怎么变化它都有效
+struct TaskData {
+	int id = 0;
+	std::string description;
+	TaskStatus status = TaskStatus::TO_DO;
+	std::time_t created_at = 0;
+	std::time_t updated_at = 0;
+
+	TaskData() = default;
+	explicit TaskData(const Task& task)
+		: id(task.get_id()), description(task.get_description()), status(task.get_status()),
+		created_at(task.get_created_at()), updated_at(task.get_updated_at()) {
+	}
 };
\ No newline at end of file
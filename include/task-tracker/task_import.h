@@ -0,0 +1,92 @@
+#pragma once
+#include <cstddef>
+#include <ctime>
+#include <istream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "task.h"
+
+enum class ImportFormat {
+	Auto,      // '{' first means JSON lines, a tab in the first line TSV, else CSV
+	JsonLines, // one task object per line, with the snapshot's field names
+	Csv,       // RFC 4180 with a header line naming the columns
+	Tsv        // a header line, tabs between fields, \t \n \r \\ escaped
+};
+
+// What TaskManager::import_stream() does with the ids in the input.
+enum class ImportIds {
+	Preserve, // keep them; records whose id is taken are rejected
+	Remap     // number the records from next_id, in input order
+};
+
+struct ImportOptions {
+	ImportFormat format = ImportFormat::Auto;
+	ImportIds ids = ImportIds::Preserve;
+};
+
+struct ImportResult {
+	std::size_t imported = 0;
+	std::size_t rejected = 0;
+	// Lines on which the first rejected records start (at most max_reported).
+	std::vector<std::size_t> rejected_lines;
+	static constexpr std::size_t max_reported = 10;
+
+	void reject(std::size_t line) {
+		if (rejected++ < max_reported) {
+			rejected_lines.push_back(line);
+		}
+	}
+};
+
+// One task read from an import file. Only the description is required:
+// a missing id is assigned from next_id, a missing status is TO_DO and
+// missing times are the time of the import.
+struct ImportRecord {
+	std::optional<int> id; // 1 to INT_MAX - 1; a record with any other id is rejected
+	std::string_view description; // valid until the next call to next()
+	TaskStatus status = TaskStatus::TO_DO;
+	std::optional<std::time_t> created_at;
+	std::optional<std::time_t> updated_at;
+};
+
+// Reads ImportRecords from a stream a block at a time, so memory stays
+// bounded by the longest record rather than the file. Descriptions without
+// escapes or quotes are viewed in the block instead of copied; statuses are
+// checked with parse_status, so a bad record costs no exception.
+class ImportReader {
+
+public:
+	enum class Result { Record, Rejected, End };
+
+	// Throws std::runtime_error when a CSV or TSV header has no
+	// "description" column.
+	ImportReader(std::istream& input, ImportFormat format);
+
+	Result next(ImportRecord& record);
+	// Line on which the record last returned by next() starts.
+	std::size_t line() const { return record_line; }
+	ImportFormat get_format() const { return format; }
+
+private:
+	enum Column { Id, Description, Status, CreatedAt, UpdatedAt, Ignored };
+	static constexpr std::size_t block_size = 1 << 20;
+
+	bool next_line(std::string_view& text);
+	bool fill();
+	void read_header();
+	bool parse_json(std::string_view text, ImportRecord& record);
+	bool parse_delimited(std::string_view text, ImportRecord& record);
+	bool parse_field(Column column, std::string_view value, ImportRecord& record);
+
+	std::istream& input;
+	ImportFormat format;
+	std::string buffer;
+	std::size_t at = 0;
+	bool exhausted = false;
+	std::size_t line_number = 0;
+	std::size_t record_line = 0;
+	std::vector<Column> columns;
+	std::string decoded; // the current description when it had to be unescaped
+};
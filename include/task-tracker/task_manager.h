@@ -1,40 +1,252 @@
 #include <vector>
 #include <fstream>
 #include <memory>
+#include <memory_resource>
+#include <set>
+#include <span>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <optional>
 #include <ctime>
 #include "task.h"
+#include "journal.h"
+#include "snapshot.h"
+#include "mapped_file.h"
+#include "task_store.h"
+#include "id_index.h"
+#include "background_writer.h"
+#include "durable_file.h"
+#include "task_snapshot.h"
+#include "shard_set.h"
+#include "text_index.h"
+#include "substring_search.h"
+#include "task_import.h"
 #include <nlohmann/json.hpp>
 #pragma once
 
+// Timestamp that list_tasks_between() selects on.
+enum class TimeField {
+	Created,
+	Updated
+};
+
+// Order of a paged listing (see TaskManager::list_tasks(ListOrder, ...)).
+enum class SortKey {
+	Id,
+	Created,
+	Updated
+};
+
+struct ListOrder {
+	SortKey key = SortKey::Id;
+	bool descending = false;
+};
+
+// Where a page of a sorted listing ends: the sort key of its last task, so
+// the next page starts right after it even if tasks were added or removed
+// in between. `time` is unused when sorting by id.
+struct TaskCursor {
+	std::time_t time = 0;
+	int id = 0;
+
+	static TaskCursor after(const Task& task, SortKey key) {
+		std::time_t time = key == SortKey::Created ? task.get_created_at()
+			: key == SortKey::Updated ? task.get_updated_at() : 0;
+		return TaskCursor{ time, task.get_id() };
+	}
+};
+
+struct TaskManagerOptions {
+	// Format used when writing the snapshot; loading accepts both formats.
+	SnapshotFormat format = SnapshotFormat::Auto;
+	// Map the snapshot instead of reading it. For a binary snapshot only ids,
+	// statuses and timestamps are decoded up front, and the journal names the
+	// snapshot by those (see SnapshotFingerprint); descriptions stay in the
+	// mapping (so the OS reads their pages on first use, and may drop them
+	// again under memory pressure) until a task is modified or the snapshot
+	// is rewritten. A JSON snapshot has to be scanned through, so it is only
+	// read from the mapping and its descriptions are copied at load.
+	bool memory_map = false;
+	// Where task chunks, description blocks and index nodes are allocated
+	// from, e.g. a std::pmr::monotonic_buffer_resource for a short-lived
+	// read-only manager. Must outlive the TaskManager.
+	std::pmr::memory_resource* memory = std::pmr::get_default_resource();
+	// Write the journal and snapshots on a background thread. Records are
+	// gathered for up to `flush_interval`, or until `flush_records` are
+	// waiting, and written together; flush() and the destructor wait for
+	// them. A crash loses at most what was not yet written. A failed
+	// background write is rethrown by the next mutation (after it has been
+	// applied and queued) or by flush().
+	bool async_persistence = false;
+	std::chrono::milliseconds flush_interval{ 100 };
+	std::size_t flush_records = 1024;
+	// How far the journal and snapshot writes must get before returning.
+	// Snapshots are always replaced atomically (temp file + rename).
+	Durability durability = Durability::Flush;
+	// Split the store into shard files of `shard_size` consecutive ids,
+	// listed in a manifest at the store's path (see ShardSet). Compaction
+	// rewrites only the shards changed since the last one, and a shard is read
+	// on first access to one of its ids. An existing single-file store is
+	// converted when opened; an existing manifest keeps its own shard size,
+	// whatever this says. Shards are read into memory even with memory_map.
+	std::size_t shard_size = 0;
+	// Read every shard when the store is opened instead.
+	bool lazy_shards = true;
+	// Threads used to scan a JSON snapshot and to encode snapshots of large
+	// stores (0: one per core). The tasks themselves are still created and
+	// indexed on the calling thread, in snapshot order.
+	unsigned threads = 1;
+};
+
 class TaskManager {
 
 public:
-	TaskManager(const std::string filename = "tasks.json");
+	TaskManager(const std::string filename = "tasks.json", TaskManagerOptions options = TaskManagerOptions());
 	~TaskManager();
 
 	TaskManager(const TaskManager&) = delete; // Disable copy constructor
 	TaskManager& operator=(const TaskManager&) = delete; // Disable copy assignment
 
-	Task* add_task(std::string description);
+	Task* add_task(std::string_view description);
 	bool remove_task(int id);
 	bool remove_last_task();
 	bool clear_all_tasks();
 	Task* get_task(int id);
+	const Task* get_task(int id) const;
+
+	Task* update_task_status(int id, std::string_view new_status);
+	Task* update_task_description(int id, std::string_view new_description);
+
+	std::vector<const Task*> list_tasks() const;
+	std::vector<const Task*> list_tasks(TaskStatus statu) const;
+
+	// Calls fn(const Task&) for every task in list_tasks() order, or for the
+	// tasks in status `statu` in id order, without building a list. `fn` must
+	// not change the manager.
+	template <typename Fn>
+	void for_each_task(Fn&& fn) const {
+		load_all_shards();
+		for (const Task* task : tasks) {
+			if (task) {
+				fn(*task);
+			}
+		}
+	}
+	template <typename Fn>
+	void for_each_task(TaskStatus statu, Fn&& fn) const {
+		load_all_shards();
+		for (int id : by_status[status_slot(statu)]) {
+			fn(*tasks[*slots.find(id)]);
+		}
+	}
+
+	// Tasks whose description contains every word of `query`, in id order;
+	// a word ending in '*' is a prefix (see TextIndex). The first search reads
+	// every description to build the index (so with memory_map it reads all
+	// of them in); from then on mutations keep it up to date and a search
+	// costs about as much as its results. Since the first call changes the
+	// manager, ConcurrentTaskManager readers must use its own search().
+	std::vector<const Task*> search(std::string_view query) const;
+	bool has_text_index() const { return text_indexed; }
+
+	// Up to `limit` tasks in `order` (ties broken by id), starting after
+	// `after` and optionally only those in status `statu`. Walks the status
+	// or time indexes from the cursor, so a page costs O(log N + limit)
+	// (plus skipped tasks of other statuses when sorting by time) and no list
+	// of every task is built. Sorting by time builds the time indexes on the
+	// first call, as list_tasks_between() does.
+	std::vector<const Task*> list_tasks(ListOrder order, std::size_t limit,
+		std::optional<TaskCursor> after = std::nullopt, std::optional<TaskStatus> statu = std::nullopt) const;
+
+	// Tasks whose `field` lies in [from, to], ordered by it (then by id).
+	// Answered from sorted indexes in O(log N + matches); like the text
+	// index, they are built by the first call and then kept up to date, so
+	// ConcurrentTaskManager readers must use its own list_tasks_between().
+	std::vector<const Task*> list_tasks_between(TimeField field, std::time_t from, std::time_t to) const;
+	bool has_time_index() const { return time_indexed; }
+
+	// Tasks whose description contains `text` (case-sensitive), in list
+	// order. Unlike search() this needs no index: every description is scanned
+	// with SubstringMatcher, split over `threads` threads for large stores.
+	std::vector<const Task*> filter_contains(std::string_view text) const;
 
-	Task* update_task_status(int id, std::string new_status);
-	Task* update_task_description(int id, const std::string new_description);
+	// Returns an immutable view of the current tasks in O(N / TaskOrder::block_size):
+	// the view shares the task list's blocks and the tasks themselves instead
+	// of copying them. While a snapshot is alive, a task it can see is not
+	// changed in place: updating it installs a new Task (so Task pointers
+	// obtained before see the old state), and removed tasks are kept until
+	// the last snapshot that sees them is gone. Taking a snapshot only reads
+	// the manager, so ConcurrentTaskManager does it under the shared lock
+	// and the snapshot can then be walked without holding any lock.
+	//
+	// With memory_map, a snapshot keeps the mapped file open; on Windows the
+	// snapshot file cannot be rewritten until such snapshots are dropped.
+	TaskSnapshot snapshot() const;
 
-	std::vector<const Task*> list_tasks();
-	std::vector<const Task*> list_tasks(TaskStatus statu);
+	// Mutations between begin_batch() and commit() are applied in memory only
+	// and persisted together at commit, with a single journal write (or one
+	// snapshot rewrite when the batch is large). rollback() drops them by
+	// reloading the last committed state, which invalidates Task pointers
+	// obtained before. Batches nest; only the outermost
+	// commit() persists, and rollback() abandons the whole batch.
+	void begin_batch();
+	void commit();
+	void rollback();
+	bool in_batch() const { return batch_depth > 0; }
+	// How many batches are open.
+	int batch_level() const { return batch_depth; }
+	// Abandons only what changed since the batch at `level` (1 being the
+	// outermost) was begun, closing it and the batches inside it. The
+	// batches around it stay open with their changes. rollback() is
+	// rollback_to(1); both reload, invalidating Task pointers.
+	void rollback_to(int level);
+
+	// Each runs as one batch.
+	std::vector<Task*> add_tasks(std::span<const std::string> descriptions);
+	std::size_t update_status_bulk(std::span<const int> ids, TaskStatus status); // returns the number of tasks found
+
+	// Adds the tasks read from `input` (see ImportReader), rejecting records
+	// that do not parse or, with ImportIds::Preserve, whose id is taken.
+	// The tasks are persisted once at the end: as one journal batch, or by
+	// rewriting the snapshot when they outnumber the rest of the store, so
+	// that no journal records are built for them. Inside a batch they join
+	// it. Throws std::runtime_error (before adding anything) when a CSV or
+	// TSV header has no description column.
+	ImportResult import_stream(std::istream& input, ImportOptions import_options = ImportOptions());
+
+	std::size_t count_tasks(TaskStatus statu) const {
+		// Shards that are not loaded yet are counted from the manifest
+		return by_status[status_slot(statu)].size() + shards.unloaded_count(status_slot(statu));
+	}
+
+	// Folds the journal back into a fresh snapshot of the whole store.
+	void compact();
+
+	// Returns once every committed change has been written (a no-op unless
+	// async_persistence is on). Rethrows a failed background write.
+	void flush();
+
+	// Writes the current store to `path` (e.g. JSON export of a binary store).
+	void export_snapshot(const std::string& path, SnapshotFormat format = SnapshotFormat::Auto) const;
+
+	// Reads every shard that is not loaded yet. Read-only methods load the
+	// shards they need on their own: that does not change what the store
+	// holds, but it does change the manager, so with lazy_shards a const
+	// TaskManager must not be read from several threads at once. Once every
+	// shard is loaded, read-only methods change nothing (an id outside every
+	// shard is looked up without creating one).
+	void load_all_shards() const;
 
 	bool IsEmpty() const {
-		return tasks.empty();
+		return slots.empty() && shards.unloaded_count() == 0;
 	}
 
 	int get_last_id() const {
+		load_all_shards();
 		int last_id = 0;
 		for (const auto& task:tasks){
-			if (task->get_id() > last_id){
+			if (task && task->get_id() > last_id){
 				last_id = task->get_id();
 			}
 		}
@@ -42,12 +254,118 @@ public:
 	}
 
 private:
-	std::vector<std::unique_ptr<Task>> tasks;
+	// Declared before `store` so that it is unmapped only after the tasks
+	// borrowing from it are gone.
+	std::shared_ptr<MappedFile> mapping;
+	TaskStore store;
+
+	// Tasks in insertion order. Removed tasks leave a null tombstone behind so
+	// that `slots` (id -> index into `tasks`) stays valid; tombstones are
+	// reclaimed once they outnumber the live tasks.
+	TaskOrder tasks;
+	IdIndex slots;
+	std::size_t tombstones = 0;
+	// Ids of the tasks in each status, so filtered listing is O(matching).
+	// Status changes must go through TaskManager to keep this in sync.
+	// The set nodes come from a pool rather than one allocation each.
+	std::pmr::unsynchronized_pool_resource index_nodes;
+	std::array<std::pmr::set<int>, 3> by_status;
+	// Built by the first search(); kept in sync with the tasks after that.
+	mutable TextIndex words;
+	mutable bool text_indexed = false;
+	// (time, id) of every task per TimeField, built by the first
+	// list_tasks_between(); nodes come from `index_nodes` like by_status.
+	using TimeIndex = std::pmr::set<std::pair<std::time_t, int>>;
+	mutable std::array<TimeIndex, 2> by_time;
+	mutable bool time_indexed = false;
+	static std::size_t status_slot(TaskStatus statu) {
+		return static_cast<std::size_t>(statu);
+	}
 	std::string filename;
+	TaskManagerOptions options;
 	int next_id = 1;
 
+	// Mutations are appended here and only folded into `filename` once the
+	// journal outgrows the store (see min_journal_records).
+	Journal journal;
+	static constexpr std::size_t min_journal_records = 1024;
+	static constexpr std::size_t min_filter_chunk = 16384; // tasks per filter_contains() thread
+	std::size_t unsaved_records = 0; // journal records since the last snapshot
+	// With async_persistence the journal and snapshot file are only written
+	// from this writer's thread. Declared after `journal` so that it stops
+	// (and flushes) first.
+	std::unique_ptr<BackgroundWriter> writer;
+	int batch_depth = 0;
+	// Per open batch, how many bytes of journal records came before it.
+	std::vector<std::size_t> batch_starts;
+	ShardSet shards; // disabled unless the store is sharded
+
+	// Tasks are stamped with the epoch in which they were last written, and
+	// snapshot() closes the current epoch. A task stamped at or before the
+	// newest live snapshot may be seen by it and is copied rather than changed;
+	// replaced and removed tasks wait in `retired` (with the epoch they left
+	// in) until no live snapshot is that old.
+	std::shared_ptr<SnapshotRegistry> snapshots = std::make_shared<SnapshotRegistry>();
+	mutable std::atomic<std::uint64_t> epoch{ 1 };
+	std::vector<std::pair<std::uint64_t, Task*>> retired;
+
 	void ensure_file_exists(const std::string filename);
 	void save_to_file();
+	void write_snapshot(const std::string& content, std::uint64_t fingerprint);
 	void load_from_file(std::string filename);
+	// false when damaged
+	bool load_binary_snapshot(std::string_view bytes, const std::function<void(const SnapshotRecord&)>& emit);
+	void keep_damaged_snapshot(const std::string& path);
+	void add_snapshot_task(const SnapshotRecord& record);
+	SnapshotFormat snapshot_format() const;
+	void release_mapping();
+
+	Task* insert_task(Task* task);
+	bool erase_task(int id);
+	void reclaim_tombstones();
+	void clear_store();
+	void reindex_status(int id, TaskStatus old_status, TaskStatus new_status);
+	void index_times(const Task& task) const;
+	void unindex_times(const Task& task);
+	void reindex_updated(int id, std::time_t old_updated, std::time_t new_updated);
+	void build_time_index() const;
+
+	bool seen_by_snapshot(const Task* task) const;
+	Task* writable_task(std::uint32_t slot);
+	Task* find_writable(int id);
+	void discard_task(Task* task);
+	void collect_retired();
+
+	void load_shard(std::int64_t index, ShardSet::Shard& shard);
+	void load_shard_of(int id) const;
+	void touch_shard(int id); // loads it and marks it for the next save
+	void clear_shards();
+	void save_shards();
+	void sort_by_id();
+
+	void log_update(const Task& task, const char* op);
+	void log_remove(int id);
+	void append_record(const nlohmann::json& record);
+	void apply_journal_record(const nlohmann::json& record);
+	void maybe_compact();
 };
 
+// Opens a batch on construction. Unless commit() is called, the batch is
+// rolled back when the transaction goes out of scope, e.g. on an exception;
+// batches it was opened in keep their changes.
+class Transaction {
+
+public:
+	explicit Transaction(TaskManager& manager);
+	~Transaction();
+
+	Transaction(const Transaction&) = delete; // Disable copy constructor
+	Transaction& operator=(const Transaction&) = delete; // Disable copy assignment
+
+	void commit();
+
+private:
+	TaskManager& manager;
+	int level = 0;
+	bool open = true;
+};
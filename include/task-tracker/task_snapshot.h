@@ -0,0 +1,144 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+#include "task.h"
+#include "snapshot.h"
+#include "mapped_file.h"
+#include "durable_file.h"
+
+// Task pointers in insertion order (null for a removed task), kept in
+// fixed-size blocks. Copies share their blocks; a block still held by another
+// copy is copied before it is written, so copying a TaskOrder costs one
+// pointer per block rather than one per task.
+class TaskOrder {
+
+public:
+	static constexpr std::size_t block_size = 256;
+
+	std::size_t size() const { return count; }
+	bool empty() const { return count == 0; }
+	Task* operator[](std::size_t index) const {
+		return (*blocks[index / block_size])[index % block_size];
+	}
+	Task* back() const { return (*this)[count - 1]; }
+
+	void set(std::size_t index, Task* task);
+	void push_back(Task* task);
+	void pop_back();
+	void clear();
+	// Drops the null entries, keeping the order of the others.
+	void remove_nulls();
+
+	class const_iterator {
+
+	public:
+		using iterator_category = std::forward_iterator_tag;
+		using value_type = Task*;
+		using difference_type = std::ptrdiff_t;
+		using pointer = Task* const*;
+		using reference = Task*;
+
+		const_iterator() = default;
+		const_iterator(const TaskOrder* order, std::size_t index) : order(order), index(index) {}
+
+		Task* operator*() const { return (*order)[index]; }
+		const_iterator& operator++() { index++; return *this; }
+		const_iterator operator++(int) { const_iterator old = *this; index++; return old; }
+		bool operator==(const const_iterator& other) const { return index == other.index; }
+		bool operator!=(const const_iterator& other) const { return index != other.index; }
+
+	private:
+		const TaskOrder* order = nullptr;
+		std::size_t index = 0;
+	};
+
+	const_iterator begin() const { return const_iterator(this, 0); }
+	const_iterator end() const { return const_iterator(this, count); }
+
+private:
+	using Block = std::array<Task*, block_size>;
+
+	std::vector<std::shared_ptr<Block>> blocks;
+	std::size_t count = 0;
+
+	Block& writable(std::size_t block);
+};
+
+// Versions of the snapshots that are still alive. Shared by a TaskManager and
+// its snapshots, so a snapshot may be dropped on any thread.
+class SnapshotRegistry {
+
+public:
+	void acquire(std::uint64_t version);
+	void release(std::uint64_t version);
+
+	bool empty() const { return live.load(std::memory_order_acquire) == 0; }
+	// Both return 0 when no snapshot is alive.
+	std::uint64_t oldest() const;
+	std::uint64_t newest() const;
+
+private:
+	mutable std::mutex mutex;
+	std::multiset<std::uint64_t> versions;
+	std::atomic<std::size_t> live{ 0 };
+};
+
+// Immutable point-in-time view of a TaskManager, see TaskManager::snapshot().
+// Copies are cheap and share the same view. The tasks stay unchanged however
+// the manager is modified afterwards, but belong to the manager's store: a
+// snapshot must not outlive its TaskManager.
+class TaskSnapshot {
+
+public:
+	// Number of tasks in the view.
+	std::size_t size() const { return state->size; }
+	bool empty() const { return state->size == 0; }
+	int next_id() const { return state->next_id; }
+	std::uint64_t version() const { return state->version; }
+
+	// Calls `fn(const Task&)` for every task, in insertion order.
+	template <typename Fn>
+	void for_each(Fn&& fn) const {
+		for (const Task* task : state->order) {
+			if (task) {
+				fn(*task);
+			}
+		}
+	}
+
+	std::vector<const Task*> list_tasks() const;
+	// Unlike TaskManager, these scan the whole view.
+	std::vector<const Task*> list_tasks(TaskStatus statu) const;
+	std::size_t count_tasks(TaskStatus statu) const;
+	const Task* get_task(int id) const;
+
+	void export_snapshot(const std::string& path, SnapshotFormat format = SnapshotFormat::Auto,
+		Durability durability = Durability::Flush, unsigned threads = 1) const;
+
+private:
+	friend class TaskManager;
+
+	struct State {
+		TaskOrder order;
+		std::size_t size = 0;
+		int next_id = 1;
+		std::uint64_t version = 0;
+		std::shared_ptr<SnapshotRegistry> registry;
+		// Keeps borrowed descriptions readable after the manager unmaps.
+		std::shared_ptr<const MappedFile> mapping;
+
+		~State() { registry->release(version); }
+	};
+
+	explicit TaskSnapshot(std::shared_ptr<const State> state) : state(std::move(state)) {}
+
+	std::shared_ptr<const State> state;
+};
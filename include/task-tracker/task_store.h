@@ -0,0 +1,100 @@
+#pragma once
+#include <cstddef>
+#include <ctime>
+#include <memory_resource>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "task.h"
+
+// Arena for description bytes: texts are copied into large blocks instead of
+// one heap allocation per description. Released texts go onto free lists by
+// size class (multiples of 8 bytes) and are handed out again by store().
+class StringPool {
+
+public:
+	explicit StringPool(std::pmr::memory_resource* memory = std::pmr::get_default_resource());
+	~StringPool();
+
+	StringPool(const StringPool&) = delete; // Disable copy constructor
+	StringPool& operator=(const StringPool&) = delete; // Disable copy assignment
+
+	// Copies `text` into the pool; the view stays valid until it is released
+	// or the pool is cleared.
+	std::string_view store(std::string_view text);
+	// Gives back a view returned by store().
+	void release(std::string_view text);
+	void clear();
+
+	std::size_t bytes_reserved() const { return reserved; }
+	std::size_t bytes_used() const { return used; }
+
+private:
+	static constexpr std::size_t block_size = 64 * 1024;
+	static constexpr std::size_t granularity = 8;
+	// Larger texts are allocated on their own and returned on release
+	static constexpr std::size_t max_pooled = block_size / 4;
+
+	std::pmr::memory_resource* memory;
+	std::vector<char*> blocks;
+	std::size_t block_used = block_size;
+	std::unordered_map<const char*, std::size_t> large; // bytes -> size
+	// Head of an intrusive list per size class; the link is kept in the
+	// first bytes of each free entry.
+	std::vector<char*> free_lists;
+	std::size_t reserved = 0;
+	std::size_t used = 0;
+
+	static std::size_t rounded(std::size_t size) {
+		return (size + granularity - 1) / granularity * granularity;
+	}
+};
+
+// Owns the tasks of a TaskManager. Tasks are constructed in place inside
+// fixed-size chunks, so walking them touches contiguous memory and there is
+// no heap allocation per task; chunks never move, so a Task* stays valid until
+// that task is destroyed. Descriptions live in a StringPool. All memory comes
+// from `memory`, which defaults to the global heap.
+class TaskStore {
+
+public:
+	explicit TaskStore(std::pmr::memory_resource* memory = std::pmr::get_default_resource());
+	~TaskStore();
+
+	TaskStore(const TaskStore&) = delete; // Disable copy constructor
+	TaskStore& operator=(const TaskStore&) = delete; // Disable copy assignment
+
+	// Copies the description into the pool.
+	Task* create(int id, std::string_view description, TaskStatus status, std::time_t created_at, std::time_t updated_at);
+	// Leaves the description where it is (see Task::borrow_description).
+	Task* create_borrowed(int id, std::string_view description, TaskStatus status, std::time_t created_at, std::time_t updated_at);
+	// Returns the slot and a pooled description for reuse.
+	void destroy(Task* task);
+	void clear();
+
+	// Replaces the description with a pooled copy of `description`.
+	void update_description(Task* task, std::string_view description);
+	// Moves a borrowed description into the pool.
+	void own_description(Task* task);
+
+	std::size_t size() const { return live; }
+	std::size_t bytes_reserved() const;
+	const StringPool& descriptions() const { return strings; }
+
+private:
+	struct Slot {
+		alignas(Task) unsigned char bytes[sizeof(Task)];
+	};
+	static constexpr std::size_t chunk_size = 1024;
+
+	std::pmr::memory_resource* memory;
+	std::vector<Slot*> chunks;
+	std::size_t chunk_used = chunk_size;
+	std::vector<Slot*> free_slots;
+	std::size_t live = 0;
+	StringPool strings;
+
+	Slot* allocate_slot();
+	// True when the description of `task` was stored in `strings`
+	static bool pooled(const Task* task);
+};
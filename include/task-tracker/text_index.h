@@ -0,0 +1,58 @@
+#pragma once
+#include <cstddef>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Inverted index from description words to the ids of the tasks using them.
+// A word is a run of ASCII letters and digits, lower-cased, or of non-ASCII
+// bytes (so UTF-8 text between spaces and punctuation is one word). Posting
+// lists are sorted vectors; ids are added in increasing order when tasks are
+// created, so keeping them sorted is O(1) in the common case.
+class TextIndex {
+
+public:
+	TextIndex() = default;
+
+	void add(int id, std::string_view description);
+	void remove(int id, std::string_view description);
+	void clear() { postings.clear(); }
+
+	// Ids of the tasks whose description has every word of `query`, in
+	// increasing order. A word ending in '*' matches any word it starts.
+	// Costs O(matches of the rarest word * log) plus the size of the posting
+	// lists merged for prefix words, whatever the number of tasks.
+	std::vector<int> search(std::string_view query) const;
+
+	std::size_t word_count() const { return postings.size(); }
+
+	// Calls `fn(word, end)` for each word of `text`, repeated words included,
+	// where text[end] is the byte just after the word (end may be the size).
+	template <typename Fn>
+	static void for_each_word(std::string_view text, Fn&& fn);
+
+private:
+	std::map<std::string, std::vector<int>, std::less<>> postings;
+
+	static bool is_word_byte(unsigned char c) {
+		return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c >= 0x80;
+	}
+	static std::vector<std::string> unique_words(std::string_view text);
+	std::vector<int> prefix_postings(std::string_view prefix) const;
+};
+
+template <typename Fn>
+void TextIndex::for_each_word(std::string_view text, Fn&& fn) {
+	std::string word;
+	for (std::size_t i = 0; i <= text.size(); i++) {
+		unsigned char c = i < text.size() ? static_cast<unsigned char>(text[i]) : 0;
+		if (is_word_byte(c)) {
+			word.push_back(c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : static_cast<char>(c));
+		}
+		else if (!word.empty()) {
+			fn(std::string_view(word), i);
+			word.clear();
+		}
+	}
+}
@@ -1,14 +1,22 @@
 #pragma once
 
 #include <iostream>
+#include <optional>
 #include <vector>
+#include "renderer.h"
 #include "task.h"
+#include "task_manager.h"
 
 void print_task(const Task* task);
-void print_tasks(const std::vector<const Task*>& tasks); 
+void print_tasks(const std::vector<const Task*>& tasks, RenderStyle style = RenderStyle::Detailed);
 void print_added_task(const Task* task);
-void print_get_task(const Task* task);
+void print_get_task(const Task* task, RenderStyle style = RenderStyle::Detailed);
 void print_removed_task(const int& id, bool success);
 void print_removed_last_task(int& id, bool success);
 void print_cleared_all_tasks(bool success);
-void print_updated_task(const Task* task);
\ No newline at end of file
+void print_updated_task(const Task* task);
+
+// Streams the tasks (or those in status `statu`) to `out` in `style`, a
+// buffer at a time, and returns how many were written.
+std::size_t export_tasks(const TaskManager& manager, std::ostream& out, RenderStyle style,
+	std::optional<TaskStatus> statu = std::nullopt);
@@ -0,0 +1,139 @@
+#include "background_writer.h"
+#include <iostream>
+
+BackgroundWriter::BackgroundWriter(SnapshotWriter write_snapshot, RecordWriter write_records,
+	std::chrono::milliseconds interval, std::size_t max_pending)
+	: write_snapshot(std::move(write_snapshot)), write_records(std::move(write_records)),
+	interval(interval), max_pending(max_pending), thread(&BackgroundWriter::run, this) {
+}
+
+BackgroundWriter::~BackgroundWriter() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	wake.notify_one();
+	thread.join();
+	if (error) {
+		try {
+			std::rethrow_exception(error);
+		}
+		catch (const std::exception& e) {
+			std::cerr << "Background write failed: " << e.what() << std::endl;
+		}
+	}
+}
+
+void BackgroundWriter::submit_records(std::string new_lines, std::size_t count) {
+	std::unique_lock<std::mutex> lock(mutex);
+	if (lines.empty()) {
+		lines = std::move(new_lines);
+	}
+	else {
+		lines += new_lines;
+	}
+	pending_records += count;
+	submitted++;
+	if (pending_records == count || pending_records >= max_pending) {
+		wake.notify_one();
+	}
+	report_error(lock);
+}
+
+void BackgroundWriter::submit_snapshot(std::string new_snapshot, std::uint64_t fingerprint) {
+	std::unique_lock<std::mutex> lock(mutex);
+	// The snapshot already contains everything still waiting to be written,
+	// but those records are the fallback until it is on disk
+	snapshot = std::move(new_snapshot);
+	snapshot_fingerprint = fingerprint;
+	has_snapshot = true;
+	superseded += lines;
+	superseded_records += pending_records;
+	lines.clear();
+	pending_records = 0;
+	submitted++;
+	wake.notify_one();
+	report_error(lock);
+}
+
+void BackgroundWriter::flush() {
+	std::unique_lock<std::mutex> lock(mutex);
+	std::uint64_t target = submitted;
+	flush_waiters++;
+	wake.notify_one();
+	written.wait(lock, [&] { return completed >= target; });
+	flush_waiters--;
+	report_error(lock);
+}
+
+void BackgroundWriter::report_error(std::unique_lock<std::mutex>& lock) {
+	if (error) {
+		std::exception_ptr failure = error;
+		error = nullptr;
+		lock.unlock();
+		std::rethrow_exception(failure);
+	}
+}
+
+void BackgroundWriter::run() {
+	std::unique_lock<std::mutex> lock(mutex);
+	while (true) {
+		wake.wait(lock, [&] { return stopping || dirty(); });
+		if (!dirty()) {
+			break; // stopping with nothing left to write
+		}
+		if (!stopping && flush_waiters == 0) {
+			// Give later mutations a chance to join this write
+			wake.wait_for(lock, interval, [&] {
+				return stopping || flush_waiters > 0 || pending_records >= max_pending;
+			});
+		}
+
+		bool take_snapshot = has_snapshot;
+		std::string snapshot_bytes = std::move(snapshot);
+		std::uint64_t fingerprint = snapshot_fingerprint;
+		std::string fallback_lines = std::move(superseded);
+		std::size_t fallback_count = superseded_records;
+		std::string record_lines = std::move(lines);
+		std::size_t record_count = pending_records;
+		std::uint64_t batch_end = submitted;
+		has_snapshot = false;
+		snapshot.clear();
+		superseded.clear();
+		superseded_records = 0;
+		lines.clear();
+		pending_records = 0;
+		lock.unlock();
+
+		std::exception_ptr failure;
+		if (take_snapshot) {
+			try {
+				write_snapshot(snapshot_bytes, fingerprint);
+			}
+			catch (...) {
+				// The old snapshot and journal are still in place; the
+				// superseded records bring the journal up to date
+				failure = std::current_exception();
+				record_lines.insert(0, fallback_lines);
+				record_count += fallback_count;
+			}
+		}
+		try {
+			if (record_count > 0) {
+				write_records(record_lines, record_count);
+			}
+		}
+		catch (...) {
+			if (!failure) {
+				failure = std::current_exception();
+			}
+		}
+
+		lock.lock();
+		if (failure && !error) {
+			error = failure;
+		}
+		completed = batch_end;
+		written.notify_all();
+	}
+}
@@ -0,0 +1,283 @@
+#include "command_line.h"
+#include <charconv>
+#include <cstdint>
+
+namespace {
+
+enum class ValueKind { Flag, Integer, Text };
+
+struct OptionSpec {
+	std::string_view name;
+	char short_name; // 0 when there is none
+	ValueKind kind;
+};
+
+// Indexed by CommandOption.
+constexpr std::array<OptionSpec, command_option_count> option_specs = { {
+	{ "list", 'l', ValueKind::Flag },
+	{ "get", 'g', ValueKind::Integer },
+	{ "add", 'a', ValueKind::Text },
+	{ "remove", 'r', ValueKind::Integer },
+	{ "search", 0, ValueKind::Text },
+	{ "update", 'u', ValueKind::Integer },
+	{ "r-last", 0, ValueKind::Flag },
+	{ "clear", 'c', ValueKind::Flag },
+	{ "begin", 0, ValueKind::Flag },
+	{ "commit", 0, ValueKind::Flag },
+	{ "rollback", 0, ValueKind::Flag },
+	{ "desc", 'd', ValueKind::Text },
+	{ "status", 's', ValueKind::Text },
+	{ "since", 0, ValueKind::Text },
+	{ "until", 0, ValueKind::Text },
+	{ "by", 0, ValueKind::Text },
+	{ "limit", 0, ValueKind::Integer },
+	{ "after", 0, ValueKind::Text },
+	{ "table", 0, ValueKind::Flag },
+	{ "format", 0, ValueKind::Text },
+	{ "export", 0, ValueKind::Text },
+	{ "import", 0, ValueKind::Text },
+	{ "remap-ids", 0, ValueKind::Flag },
+	{ "script", 0, ValueKind::Text },
+	{ "yes", 0, ValueKind::Flag },
+	{ "sort", 0, ValueKind::Text },
+	{ "help", 'h', ValueKind::Flag },
+} };
+
+// The perfect hash: the first and last character and the length of a name,
+// mixed with a seed chosen at compile time so that no two names share a
+// slot. A lookup is a few multiplications and one comparison.
+constexpr unsigned slot_bits = 6;
+constexpr std::size_t slot_count = std::size_t(1) << slot_bits;
+static_assert(command_option_count <= slot_count);
+
+constexpr std::uint32_t name_hash(std::string_view name, std::uint32_t seed) {
+	std::uint32_t key = static_cast<unsigned char>(name.front())
+		| static_cast<std::uint32_t>(static_cast<unsigned char>(name.back())) << 8
+		| static_cast<std::uint32_t>(name.size()) << 16;
+	std::uint32_t hash = (key ^ seed) * 0x9E3779B1u;
+	hash ^= hash >> 15;
+	hash *= 0x85EBCA6Bu;
+	return hash >> (32 - slot_bits);
+}
+
+constexpr std::uint32_t find_seed() {
+	for (std::uint32_t seed = 1; seed < 10000; seed++) {
+		std::array<bool, slot_count> taken{};
+		bool collision = false;
+		for (const OptionSpec& spec : option_specs) {
+			std::uint32_t slot = name_hash(spec.name, seed);
+			collision = collision || taken[slot];
+			taken[slot] = true;
+		}
+		if (!collision) {
+			return seed;
+		}
+	}
+	return 0;
+}
+
+constexpr std::uint32_t name_seed = find_seed();
+static_assert(name_seed != 0, "no perfect hash seed for the option names");
+
+// Option index + 1 per slot, 0 for an empty slot.
+constexpr std::array<std::uint8_t, slot_count> name_slots = [] {
+	std::array<std::uint8_t, slot_count> slots{};
+	for (std::size_t i = 0; i < option_specs.size(); i++) {
+		slots[name_hash(option_specs[i].name, name_seed)] = static_cast<std::uint8_t>(i + 1);
+	}
+	return slots;
+}();
+
+// Option index + 1 per ASCII character, 0 when no option has that letter.
+constexpr std::array<std::uint8_t, 128> short_slots = [] {
+	std::array<std::uint8_t, 128> slots{};
+	for (std::size_t i = 0; i < option_specs.size(); i++) {
+		if (option_specs[i].short_name) {
+			slots[static_cast<unsigned char>(option_specs[i].short_name)] = static_cast<std::uint8_t>(i + 1);
+		}
+	}
+	return slots;
+}();
+
+const OptionSpec* find_long(std::string_view name) {
+	if (name.empty()) {
+		return nullptr;
+	}
+	std::uint8_t entry = name_slots[name_hash(name, name_seed)];
+	return entry && option_specs[entry - 1].name == name ? &option_specs[entry - 1] : nullptr;
+}
+
+const OptionSpec* find_short(char name) {
+	unsigned char c = static_cast<unsigned char>(name);
+	return c < short_slots.size() && short_slots[c] ? &option_specs[short_slots[c] - 1] : nullptr;
+}
+
+bool is_blank(char c) {
+	return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r';
+}
+
+// Adapts the two token sources to one interface for CommandParser.
+class ArgvTokens {
+public:
+	ArgvTokens(int argc, const char* const argv[]) : argc(argc), argv(argv) {}
+	bool next(std::string_view& token) {
+		if (at >= argc) {
+			return false;
+		}
+		token = argv[at++];
+		return true;
+	}
+
+private:
+	int argc;
+	const char* const* argv;
+	int at = 1;
+};
+
+} // namespace
+
+std::string_view option_name(CommandOption option) {
+	return option_specs[static_cast<std::size_t>(option)].name;
+}
+
+bool CommandLexer::next(std::string_view& token) {
+	if (pending) {
+		token = *pending;
+		pending.reset();
+		return true;
+	}
+	return lex(token);
+}
+
+bool CommandLexer::peek(std::string_view& token) {
+	if (!pending) {
+		if (!lex(token)) {
+			return false;
+		}
+		pending = token;
+	}
+	token = *pending;
+	return true;
+}
+
+bool CommandLexer::lex(std::string_view& token) {
+	std::size_t size = line.size();
+	while (at < size && is_blank(line[at])) {
+		at++;
+	}
+	if (at == size) {
+		return false;
+	}
+	std::size_t start = at;
+	if (line[at] != '"') {
+		while (at < size && !is_blank(line[at])) {
+			at++;
+		}
+		token = std::string_view(line.data() + start, at - start);
+		return true;
+	}
+	// Quoted: unescape in place, writing over the opening quote onwards
+	std::size_t out = start;
+	at++;
+	while (true) {
+		if (at == size) {
+			return false; // never closed: std::quoted fails and drops the token
+		}
+		char c = line[at++];
+		if (c == '\\') {
+			if (at == size) {
+				return false;
+			}
+			c = line[at++];
+		}
+		else if (c == '"') {
+			break;
+		}
+		line[out++] = c;
+	}
+	token = std::string_view(line.data() + start, out - start);
+	return true;
+}
+
+class CommandParser {
+public:
+	template <typename Tokens>
+	static ParsedCommand parse(Tokens& tokens) {
+		ParsedCommand command;
+		std::string_view token;
+		while (tokens.next(token)) {
+			if (token == "--") {
+				break; // the rest are not options
+			}
+			if (token.size() > 2 && token.starts_with("--")) {
+				std::string_view name = token.substr(2);
+				std::size_t equals = name.find('=');
+				std::optional<std::string_view> inline_value;
+				if (equals != std::string_view::npos) {
+					inline_value = name.substr(equals + 1);
+					name = name.substr(0, equals);
+				}
+				const OptionSpec* spec = find_long(name);
+				if (!spec) {
+					throw CommandLineError("Option '" + std::string(name) + "' does not exist");
+				}
+				if (spec->kind == ValueKind::Flag && inline_value) {
+					throw CommandLineError("Option '" + std::string(name) + "' does not take an argument");
+				}
+				add(command, *spec, inline_value, tokens);
+			}
+			else if (token.size() > 1 && token[0] == '-') {
+				// A group of short options; one that takes a value ends the
+				// group, with the rest of the token or the next one as its value
+				for (std::size_t i = 1; i < token.size(); i++) {
+					const OptionSpec* spec = find_short(token[i]);
+					if (!spec) {
+						throw CommandLineError("Option '" + std::string(1, token[i]) + "' does not exist");
+					}
+					if (spec->kind != ValueKind::Flag && i + 1 < token.size()) {
+						add(command, *spec, token.substr(i + 1), tokens);
+						break;
+					}
+					add(command, *spec, std::nullopt, tokens);
+				}
+			}
+		}
+		return command;
+	}
+
+private:
+	template <typename Tokens>
+	static void add(ParsedCommand& command, const OptionSpec& spec, std::optional<std::string_view> value,
+		Tokens& tokens) {
+		std::size_t index = static_cast<std::size_t>(&spec - option_specs.data());
+		if (spec.kind != ValueKind::Flag) {
+			std::string_view text;
+			if (value) {
+				text = *value;
+			}
+			else if (!tokens.next(text)) {
+				throw CommandLineError("Option '" + std::string(spec.name) + "' is missing an argument");
+			}
+			if (spec.kind == ValueKind::Integer) {
+				int number = 0;
+				auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), number);
+				if (error != std::errc() || end != text.data() + text.size() || text.empty()) {
+					throw CommandLineError("Argument '" + std::string(text) + "' failed to parse");
+				}
+				command.integers[index] = number;
+			}
+			command.values[index] = text;
+		}
+		command.counts[index]++;
+		command.options++;
+	}
+};
+
+ParsedCommand parse_command(CommandLexer& lexer) {
+	return CommandParser::parse(lexer);
+}
+
+ParsedCommand parse_command(int argc, const char* const argv[]) {
+	ArgvTokens tokens(argc, argv);
+	return CommandParser::parse(tokens);
+}
@@ -0,0 +1,163 @@
+#include "concurrent_task_manager.h"
+
+ConcurrentTaskManager::ConcurrentTaskManager(const std::string& filename, TaskManagerOptions options)
+	: manager(filename, eager_shards(options)), durability(options.durability), threads(options.threads) {
+}
+
+TaskManagerOptions ConcurrentTaskManager::eager_shards(TaskManagerOptions options) {
+	// 读者共享锁, 所以分片要在读者之前全部读入 (重新加载时也是),
+	// 这样读者调用的 const 方法不会修改任何东西
+	options.lazy_shards = false;
+	return options;
+}
+
+std::vector<TaskData> ConcurrentTaskManager::copy_tasks(const std::vector<const Task*>& tasks) {
+	std::vector<TaskData> copies;
+	copies.reserve(tasks.size());
+	for (const Task* task : tasks) {
+		copies.emplace_back(*task);
+	}
+	return copies;
+}
+
+std::optional<TaskData> ConcurrentTaskManager::get_task(int id) const {
+	std::shared_lock<std::shared_mutex> lock(mutex);
+	const Task* task = static_cast<const TaskManager&>(manager).get_task(id);
+	if (!task) {
+		return std::nullopt;
+	}
+	return TaskData(*task);
+}
+
+std::vector<TaskData> ConcurrentTaskManager::list_tasks() const {
+	std::shared_lock<std::shared_mutex> lock(mutex);
+	return copy_tasks(manager.list_tasks());
+}
+
+std::vector<TaskData> ConcurrentTaskManager::list_tasks(TaskStatus statu) const {
+	std::shared_lock<std::shared_mutex> lock(mutex);
+	return copy_tasks(manager.list_tasks(statu));
+}
+
+std::vector<TaskData> ConcurrentTaskManager::list_tasks(ListOrder order, std::size_t limit,
+	std::optional<TaskCursor> after, std::optional<TaskStatus> statu) const {
+	{
+		std::shared_lock<std::shared_mutex> lock(mutex);
+		if (order.key == SortKey::Id || manager.has_time_index()) {
+			return copy_tasks(manager.list_tasks(order, limit, after, statu));
+		}
+	}
+	std::unique_lock<std::shared_mutex> lock(mutex);
+	return copy_tasks(manager.list_tasks(order, limit, after, statu));
+}
+
+std::size_t ConcurrentTaskManager::count_tasks(TaskStatus statu) const {
+	std::shared_lock<std::shared_mutex> lock(mutex);
+	return manager.count_tasks(statu);
+}
+
+bool ConcurrentTaskManager::IsEmpty() const {
+	std::shared_lock<std::shared_mutex> lock(mutex);
+	return manager.IsEmpty();
+}
+
+std::vector<TaskData> ConcurrentTaskManager::search(std::string_view query) const {
+	{
+		std::shared_lock<std::shared_mutex> lock(mutex);
+		if (manager.has_text_index()) {
+			return copy_tasks(manager.search(query));
+		}
+	}
+	std::unique_lock<std::shared_mutex> lock(mutex);
+	return copy_tasks(manager.search(query));
+}
+
+std::vector<TaskData> ConcurrentTaskManager::list_tasks_between(TimeField field, std::time_t from, std::time_t to) const {
+	{
+		std::shared_lock<std::shared_mutex> lock(mutex);
+		if (manager.has_time_index()) {
+			return copy_tasks(manager.list_tasks_between(field, from, to));
+		}
+	}
+	std::unique_lock<std::shared_mutex> lock(mutex);
+	return copy_tasks(manager.list_tasks_between(field, from, to));
+}
+
+std::vector<TaskData> ConcurrentTaskManager::filter_contains(std::string_view text) const {
+	std::shared_lock<std::shared_mutex> lock(mutex);
+	return copy_tasks(manager.filter_contains(text));
+}
+
+TaskSnapshot ConcurrentTaskManager::snapshot() const {
+	std::shared_lock<std::shared_mutex> lock(mutex);
+	return manager.snapshot();
+}
+
+TaskData ConcurrentTaskManager::add_task(std::string_view description) {
+	std::unique_lock<std::shared_mutex> lock(mutex);
+	return TaskData(*manager.add_task(description));
+}
+
+std::vector<TaskData> ConcurrentTaskManager::add_tasks(std::span<const std::string> descriptions) {
+	std::unique_lock<std::shared_mutex> lock(mutex);
+	std::vector<Task*> added = manager.add_tasks(descriptions);
+	return copy_tasks(std::vector<const Task*>(added.begin(), added.end()));
+}
+
+bool ConcurrentTaskManager::remove_task(int id) {
+	std::unique_lock<std::shared_mutex> lock(mutex);
+	return manager.remove_task(id);
+}
+
+bool ConcurrentTaskManager::remove_last_task() {
+	std::unique_lock<std::shared_mutex> lock(mutex);
+	return manager.remove_last_task();
+}
+
+bool ConcurrentTaskManager::clear_all_tasks() {
+	std::unique_lock<std::shared_mutex> lock(mutex);
+	return manager.clear_all_tasks();
+}
+
+std::optional<TaskData> ConcurrentTaskManager::update_task_status(int id, std::string_view new_status) {
+	std::unique_lock<std::shared_mutex> lock(mutex);
+	Task* task = manager.update_task_status(id, new_status);
+	if (!task) {
+		return std::nullopt;
+	}
+	return TaskData(*task);
+}
+
+std::optional<TaskData> ConcurrentTaskManager::update_task_description(int id, std::string_view new_description) {
+	std::unique_lock<std::shared_mutex> lock(mutex);
+	Task* task = manager.update_task_description(id, new_description);
+	if (!task) {
+		return std::nullopt;
+	}
+	return TaskData(*task);
+}
+
+std::size_t ConcurrentTaskManager::update_status_bulk(std::span<const int> ids, TaskStatus status) {
+	std::unique_lock<std::shared_mutex> lock(mutex);
+	return manager.update_status_bulk(ids, status);
+}
+
+ImportResult ConcurrentTaskManager::import_stream(std::istream& input, ImportOptions import_options) {
+	std::unique_lock<std::shared_mutex> lock(mutex);
+	return manager.import_stream(input, import_options);
+}
+
+void ConcurrentTaskManager::compact() {
+	std::unique_lock<std::shared_mutex> lock(mutex);
+	manager.compact();
+}
+
+void ConcurrentTaskManager::flush() {
+	// 独占锁: flush() 也会访问 journal 缓冲区
+	std::unique_lock<std::shared_mutex> lock(mutex);
+	manager.flush();
+}
+
+void ConcurrentTaskManager::export_snapshot(const std::string& path, SnapshotFormat format) const {
+	snapshot().export_snapshot(path, format, durability, threads);
+}
@@ -0,0 +1,187 @@
+#include "durable_file.h"
+#include <cerrno>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <stdexcept>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <fcntl.h>
+#include <io.h>
+#include <sys/stat.h>
+
+static int open_for_writing(const std::string& path, bool truncate) {
+	return ::_open(path.c_str(), _O_WRONLY | _O_CREAT | _O_BINARY | (truncate ? _O_TRUNC : _O_APPEND),
+		_S_IREAD | _S_IWRITE);
+}
+
+static long write_some(int fd, const char* bytes, std::size_t length) {
+	return ::_write(fd, bytes, static_cast<unsigned int>(length > INT_MAX ? INT_MAX : length));
+}
+
+static bool sync_fd(int fd) {
+	return ::_commit(fd) == 0;
+}
+
+static bool close_fd(int fd) {
+	return ::_close(fd) == 0;
+}
+
+static bool replace_file(const std::string& from, const std::string& to) {
+	return MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+}
+
+static bool sync_directory(const std::string&) {
+	return true; // MOVEFILE_WRITE_THROUGH already waits for the rename
+}
+
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static int open_for_writing(const std::string& path, bool truncate) {
+	return ::open(path.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC | (truncate ? O_TRUNC : O_APPEND), 0644);
+}
+
+static long write_some(int fd, const char* bytes, std::size_t length) {
+	return static_cast<long>(::write(fd, bytes, length));
+}
+
+static bool sync_fd(int fd) {
+	return ::fsync(fd) == 0;
+}
+
+static bool close_fd(int fd) {
+	return ::close(fd) == 0;
+}
+
+static bool replace_file(const std::string& from, const std::string& to) {
+	return std::rename(from.c_str(), to.c_str()) == 0;
+}
+
+// Makes a rename inside `path`'s directory survive power loss
+static bool sync_directory(const std::string& path) {
+	std::string dir = std::filesystem::path(path).parent_path().string();
+	int fd = ::open(dir.empty() ? "." : dir.c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd < 0) {
+		return false;
+	}
+	bool synced = ::fsync(fd) == 0;
+	::close(fd);
+	return synced;
+}
+#endif
+
+static std::string describe_errno(const std::string& what, const std::string& path) {
+	return what + " " + path + ": " + std::strerror(errno);
+}
+
+static void write_all(int fd, std::string_view bytes, const std::string& path) {
+	while (!bytes.empty()) {
+		long written = write_some(fd, bytes.data(), bytes.size());
+		if (written < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			throw std::runtime_error(describe_errno("Could not write", path));
+		}
+		bytes.remove_prefix(static_cast<std::size_t>(written));
+	}
+}
+
+void write_file_atomically(const std::string& path, std::string_view content, Durability durability) {
+	std::string temp_path = path + ".tmp";
+	int fd = open_for_writing(temp_path, true);
+	if (fd < 0) {
+		throw std::runtime_error(describe_errno("Could not open file for writing:", temp_path));
+	}
+	try {
+		write_all(fd, content, temp_path);
+		if (durability == Durability::Fsync && !sync_fd(fd)) {
+			throw std::runtime_error(describe_errno("Could not sync", temp_path));
+		}
+	}
+	catch (...) {
+		close_fd(fd);
+		std::remove(temp_path.c_str());
+		throw;
+	}
+	if (!close_fd(fd)) {
+		std::remove(temp_path.c_str());
+		throw std::runtime_error(describe_errno("Could not close", temp_path));
+	}
+	if (!replace_file(temp_path, path)) {
+		std::string message = describe_errno("Could not replace", path);
+		std::remove(temp_path.c_str());
+		throw std::runtime_error(message);
+	}
+	if (durability == Durability::Fsync && !sync_directory(path)) {
+		throw std::runtime_error(describe_errno("Could not sync the directory of", path));
+	}
+}
+
+AppendFile::~AppendFile() {
+	try {
+		close();
+	}
+	catch (const std::exception& e) {
+		std::cerr << e.what() << std::endl;
+	}
+}
+
+void AppendFile::open(const std::string& new_path, bool truncate) {
+	close();
+	fd = open_for_writing(new_path, truncate);
+	if (fd < 0) {
+		throw std::runtime_error(describe_errno("Could not open file for writing:", new_path));
+	}
+	path = new_path;
+}
+
+void AppendFile::close() {
+	if (fd < 0) {
+		return;
+	}
+	int closing = fd;
+	fd = -1;
+	std::string pending = std::move(buffer);
+	buffer.clear();
+	try {
+		write_all(closing, pending, path);
+	}
+	catch (...) {
+		close_fd(closing);
+		throw;
+	}
+	if (!close_fd(closing)) {
+		throw std::runtime_error(describe_errno("Could not close", path));
+	}
+}
+
+void AppendFile::write(std::string_view bytes) {
+	buffer.append(bytes);
+	if (buffer.size() >= buffer_limit) {
+		flush();
+	}
+}
+
+void AppendFile::flush() {
+	if (fd < 0 || buffer.empty()) {
+		return;
+	}
+	write_all(fd, buffer, path);
+	buffer.clear();
+}
+
+void AppendFile::sync() {
+	flush();
+	if (fd >= 0 && !sync_fd(fd)) {
+		throw std::runtime_error(describe_errno("Could not sync", path));
+	}
+}
@@ -0,0 +1,109 @@
+#include "id_index.h"
+
+std::size_t IdIndex::home(int id) const {
+	// Fibonacci hashing; consecutive ids spread over the table
+	std::uint64_t hash = static_cast<std::uint32_t>(id) * 0x9E3779B97F4A7C15ull;
+	return static_cast<std::size_t>(hash >> 32) & (entries.size() - 1);
+}
+
+std::uint32_t* IdIndex::find(int id) {
+	return const_cast<std::uint32_t*>(static_cast<const IdIndex*>(this)->find(id));
+}
+
+const std::uint32_t* IdIndex::find(int id) const {
+	if (id == empty_id) {
+		return has_empty_id ? &empty_id_slot : nullptr;
+	}
+	if (entries.empty()) {
+		return nullptr;
+	}
+	std::size_t mask = entries.size() - 1;
+	for (std::size_t i = home(id); entries[i].id != empty_id; i = (i + 1) & mask) {
+		if (entries[i].id == id) {
+			return &entries[i].slot;
+		}
+	}
+	return nullptr;
+}
+
+void IdIndex::insert_or_assign(int id, std::uint32_t slot) {
+	if (id == empty_id) {
+		count += has_empty_id ? 0 : 1;
+		has_empty_id = true;
+		empty_id_slot = slot;
+		return;
+	}
+	// Keep the load factor at or below 1/2
+	if ((count + 1) * 2 > entries.size()) {
+		grow();
+	}
+	std::size_t mask = entries.size() - 1;
+	std::size_t i = home(id);
+	while (entries[i].id != empty_id) {
+		if (entries[i].id == id) {
+			entries[i].slot = slot;
+			return;
+		}
+		i = (i + 1) & mask;
+	}
+	entries[i] = Entry{ id, slot };
+	count++;
+}
+
+bool IdIndex::erase(int id) {
+	if (id == empty_id) {
+		if (!has_empty_id) {
+			return false;
+		}
+		has_empty_id = false;
+		count--;
+		return true;
+	}
+	if (entries.empty()) {
+		return false;
+	}
+	std::size_t mask = entries.size() - 1;
+	std::size_t i = home(id);
+	while (entries[i].id != id) {
+		if (entries[i].id == empty_id) {
+			return false;
+		}
+		i = (i + 1) & mask;
+	}
+	// Backward-shift deletion: pull later entries of the probe run into the
+	// hole unless that would move them before their home position.
+	std::size_t hole = i;
+	for (std::size_t j = (hole + 1) & mask; entries[j].id != empty_id; j = (j + 1) & mask) {
+		std::size_t want = home(entries[j].id);
+		bool stays = (hole <= j) ? (hole < want && want <= j) : (hole < want || want <= j);
+		if (!stays) {
+			entries[hole] = entries[j];
+			hole = j;
+		}
+	}
+	entries[hole].id = empty_id;
+	count--;
+	return true;
+}
+
+void IdIndex::clear() {
+	entries.clear();
+	count = 0;
+	has_empty_id = false;
+}
+
+void IdIndex::grow() {
+	std::vector<Entry> old;
+	old.swap(entries);
+	entries.assign(old.empty() ? 16 : old.size() * 2, Entry{ empty_id, 0 });
+	std::size_t mask = entries.size() - 1;
+	for (const Entry& entry : old) {
+		if (entry.id != empty_id) {
+			std::size_t i = home(entry.id);
+			while (entries[i].id != empty_id) {
+				i = (i + 1) & mask;
+			}
+			entries[i] = entry;
+		}
+	}
+}
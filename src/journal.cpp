@@ -0,0 +1,221 @@
+#include "journal.h"
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+
+Journal::Journal(std::string path, Durability durability)
+	: path(std::move(path)), durability(durability) {
+}
+
+Journal::~Journal() {
+	try {
+		out.close();
+	}
+	catch (const std::exception& e) {
+		std::cerr << "Failed to write journal " << path << ": " << e.what() << std::endl;
+	}
+}
+
+// FNV-1a, 64 bit
+static constexpr std::uint64_t fnv_offset_basis = 14695981039346656037ull;
+
+static std::uint64_t fnv1a(std::uint64_t hash, const char* bytes, std::size_t length) {
+	for (std::size_t i = 0; i < length; i++) {
+		hash ^= static_cast<unsigned char>(bytes[i]);
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+std::uint64_t Journal::fingerprint(std::string_view bytes) {
+	return fnv1a(fnv_offset_basis, bytes.data(), bytes.size());
+}
+
+std::uint64_t Journal::fingerprint(std::istream& input) {
+	std::uint64_t hash = fnv_offset_basis;
+	char buffer[1 << 16];
+	while (input.read(buffer, sizeof(buffer)) || input.gcount() > 0) {
+		hash = fnv1a(hash, buffer, static_cast<std::size_t>(input.gcount()));
+	}
+	return hash;
+}
+
+static constexpr int journal_version = 2;
+
+bool Journal::replay(std::uint64_t snapshot_fingerprint, const std::function<std::uint64_t()>& legacy_fingerprint,
+	const std::function<void(const nlohmann::json&)>& apply) {
+	out.close(); // writes out anything still buffered
+	records = 0;
+
+	std::ifstream file(path, std::ios::binary);
+	if (!file.is_open()) {
+		return false;
+	}
+
+	std::string line;
+	if (!std::getline(file, line) || file.eof()) {
+		return false;
+	}
+	std::size_t line_number = 1;
+	bool legacy = false;
+	try {
+		nlohmann::json header = nlohmann::json::parse(line);
+		legacy = header.value("journal", 0) == 1;
+		std::uint64_t expected = legacy ? legacy_fingerprint() : snapshot_fingerprint;
+		if (header.value("snapshot", std::uint64_t(0)) != expected) {
+			std::cerr << "Journal " << path << " does not match the current snapshot and was discarded." << std::endl;
+			return false;
+		}
+	}
+	catch (const nlohmann::json::exception& e) {
+		damaged(line_number, e.what());
+	}
+
+	std::streamoff records_start = file.tellg();
+	std::streamoff good_end = records_start;
+	bool torn = false;
+	while (std::getline(file, line)) {
+		line_number++;
+		// Only a last record without its trailing newline was cut off mid-write.
+		if (file.eof()) {
+			torn = true;
+			break;
+		}
+		// A complete record that does not parse or apply is damage; the
+		// records after it may be committed work, so none of them is dropped.
+		try {
+			apply(nlohmann::json::parse(line));
+		}
+		catch (const std::exception& e) {
+			damaged(line_number, e.what());
+		}
+		records++;
+		good_end = file.tellg();
+	}
+	file.close();
+	if (torn) {
+		// Drop the torn tail so that new records are not appended onto it.
+		std::cerr << "Journal " << path << " has a torn tail after " << records << " records; it was truncated." << std::endl;
+		std::filesystem::resize_file(path, static_cast<std::uintmax_t>(good_end));
+	}
+	if (legacy) {
+		// Name the snapshot the current way, keeping every record
+		std::ifstream old(path, std::ios::binary);
+		old.seekg(records_start);
+		std::string content = header_line(snapshot_fingerprint);
+		content.append(std::istreambuf_iterator<char>(old), std::istreambuf_iterator<char>());
+		old.close();
+		write_file_atomically(path, content, durability);
+	}
+
+	open_for_append();
+	return true;
+}
+
+void Journal::damaged(std::size_t line_number, const std::string& reason) const {
+	std::cerr << "Journal " << path << " is damaged on line " << line_number << ": " << reason << std::endl;
+	throw std::runtime_error("Journal " + path + " is damaged on line " + std::to_string(line_number)
+		+ "; it was left untouched, repair or remove it to open the store");
+}
+
+void Journal::reset(std::uint64_t snapshot_fingerprint) {
+	out.close();
+	try {
+		out.open(path, true);
+	}
+	catch (const std::runtime_error&) {
+		std::cerr << "Failed to open journal for writing: " << path << std::endl;
+		throw;
+	}
+	out.write(header_line(snapshot_fingerprint));
+	finish_write();
+	records = 0;
+}
+
+std::string Journal::header_line(std::uint64_t snapshot_fingerprint) const {
+	nlohmann::json header;
+	header["journal"] = journal_version;
+	header["snapshot"] = snapshot_fingerprint;
+	return header.dump() + '\n';
+}
+
+void Journal::append(const nlohmann::json& record) {
+	if (batching) {
+		batch += record.dump();
+		batch += '\n';
+		pending_records++;
+		return;
+	}
+	if (!out.is_open()) {
+		open_for_append();
+	}
+	std::string line = record.dump();
+	line += '\n';
+	out.write(line);
+	finish_write();
+	records++;
+}
+
+void Journal::begin_batch() {
+	batching = true;
+}
+
+void Journal::append_lines(std::string_view lines, std::size_t count) {
+	if (count == 0) {
+		return;
+	}
+	if (!out.is_open()) {
+		open_for_append();
+	}
+	out.write(lines);
+	finish_write();
+	records += count;
+}
+
+void Journal::commit_batch() {
+	batching = false;
+	append_lines(batch, pending_records);
+	discard_batch();
+}
+
+std::string Journal::take_batch() {
+	std::string lines = std::move(batch);
+	discard_batch();
+	return lines;
+}
+
+void Journal::discard_batch() {
+	batching = false;
+	batch.clear();
+	batch.shrink_to_fit();
+	pending_records = 0;
+}
+
+void Journal::flush() {
+	out.flush();
+}
+
+void Journal::open_for_append() {
+	try {
+		out.open(path, false);
+	}
+	catch (const std::runtime_error&) {
+		std::cerr << "Failed to open journal for writing: " << path << std::endl;
+		throw;
+	}
+}
+
+void Journal::finish_write() {
+	switch (durability) {
+	case Durability::None:
+		break;
+	case Durability::Flush:
+		out.flush();
+		break;
+	case Durability::Fsync:
+		out.sync();
+		break;
+	}
+}
@@ -1,213 +1,641 @@
 #include "cxxopts.hpp"         
+#include "command_line.h"
 #include "task_manager.h"    
 #include "ui.h"             
 #include "task.h"           
 #include <iostream>
 #include <string>
 #include <vector>
-#include <sstream>           //  std::istringstream
-#include <iomanip>           //  std::quoted (ոַ)
+#include <fstream>
+#include <optional>
+#include <sstream>           // 用于 std::istringstream
+#include <iomanip>           // 用于 std::get_time
+#include <ctime>
+#include <limits>
+#include <memory>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
 
-int main() {
-    //  ʼ TaskManager (ֻһ)
-    TaskManager manager("tasks.json");
+// 解析 --since / --until 的时间: Unix 时间戳, 相对现在的 "30s" "15m" "2h" "7d",
+// 或本地时间 "YYYY-MM-DD", "YYYY-MM-DDTHH:MM[:SS]"
+static bool parse_time(const std::string& text, std::time_t& value) {
+    if (text.empty()) {
+        return false;
+    }
+    std::size_t digits = 0;
+    while (digits < text.size() && std::isdigit(static_cast<unsigned char>(text[digits]))) {
+        digits++;
+    }
+    if (digits > 0 && digits + 1 == text.size() && std::string("smhd").find(text.back()) != std::string::npos) {
+        long long amount = std::stoll(text.substr(0, digits));
+        long long unit = text.back() == 's' ? 1 : text.back() == 'm' ? 60 : text.back() == 'h' ? 3600 : 86400;
+        value = std::time(nullptr) - static_cast<std::time_t>(amount * unit);
+        return true;
+    }
+    if (digits == text.size() && digits <= 18) {
+        value = static_cast<std::time_t>(std::stoll(text));
+        return true;
+    }
 
-    //  cxxopts (ֻһ)
-    //  cxxopts û REPL ÿһ
-    cxxopts::Options options("task-cli",
-        "һ C++ \n"
-        " > ʾѡ ( --add \"\")");
+    for (const char* format : { "%Y-%m-%dT%H:%M:%S", "%Y-%m-%dT%H:%M", "%Y-%m-%d" }) {
+        std::tm tm = {};
+        std::istringstream in(text);
+        in >> std::get_time(&tm, format);
+        // 必须用完整个字符串
+        if (!in.fail() && (in.eof() || in.peek() == std::char_traits<char>::eof())) {
+            tm.tm_isdst = -1;
+            value = std::mktime(&tm);
+            return value != static_cast<std::time_t>(-1);
+        }
+    }
+    return false;
+}
 
-    options.add_options()
-        ("l,list", "г (Ĭϲ)")
-        ("g,get", " ID ȡ", cxxopts::value<int>(), "<ID>")
-        ("a,add", "һ", cxxopts::value<std::string>(), "<>")
-        ("r,remove", " ID ɾһ", cxxopts::value<int>(), "<ID>")
-        ("u,update", " ID һ ( --desc  --status)", cxxopts::value<int>(), "<ID>")
-        ("r-last", "ɾӵ")
-		("c,clear", "")
-        ("d,desc", "µ ( --update)", cxxopts::value<std::string>())
-        ("s,status", "µ״̬ (TO_DO, IN_PROGRESS, DONE)", cxxopts::value<std::string>())
-        ("h,help", "ӡϢ");
-
-    // ӡӭϢ
-    std::cout << "ӭʹýʽ" << std::endl;
-    std::cout << " 'help' 鿴, 'exit'  'quit' ˳" << std::endl;
-    std::cout << "---" << std::endl;
+// 解析 --sort 的值: id / created / updated, 可以带 :asc 或 :desc
+static bool parse_sort(const std::string& text, ListOrder& order) {
+    std::string key = text;
+    std::size_t colon = text.find(':');
+    if (colon != std::string::npos) {
+        key = text.substr(0, colon);
+        std::string direction = text.substr(colon + 1);
+        if (direction != "asc" && direction != "desc") {
+            return false;
+        }
+        order.descending = direction == "desc";
+    }
+    if (key == "id") {
+        order.key = SortKey::Id;
+    }
+    else if (key == "created") {
+        order.key = SortKey::Created;
+    }
+    else if (key == "updated") {
+        order.key = SortKey::Updated;
+    }
+    else {
+        return false;
+    }
+    return true;
+}
 
-    std::string line;
-    while (true) {
-        std::cout << "> ";
-        if (!std::getline(std::cin, line)) {
-            break; // EOF ( Ctrl+D  Ctrl+Z)
+// 游标: 按 id 排序时是 id, 按时间排序时是 "时间:id"
+static std::string format_cursor(const TaskCursor& cursor, SortKey key) {
+    if (key == SortKey::Id) {
+        return std::to_string(cursor.id);
+    }
+    return std::to_string(cursor.time) + ":" + std::to_string(cursor.id);
+}
+
+static bool parse_cursor(const std::string& text, SortKey key, TaskCursor& cursor) {
+    try {
+        std::size_t colon = text.find(':');
+        if (key == SortKey::Id && colon == std::string::npos) {
+            cursor.id = std::stoi(text);
+            return true;
         }
-        if (line.empty()) {
-            continue;
+        if (key != SortKey::Id && colon != std::string::npos) {
+            cursor.time = static_cast<std::time_t>(std::stoll(text.substr(0, colon)));
+            cursor.id = std::stoi(text.substr(colon + 1));
+            return true;
         }
+    }
+    catch (const std::exception&) {
+    }
+    return false;
+}
+
+static int run_script(TaskManager& manager, cxxopts::Options& options, const std::string& path);
 
-        // û (std::string) תΪ (argc, char**) Ա cxxopts 
-        std::istringstream iss(line);
-        std::vector<std::string> args;
-        std::string arg;
+// 执行一条已解析的命令, 返回退出码: 0 成功, 1 命令失败 (任务不存在, 无效的值, 文件错误等), 2 用法错误。
+// interactive 为 false 时 (单次命令, 脚本, 管道输入) 不会等待用户确认; in_script 表示命令来自 --script
+static int run_command(TaskManager& manager, cxxopts::Options& options, const ParsedCommand& command,
+    bool interactive, bool in_script = false) {
+    using enum CommandOption;
 
-        // ʹ std::quoted ȷŵַ
-        while (iss >> std::quoted(arg)) {
-            args.push_back(arg);
+    // 输出格式: --format 优先, 否则 --table 选择表格
+    RenderStyle style = command.count(Table) ? RenderStyle::Table : RenderStyle::Detailed;
+    if (command.count(Format) && !parse_render_style(command.value(Format), style)) {
+        std::cerr << "错误: --format 只能是 text, table, jsonl, csv 或 tsv。" << std::endl;
+        return 1;
+    }
+
+    // 逻辑分发
+    try {
+        // ('help' 由 run_line 处理, 这里处理 --help)
+        if (command.count(Help)) {
+            std::cout << options.help() << std::endl;
         }
 
-        if (args.empty()) {
-            continue;
+        // --- 增 (Add) ---
+        else if (command.count(Add)) {
+            std::string description(command.value(Add));
+            Task* new_task = manager.add_task(description);
+            print_added_task(new_task);
         }
 
-        //  REPL 
-        if (args[0] == "exit" || args[0] == "quit") {
-            break;
+        // --- 删 (Remove) ---
+        else if (command.count(Remove)) {
+            int id = command.integer(Remove);
+            bool success = manager.remove_task(id);
+            print_removed_task(id, success);
+            return success ? 0 : 1;
         }
-        if (args[0] == "help") {
-            // û 'help'ֶʾ cxxopts İϢ
-            std::cout << options.help() << std::endl;
-            continue;
+
+        else if (command.count(RemoveLast)) {
+            int last_id = manager.get_last_id();
+            bool success = manager.remove_last_task();
+            print_removed_last_task(last_id, success);
+            return success ? 0 : 1;
         }
 
-        // --- Cxxopts  ---
-        // αһ (argc, char**) б
-        std::vector<char*> c_argv;
-        std::string program_name = "task-cli"; // α argv[0]
-        c_argv.push_back(const_cast<char*>(program_name.c_str()));
+        // --- 清除所有任务 (Clear All) ---
+        else if (command.count(Clear)) {
+            std::string confirmation = "y";
+            if (!command.count(Yes)) {
+                if (!interactive) {
+                    // 没有人可以确认, 必须明确给出 --yes
+                    std::cerr << "错误: 非交互模式下清除所有任务需要加上 --yes。" << std::endl;
+                    return 1;
+                }
+                std::cout << "警告: 你确定要清除所有任务吗？这将不可恢复。输入 'y' 确认: ";
+                std::getline(std::cin, confirmation);
+            }
+            if (confirmation == "y" || confirmation == "Y") {
+                bool success = manager.clear_all_tasks();
+                if (success) {
+                    std::cout << "已清除所有任务。" << std::endl;
+                }
+                else {
+                    std::cout << "任务列表已为空，无需清除。" << std::endl;
+                }
+            }
+        }
 
-        for (const auto& s : args) {
-            c_argv.push_back(const_cast<char*>(s.c_str()));
+        // --- 批处理 (Batch) ---
+        else if (in_script && (command.count(Begin) || command.count(Commit) || command.count(Rollback))) {
+            // 整个脚本就是一个批处理, 由脚本是否成功决定提交还是放弃
+            std::cerr << "错误: 脚本中不能使用 --begin, --commit 或 --rollback。" << std::endl;
+            return 2;
+        }
+        else if (command.count(Begin)) {
+            manager.begin_batch();
+            std::cout << "已开始批处理, 输入 --commit 提交或 --rollback 放弃。" << std::endl;
+        }
+        else if (command.count(Commit)) {
+            if (manager.in_batch()) {
+                manager.commit();
+                std::cout << (manager.in_batch() ? "已提交内层批处理。" : "批处理已提交。") << std::endl;
+            }
+            else {
+                std::cerr << "错误: 当前没有进行中的批处理。" << std::endl;
+                return 1;
+            }
+        }
+        else if (command.count(Rollback)) {
+            if (manager.in_batch()) {
+                manager.rollback();
+                std::cout << "批处理已回滚。" << std::endl;
+            }
+            else {
+                std::cerr << "错误: 当前没有进行中的批处理。" << std::endl;
+                return 1;
+            }
         }
-        int c_argc = static_cast<int>(c_argv.size());
 
-        cxxopts::ParseResult result;
-        try {
-            // 
-            result = options.parse(c_argc, c_argv.data());
+        // --- 查 (Get) ---
+        else if (command.count(Get)) {
+            int id = command.integer(Get);
+            Task* task = manager.get_task(id);
+            print_get_task(task, style);
+            return task ? 0 : 1;
         }
-        catch (const cxxopts::exceptions::exception& e) {
-            std::cerr << ": " << e.what() << std::endl;
-            std::cerr << " 'help' 鿴ѡ" << std::endl;
-            continue; //  REPL ѭ, ˳
+
+        // --- 搜索 (Search) ---
+        else if (command.count(Search)) {
+            print_tasks(manager.search(command.value(Search)), style);
         }
 
-        // 7. ߼ַ ( REPL ѭ)
-        try {
-            // (ע⣺'help' ڱ REPL ѭˣԷһ --help )
-            if (result.count("help")) {
-                std::cout << options.help() << std::endl;
-            }
-
-            // ---  (Add) ---
-            else if (result.count("add")) {
-                std::string description = result["add"].as<std::string>();
-                Task* new_task = manager.add_task(description);
-                print_added_task(new_task);
-            }
-
-            // --- ɾ (Remove) ---
-            else if (result.count("remove")) {
-                int id = result["remove"].as<int>();
-                bool success = manager.remove_task(id);
-                print_removed_task(id, success);
-            }
-
-            else if (result.count("r-last")) {
-				int last_id = manager.get_last_id();
-                bool success = manager.remove_last_task();
-				print_removed_last_task(last_id, success);
-			}
-
-			// ---  (Clear All) ---
-            else if (result.count("clear")) {
-                std::cout << ": ȷҪ⽫ɻָ 'y' ȷ: ";
-				std::string confirmation;
-				std::getline(std::cin, confirmation);
-                if (confirmation == "y" || confirmation == "Y") {
-                    bool success = manager.clear_all_tasks();
-                    if (success) {
-                        std::cout << "" << std::endl;
-                    }
-                    else {
-                        std::cout << "бΪգ" << std::endl;
-                    }
+        // --- 脚本 (Script) ---
+        else if (command.count(Script)) {
+            if (in_script) {
+                // 不允许嵌套, 否则脚本调用自身时会无限递归
+                std::cerr << "错误: 脚本中不能使用 --script。" << std::endl;
+                return 2;
+            }
+            return run_script(manager, options, std::string(command.value(Script)));
+        }
+
+        // --- 导入 (Import) ---
+        else if (command.count(Import)) {
+            std::string path(command.value(Import));
+            ImportOptions import_options;
+            if (command.count(Format)) {
+                if (is_human_readable(style)) {
+                    std::cerr << "错误: 只能导入 jsonl, csv 或 tsv 格式。" << std::endl;
+                    return 1;
+                }
+                import_options.format = style == RenderStyle::JsonLines ? ImportFormat::JsonLines
+                    : style == RenderStyle::Csv ? ImportFormat::Csv : ImportFormat::Tsv;
+            }
+            if (command.count(RemapIds)) {
+                import_options.ids = ImportIds::Remap;
+            }
+            std::ifstream file(path, std::ios::binary);
+            if (!file.is_open()) {
+                std::cerr << "错误: 无法打开文件 " << path << std::endl;
+                return 1;
+            }
+            ImportResult imported = manager.import_stream(file, import_options);
+            std::cout << "已导入 " << imported.imported << " 个任务。" << std::endl;
+            if (imported.rejected > 0) {
+                std::cerr << "跳过了 " << imported.rejected << " 条无效或 id 重复的记录, 位于第";
+                for (std::size_t line : imported.rejected_lines) {
+                    std::cerr << " " << line;
                 }
+                std::cerr << (imported.rejected > imported.rejected_lines.size() ? " ... 行。" : " 行。") << std::endl;
             }
+        }
 
-            // ---  (Get) ---
-            else if (result.count("get")) {
-                int id = result["get"].as<int>();
-                Task* task = manager.get_task(id);
-                print_get_task(task);
+        // --- 导出 (Export) ---
+        else if (command.count(Export)) {
+            std::string path(command.value(Export));
+            if (!command.count(Format)) {
+                style = RenderStyle::JsonLines;
+            }
+            std::optional<TaskStatus> statu;
+            if (command.count(Status)) {
+                TaskStatus parsed;
+                if (!parse_status(command.value(Status), parsed)) {
+                    std::cerr << "错误: 无效的状态值 '" << command.value(Status) << "'。请使用 TO_DO, IN_PROGRESS, 或 DONE。" << std::endl;
+                    return 1;
+                }
+                statu = parsed;
+            }
+            // 边生成边写出, 内存占用与任务数无关
+            std::ofstream file(path, std::ios::binary);
+            if (!file.is_open()) {
+                std::cerr << "错误: 无法写入文件 " << path << std::endl;
+                return 1;
+            }
+            std::size_t count = export_tasks(manager, file, style, statu);
+            file.close();
+            if (!file) {
+                std::cerr << "错误: 写入文件 " << path << " 失败。" << std::endl;
+                return 1;
             }
+            std::cout << "已导出 " << count << " 个任务到 " << path << std::endl;
+        }
 
-            // ---  (Update) ---
-            else if (result.count("update")) {
-                int id = result["update"].as<int>();
-                bool updated = false;
-                Task* task = nullptr;
+        // --- 改 (Update) ---
+        else if (command.count(Update)) {
+            int id = command.integer(Update);
+            bool updated = false;
+            Task* task = nullptr;
 
-                if (result.count("desc")) {
-                    std::string description = result["desc"].as<std::string>();
-                    task = manager.update_task_description(id, description);
+            if (command.count(Desc)) {
+                std::string description(command.value(Desc));
+                task = manager.update_task_description(id, description);
+                updated = (task != nullptr);
+            }
+            if (command.count(Status)) {
+                std::string status_str(command.value(Status));
+                try {
+                    string_to_status(status_str); // 验证输入
+                    task = manager.update_task_status(id, status_str);
                     updated = (task != nullptr);
                 }
-                if (result.count("status")) {
-                    std::string status_str = result["status"].as<std::string>();
-                    try {
-                        string_to_status(status_str); // ֤
-                        task = manager.update_task_status(id, status_str);
-                        updated = (task != nullptr);
-                    }
-                    catch (const std::invalid_argument&) {
-                        std::cerr << ": Ч״ֵ̬ '" << status_str << "'ʹ TO_DO, IN_PROGRESS,  DONE" << std::endl;
-                    }
+                catch (const std::invalid_argument&) {
+                    std::cerr << "错误: 无效的状态值 '" << status_str << "'。请使用 TO_DO, IN_PROGRESS, 或 DONE。" << std::endl;
+                    return 1;
                 }
+            }
 
-                if (!updated && !result.count("desc") && !result.count("status")) {
-                    std::cerr << ": ʹ --update ṩ --desc  --status" << std::endl;
+            if (!updated && !command.count(Desc) && !command.count(Status)) {
+                std::cerr << "错误: 使用 --update 必须至少提供 --desc 或 --status。" << std::endl;
+                return 1;
+            }
+            else if (task) {
+                print_updated_task(task);
+            }
+            else if (updated) {
+                // task 可能是 nullptr 但 updated 是 true (e.g. 连续两次更新)
+                // 重新获取任务来打印
+                print_updated_task(manager.get_task(id));
+            }
+            else {
+                return 1; // TaskManager 已经报告了任务不存在
+            }
+        }
+
+        // --- 查 (List - 默认) ---
+        // 如果没有提供任何其他匹配的命令，则默认为 list
+        else if (command.count(List) || command.count(Since) || command.count(Until) || command.count(Limit)
+            || command.count(After) || command.count(Sort) || command.count(Table) || command.count(Format) || command.empty()) {
+            std::vector<const Task*> tasks;
+            if (command.count(Since) || command.count(Until)) {
+                // 按时间区间查询, 两端都包含; 结果按时间排序
+                std::time_t from = std::numeric_limits<std::time_t>::min();
+                std::time_t to = std::numeric_limits<std::time_t>::max();
+                std::string_view by = command.count(By) ? command.value(By) : "updated";
+                if (by != "created" && by != "updated") {
+                    std::cerr << "错误: --by 只能是 created 或 updated。" << std::endl;
+                    return 1;
                 }
-                else if (task) {
-                    print_updated_task(task);
+                if ((command.count(Since) && !parse_time(std::string(command.value(Since)), from))
+                    || (command.count(Until) && !parse_time(std::string(command.value(Until)), to))) {
+                    std::cerr << "错误: 无法识别的时间。请使用时间戳, 2h 之类的相对时间, 或 2024-05-01[T10:30]。" << std::endl;
+                    return 1;
                 }
-                else if (updated) {
-                    // task  nullptr  updated  true (e.g. θ)
-                    // »ȡӡ
-                    print_updated_task(manager.get_task(id));
+                tasks = manager.list_tasks_between(by == "created" ? TimeField::Created : TimeField::Updated, from, to);
+                if (command.count(Status)) {
+                    TaskStatus statu;
+                    if (!parse_status(command.value(Status), statu)) {
+                        std::cerr << "错误: 无效的状态值 '" << command.value(Status) << "'。请使用 TO_DO, IN_PROGRESS, 或 DONE。" << std::endl;
+                        return 1;
+                    }
+                    std::erase_if(tasks, [statu](const Task* task) { return task->get_status() != statu; });
                 }
             }
-
-            // ---  (List - Ĭ) ---
-            // ûṩκƥĬΪ list
-            else if (result.count("list") || result.arguments().empty()) {
-                std::vector<const Task*> tasks;
-                if (result.count("status")) {
-                    std::string status_str = result["status"].as<std::string>();
-                    try {
-                        TaskStatus statu = string_to_status(status_str);
-                        tasks = manager.list_tasks(statu);
+            else if (command.count(Limit) || command.count(After) || command.count(Sort)) {
+                // 分页列出: 只取一页, 多取一个用来判断后面还有没有
+                ListOrder order;
+                if (command.count(Sort) && !parse_sort(std::string(command.value(Sort)), order)) {
+                    std::cerr << "错误: --sort 只能是 id, created 或 updated, 可以加 :asc 或 :desc。" << std::endl;
+                    return 1;
+                }
+                std::optional<TaskCursor> after;
+                if (command.count(After)) {
+                    TaskCursor cursor;
+                    if (!parse_cursor(std::string(command.value(After)), order.key, cursor)) {
+                        std::cerr << "错误: 无效的游标。请使用上一页末尾给出的值, 并保持相同的 --sort。" << std::endl;
+                        return 1;
                     }
-                    catch (const std::invalid_argument&) {
-                        std::cerr << ": Ч״ֵ̬ '" << status_str << "'ʹ TO_DO, IN_PROGRESS,  DONE" << std::endl;
-                        continue; // ӡ
+                    after = cursor;
+                }
+                std::optional<TaskStatus> statu;
+                if (command.count(Status)) {
+                    TaskStatus parsed;
+                    if (!parse_status(command.value(Status), parsed)) {
+                        std::cerr << "错误: 无效的状态值 '" << command.value(Status) << "'。请使用 TO_DO, IN_PROGRESS, 或 DONE。" << std::endl;
+                        return 1;
                     }
+                    statu = parsed;
                 }
-                else {
-                    tasks = manager.list_tasks();
+                std::size_t limit = std::numeric_limits<std::size_t>::max() - 1;
+                if (command.count(Limit)) {
+                    int value = command.integer(Limit);
+                    if (value <= 0) {
+                        std::cerr << "错误: --limit 必须是正整数。" << std::endl;
+                        return 1;
+                    }
+                    limit = static_cast<std::size_t>(value);
+                }
+                tasks = manager.list_tasks(order, limit + 1, after, statu);
+                bool more = tasks.size() > limit;
+                if (more) {
+                    tasks.pop_back();
+                }
+                print_tasks(tasks, style);
+                if (more) {
+                    // 给出下一页的完整命令, 可以直接复制
+                    std::string next = "--limit " + std::to_string(limit)
+                        + " --after " + format_cursor(TaskCursor::after(*tasks.back(), order.key), order.key);
+                    if (command.count(Sort)) {
+                        next += " --sort " + std::string(command.value(Sort));
+                    }
+                    if (statu) {
+                        next += " --status " + status_to_string(*statu);
+                    }
+                    std::cout << "还有更多任务。下一页: " << next << std::endl;
+                }
+                return 0;
+            }
+            else if (command.count(Status)) {
+                std::string status_str(command.value(Status));
+                try {
+                    TaskStatus statu = string_to_status(status_str);
+                    tasks = manager.list_tasks(statu);
+                }
+                catch (const std::invalid_argument&) {
+                    std::cerr << "错误: 无效的状态值 '" << status_str << "'。请使用 TO_DO, IN_PROGRESS, 或 DONE。" << std::endl;
+                    return 1; // 跳过打印
                 }
-                print_tasks(tasks);
             }
             else {
-                    std::cerr << "δ֪ 'help' 鿴ѡ" << std::endl;
-			}
-
+                tasks = manager.list_tasks();
+            }
+            print_tasks(tasks, style);
         }
-        catch (const std::exception& e) {
-            std::cerr << "ʱ: " << e.what() << std::endl;
-            //  REPL ѭ
+        else {
+            std::cerr << "未知命令。输入 'help' 查看可用选项。" << std::endl;
+            return 2;
         }
-    } //  while(true)
+    }
+    catch (const std::exception& e) {
+        std::cerr << "程序运行时发生错误: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
 
-    std::cout << "˳..." << std::endl;
+
+// 解析并执行一行 REPL 语法的命令; 遇到 exit 或 quit 时设置 quit。
+// 命令行直接在 line 中切分和解析 (不复制), 所以 line 会被修改
+static int run_line(TaskManager& manager, cxxopts::Options& options, std::string& line, bool interactive,
+    bool& quit, bool in_script = false) {
+    CommandLexer lexer(line);
+    std::string_view first;
+    if (!lexer.peek(first)) {
+        return 0;
+    }
+
+    // 检查 REPL 的特殊命令
+    if (first == "exit" || first == "quit") {
+        quit = true;
+        return 0;
+    }
+    if (first == "help") {
+        // 如果用户输入 'help'，手动显示 cxxopts 的帮助信息
+        std::cout << options.help() << std::endl;
+        return 0;
+    }
+
+    // 语法与 cxxopts 相同 (cxxopts 只用来生成帮助信息)
+    ParsedCommand command;
+    try {
+        command = parse_command(lexer);
+    }
+    catch (const CommandLineError& e) {
+        std::cerr << "错误: " << e.what() << std::endl;
+        std::cerr << "输入 'help' 查看可用选项。" << std::endl;
+        return 2;
+    }
+    return run_command(manager, options, command, interactive, in_script);
+}
+
+// 依次执行脚本的每一行 (语法同 REPL, 忽略空行和 # 开头的注释)。整个脚本是一个批处理,
+// 最后只写一次盘; 某条命令失败时立即停止并放弃脚本中的所有修改, 返回该命令的退出码。
+// 在 REPL 的 --begin 之后运行时, 脚本是其中的内层批处理, 失败时外层的修改保留
+static int run_script(TaskManager& manager, cxxopts::Options& options, const std::string& path) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        std::cerr << "错误: 无法打开脚本 " << path << std::endl;
+        return 1;
+    }
+    manager.begin_batch();
+    int level = manager.batch_level();
+    std::string line;
+    std::size_t number = 0;
+    while (std::getline(file, line)) {
+        number++;
+        std::size_t first = line.find_first_not_of(" \t\r");
+        if (first == std::string::npos || line[first] == '#') {
+            continue;
+        }
+        bool quit = false;
+        int code = run_line(manager, options, line, false, quit, true);
+        if (code != 0) {
+            manager.rollback_to(level);
+            std::cerr << path << ":" << number << ": 命令失败, 脚本中的修改已全部放弃。" << std::endl;
+            return code;
+        }
+        if (quit) {
+            break;
+        }
+    }
+    // 在外层批处理中运行时只结束脚本自己的一层, 修改随外层一起提交
+    manager.commit();
     return 0;
-}
\ No newline at end of file
+}
+
+// 标准输入是否是终端; 从管道读入命令时不打印欢迎信息和提示符
+static bool stdin_is_terminal() {
+#ifdef _WIN32
+    return _isatty(_fileno(stdin)) != 0;
+#else
+    return isatty(fileno(stdin)) != 0;
+#endif
+}
+
+// 打开 tasks.json; 无法安全打开时 (例如 journal 中间有损坏的记录) 报告原因, 返回 nullptr
+static std::unique_ptr<TaskManager> open_store(const TaskManagerOptions& store_options) {
+    try {
+        return std::make_unique<TaskManager>("tasks.json", store_options);
+    }
+    catch (const std::exception& e) {
+        std::cerr << "错误: 无法打开任务存储: " << e.what() << std::endl;
+        return nullptr;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    // 设置 cxxopts (只一次), 只用来打印帮助信息
+    // 命令行参数和 REPL 中的每一行由 parse_command 解析, 这里的选项必须与 command_line.cpp 中的选项表一致
+    cxxopts::Options options("task-cli",
+        "一个 C++ 任务管理器。\n"
+        "在 > 提示符后输入命令选项 (例如 --add \"新任务\"),\n"
+        "或者直接在命令行上执行一条命令 (例如 task-tracker --add \"新任务\")");
+
+    options.add_options()
+        ("l,list", "列出所有任务 (默认操作)")
+        ("g,get", "按 ID 获取单个任务", cxxopts::value<int>(), "<任务ID>")
+        ("a,add", "添加一个新任务", cxxopts::value<std::string>(), "<任务描述>")
+        ("r,remove", "按 ID 删除一个任务", cxxopts::value<int>(), "<任务ID>")
+        ("search", "搜索描述中包含所有关键词的任务 (词尾加 * 匹配前缀, 例如 \"deploy check*\")", cxxopts::value<std::string>(), "<关键词>")
+        ("u,update", "按 ID 更新一个任务 (必须配合 --desc 或 --status)", cxxopts::value<int>(), "<任务ID>")
+        ("r-last", "删除最后添加的任务")
+		("c,clear", "清除所有任务")
+        ("begin", "开始批处理: 之后的修改只保存在内存中, 直到 --commit")
+        ("commit", "提交批处理, 一次性写入磁盘")
+        ("rollback", "放弃批处理中的所有修改")
+        ("d,desc", "设置新的任务描述 (配合 --update)", cxxopts::value<std::string>())
+        ("s,status", "设置新的任务状态 (TO_DO, IN_PROGRESS, DONE)", cxxopts::value<std::string>())
+        ("since", "只列出此时间之后的任务: 时间戳, 2h 之类的相对时间, 或 2024-05-01[T10:30]", cxxopts::value<std::string>(), "<时间>")
+        ("until", "只列出此时间之前的任务 (格式同 --since)", cxxopts::value<std::string>(), "<时间>")
+        ("by", "--since/--until 比较的时间: created 或 updated (默认)", cxxopts::value<std::string>(), "<字段>")
+        ("limit", "每页最多列出的任务数", cxxopts::value<int>(), "<数量>")
+        ("after", "从上一页末尾给出的游标之后继续列出", cxxopts::value<std::string>(), "<游标>")
+        ("table", "列表时每个任务只占一行")
+        ("format", "输出格式: text (默认), table, jsonl, csv 或 tsv", cxxopts::value<std::string>(), "<格式>")
+        ("export", "把任务逐条写入文件 (默认 jsonl 格式, 可配合 --format 和 --status)", cxxopts::value<std::string>(), "<文件>")
+        ("import", "从 jsonl, csv 或 tsv 文件批量导入任务 (格式自动识别, 也可用 --format 指定)", cxxopts::value<std::string>(), "<文件>")
+        ("remap-ids", "导入时从下一个 id 开始重新编号, 而不是保留文件中的 id")
+        ("script", "依次执行文件中的命令 (每行一条, 语法同 REPL), 最后一次性写盘; 有命令失败时放弃全部修改 (脚本中不能使用 --begin, --commit 和 --rollback)", cxxopts::value<std::string>(), "<文件>")
+        ("yes", "不询问确认 (非交互模式下 --clear 必须加上)")
+        ("sort", "排序: id (默认), created 或 updated, 加 :desc 倒序 (例如 updated:desc)", cxxopts::value<std::string>(), "<字段>")
+        ("h,help", "打印帮助信息");
+
+    // 启动时映射快照; 二进制快照只解析元数据, 描述留在映射的文件中, 用到时才读入
+    TaskManagerOptions store_options;
+    store_options.memory_map = true;
+
+    // 带参数运行时只执行这一条命令 (例如 --add "x" 或 --script 文件), 用退出码报告结果
+    if (argc > 1) {
+        ParsedCommand command;
+        try {
+            command = parse_command(argc, argv);
+        }
+        catch (const CommandLineError& e) {
+            std::cerr << "错误: " << e.what() << std::endl;
+            return 2;
+        }
+        std::unique_ptr<TaskManager> store = open_store(store_options);
+        if (!store) {
+            return 1;
+        }
+        TaskManager& manager = *store;
+        int code = run_command(manager, options, command, false);
+        if (manager.in_batch()) {
+            std::cerr << "警告: 未提交的批处理已被丢弃。" << std::endl;
+        }
+        return code;
+    }
+
+    //  初始化 TaskManager (只一次)
+    // 由后台线程写盘, 提示符不必等待磁盘 I/O; 退出时会等待写入完成
+    store_options.async_persistence = true;
+    std::unique_ptr<TaskManager> store = open_store(store_options);
+    if (!store) {
+        return 1;
+    }
+    TaskManager& manager = *store;
+
+    // 打印欢迎信息
+    bool terminal = stdin_is_terminal();
+    if (terminal) {
+        std::cout << "欢迎使用交互式任务管理器。" << std::endl;
+        std::cout << "输入 'help' 查看命令, 'exit' 或 'quit' 退出。" << std::endl;
+        std::cout << "---" << std::endl;
+    }
+
+    // 管道输入时以最后一条失败命令的退出码退出
+    int status = 0;
+    std::string line;
+    while (true) {
+        if (terminal) {
+            std::cout << "> ";
+        }
+        if (!std::getline(std::cin, line)) {
+            break; // EOF (例如 Ctrl+D 或 Ctrl+Z)
+        }
+        bool quit = false;
+        int code = run_line(manager, options, line, terminal, quit);
+        if (code != 0) {
+            status = code;
+        }
+        if (quit) {
+            break;
+        }
+    } // 结束 while(true)
+
+    if (manager.in_batch()) {
+        std::cerr << "警告: 未提交的批处理已被丢弃。" << std::endl;
+    }
+    if (terminal) {
+        std::cout << "正在退出..." << std::endl;
+    }
+    return terminal ? 0 : status;
+}
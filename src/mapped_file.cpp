@@ -0,0 +1,84 @@
+#include "mapped_file.h"
+#include <stdexcept>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+
+MappedFile::MappedFile(const std::string& path) {
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		throw std::runtime_error("Could not open file for mapping: " + path);
+	}
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size)) {
+		CloseHandle(file);
+		throw std::runtime_error("Could not stat file for mapping: " + path);
+	}
+	file_handle = file;
+	length = static_cast<std::size_t>(size.QuadPart);
+	if (length == 0) {
+		return; // empty files cannot be mapped
+	}
+	mapping_handle = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mapping_handle == nullptr) {
+		CloseHandle(file);
+		throw std::runtime_error("Could not map file: " + path);
+	}
+	data = static_cast<const char*>(MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0));
+	if (data == nullptr) {
+		CloseHandle(mapping_handle);
+		CloseHandle(file);
+		throw std::runtime_error("Could not map file: " + path);
+	}
+}
+
+MappedFile::~MappedFile() {
+	if (data) {
+		UnmapViewOfFile(data);
+	}
+	if (mapping_handle) {
+		CloseHandle(mapping_handle);
+	}
+	if (file_handle) {
+		CloseHandle(file_handle);
+	}
+}
+
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFile::MappedFile(const std::string& path) {
+	int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0) {
+		throw std::runtime_error("Could not open file for mapping: " + path);
+	}
+	struct stat st;
+	if (::fstat(fd, &st) != 0) {
+		::close(fd);
+		throw std::runtime_error("Could not stat file for mapping: " + path);
+	}
+	length = static_cast<std::size_t>(st.st_size);
+	if (length > 0) {
+		void* addr = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (addr == MAP_FAILED) {
+			::close(fd);
+			throw std::runtime_error("Could not map file: " + path);
+		}
+		data = static_cast<const char*>(addr);
+	}
+	// The mapping keeps the file contents alive on its own
+	::close(fd);
+}
+
+MappedFile::~MappedFile() {
+	if (data) {
+		::munmap(const_cast<char*>(data), length);
+	}
+}
+#endif
@@ -0,0 +1,54 @@
+#include "parallel.h"
+#include <algorithm>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+unsigned resolve_threads(unsigned threads) {
+	if (threads == 0) {
+		threads = std::thread::hardware_concurrency();
+	}
+	return std::max(threads, 1u);
+}
+
+std::size_t parallel_chunks(std::size_t count, unsigned threads, std::size_t min_chunk) {
+	std::size_t chunks = std::min<std::size_t>(resolve_threads(threads), count / std::max<std::size_t>(min_chunk, 1));
+	return std::max<std::size_t>(chunks, 1);
+}
+
+void parallel_for(std::size_t count, unsigned threads, std::size_t min_chunk,
+	const std::function<void(std::size_t chunk, std::size_t begin, std::size_t end)>& fn) {
+	std::size_t chunks = parallel_chunks(count, threads, min_chunk);
+	if (chunks == 1) {
+		fn(0, 0, count);
+		return;
+	}
+
+	std::exception_ptr error;
+	std::mutex error_mutex;
+	auto run = [&](std::size_t chunk) {
+		try {
+			fn(chunk, count * chunk / chunks, count * (chunk + 1) / chunks);
+		}
+		catch (...) {
+			std::lock_guard<std::mutex> lock(error_mutex);
+			if (!error) {
+				error = std::current_exception();
+			}
+		}
+	};
+
+	std::vector<std::thread> workers;
+	workers.reserve(chunks - 1);
+	for (std::size_t chunk = 1; chunk < chunks; chunk++) {
+		workers.emplace_back(run, chunk);
+	}
+	run(0);
+	for (std::thread& worker : workers) {
+		worker.join();
+	}
+	if (error) {
+		std::rethrow_exception(error);
+	}
+}
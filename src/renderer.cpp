@@ -0,0 +1,297 @@
+#include "renderer.h"
+#include "snapshot.h"
+#include <algorithm>
+#include <charconv>
+#include <mutex>
+
+static constexpr std::string_view week_days[] = { "Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat" };
+static constexpr std::string_view months[] = {
+	"Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"
+};
+static constexpr std::string_view detail_rule = "-------------------------\n";
+static constexpr std::string_view list_rule = "------------------------\n";
+static constexpr std::size_t id_width = 6;
+static constexpr std::size_t status_width = 11;
+static constexpr std::size_t time_width = 16;
+
+bool parse_render_style(std::string_view name, RenderStyle& style) {
+	static constexpr std::pair<std::string_view, RenderStyle> names[] = {
+		{ "text", RenderStyle::Detailed }, { "table", RenderStyle::Table }, { "jsonl", RenderStyle::JsonLines },
+		{ "csv", RenderStyle::Csv }, { "tsv", RenderStyle::Tsv }
+	};
+	for (const auto& [candidate, value] : names) {
+		if (name == candidate) {
+			style = value;
+			return true;
+		}
+	}
+	return false;
+}
+
+static void append_number(std::string& out, long long value) {
+	char digits[24];
+	auto result = std::to_chars(digits, digits + sizeof(digits), value);
+	out.append(digits, result.ptr);
+}
+
+static void append_two_digits(std::string& out, int value) {
+	out += static_cast<char>('0' + value / 10 % 10);
+	out += static_cast<char>('0' + value % 10);
+}
+
+static void to_local(std::time_t time, std::tm& out) {
+#ifdef _WIN32
+	localtime_s(&out, &time);
+#else
+	localtime_r(&time, &out);
+#endif
+}
+
+const std::tm& TimestampCache::local(std::time_t time) {
+	if (valid && time >= hour_start && time - hour_start < 3600) {
+		int offset = static_cast<int>(time - hour_start);
+		current = hour_tm;
+		current.tm_min = offset / 60;
+		current.tm_sec = offset % 60;
+		return current;
+	}
+	miss_count++;
+	to_local(time, current);
+	hour_start = time - current.tm_min * 60 - current.tm_sec;
+	hour_tm = current;
+	hour_tm.tm_min = 0;
+	hour_tm.tm_sec = 0;
+
+	// With the same offset throughout, the hour starts at :00:00 and ends at
+	// :59:59 of the same local hour
+	std::tm first{}, last{};
+	to_local(hour_start, first);
+	to_local(hour_start + 3599, last);
+	auto same_hour = [this](const std::tm& tm) {
+		return tm.tm_hour == hour_tm.tm_hour && tm.tm_mday == hour_tm.tm_mday && tm.tm_mon == hour_tm.tm_mon
+			&& tm.tm_year == hour_tm.tm_year;
+	};
+	valid = same_hour(first) && first.tm_min == 0 && first.tm_sec == 0
+		&& same_hour(last) && last.tm_min == 59 && last.tm_sec == 59;
+	return current;
+}
+
+void TimestampCache::append_asctime(std::string& out, std::time_t time) {
+	const std::tm& tm = local(time);
+	out += week_days[tm.tm_wday];
+	out += ' ';
+	out += months[tm.tm_mon];
+	out += tm.tm_mday < 10 ? "  " : " ";
+	append_number(out, tm.tm_mday);
+	out += ' ';
+	append_two_digits(out, tm.tm_hour);
+	out += ':';
+	append_two_digits(out, tm.tm_min);
+	out += ':';
+	append_two_digits(out, tm.tm_sec);
+	out += ' ';
+	append_number(out, tm.tm_year + 1900);
+	out += '\n';
+}
+
+void TimestampCache::append_short(std::string& out, std::time_t time) {
+	const std::tm& tm = local(time);
+	append_number(out, tm.tm_year + 1900);
+	out += '-';
+	append_two_digits(out, tm.tm_mon + 1);
+	out += '-';
+	append_two_digits(out, tm.tm_mday);
+	out += ' ';
+	append_two_digits(out, tm.tm_hour);
+	out += ':';
+	append_two_digits(out, tm.tm_min);
+}
+
+void TaskRenderer::append_padded(std::string_view text, std::size_t width) {
+	buffer += text;
+	if (text.size() < width) {
+		buffer.append(width - text.size(), ' ');
+	}
+}
+
+void TaskRenderer::append_detailed(const Task& task) {
+	buffer += detail_rule;
+	buffer += "Task ID: ";
+	append_number(buffer, task.get_id());
+	buffer += "\nDescription: ";
+	buffer += task.get_description();
+	buffer += "\nStatus: ";
+	buffer += status_to_string(task.get_status());
+	buffer += "\nCreated At: ";
+	times.append_asctime(buffer, task.get_created_at());
+	buffer += "Updated At: ";
+	times.append_asctime(buffer, task.get_updated_at());
+	buffer += detail_rule;
+}
+
+void TaskRenderer::append_row(const Task& task) {
+	char digits[16];
+	auto result = std::to_chars(digits, digits + sizeof(digits), task.get_id());
+	std::size_t length = static_cast<std::size_t>(result.ptr - digits);
+	if (length < id_width) {
+		buffer.append(id_width - length, ' ');
+	}
+	buffer.append(digits, result.ptr);
+	buffer += "  ";
+	append_padded(status_to_string(task.get_status()), status_width);
+	buffer += "  ";
+	times.append_short(buffer, task.get_created_at());
+	buffer += "  ";
+	times.append_short(buffer, task.get_updated_at());
+	buffer += "  ";
+	// A line break in a description would split the row.
+	std::size_t start = buffer.size();
+	buffer += task.get_description();
+	for (std::size_t i = start; i < buffer.size(); i++) {
+		if (buffer[i] == '\n' || buffer[i] == '\r') {
+			buffer[i] = ' ';
+		}
+	}
+	buffer += '\n';
+}
+
+void TaskRenderer::append_field(std::string_view text) {
+	// Plain descriptions are copied whole; a plain loop finds the special
+	// characters several times faster than string_view::find_first_of.
+	if (style == RenderStyle::Tsv) {
+		auto special = [](char c) { return c == '\t' || c == '\n' || c == '\r' || c == '\\'; };
+		if (std::none_of(text.begin(), text.end(), special)) {
+			buffer += text;
+			return;
+		}
+		for (char c : text) {
+			if (special(c)) {
+				buffer += '\\';
+				c = c == '\t' ? 't' : c == '\n' ? 'n' : c == '\r' ? 'r' : '\\';
+			}
+			buffer += c;
+		}
+		return;
+	}
+	bool quoted = std::any_of(text.begin(), text.end(), [](char c) {
+		return c == ',' || c == '"' || c == '\r' || c == '\n';
+	});
+	if (!quoted) {
+		buffer += text;
+		return;
+	}
+	buffer += '"';
+	std::size_t start = 0, at;
+	while ((at = text.find('"', start)) != std::string_view::npos) {
+		buffer.append(text, start, at + 1 - start);
+		buffer += '"';
+		start = at + 1;
+	}
+	buffer.append(text, start);
+	buffer += '"';
+}
+
+void TaskRenderer::append_record(const Task& task) {
+	if (style == RenderStyle::JsonLines) {
+		buffer += "{\"id\":";
+		append_number(buffer, task.get_id());
+		buffer += ",\"description\":";
+		append_json_string(buffer, task.get_description());
+		buffer += ",\"status\":\"";
+		buffer += status_to_string(task.get_status());
+		buffer += "\",\"created_at\":";
+		append_number(buffer, task.get_created_at());
+		buffer += ",\"updated_at\":";
+		append_number(buffer, task.get_updated_at());
+		buffer += "}\n";
+		return;
+	}
+	char separator = style == RenderStyle::Tsv ? '\t' : ',';
+	append_number(buffer, task.get_id());
+	buffer += separator;
+	append_field(task.get_description());
+	buffer += separator;
+	buffer += status_to_string(task.get_status());
+	buffer += separator;
+	append_number(buffer, task.get_created_at());
+	buffer += separator;
+	append_number(buffer, task.get_updated_at());
+	buffer += style == RenderStyle::Csv ? "\r\n" : "\n";
+}
+
+void TaskRenderer::append(const Task* task) {
+	if (task == nullptr) {
+		buffer += "Task is null.\n";
+	}
+	else if (style == RenderStyle::Detailed) {
+		append_detailed(*task);
+	}
+	else if (style == RenderStyle::Table) {
+		append_row(*task);
+	}
+	else {
+		append_record(*task);
+	}
+}
+
+void TaskRenderer::append_header() {
+	switch (style) {
+	case RenderStyle::Table:
+		buffer.append(id_width - 2, ' ');
+		buffer += "ID  ";
+		append_padded("STATUS", status_width);
+		buffer += "  ";
+		append_padded("CREATED", time_width);
+		buffer += "  ";
+		append_padded("UPDATED", time_width);
+		buffer += "  DESCRIPTION\n";
+		break;
+	case RenderStyle::Csv:
+		buffer += "id,description,status,created_at,updated_at\r\n";
+		break;
+	case RenderStyle::Tsv:
+		buffer += "id\tdescription\tstatus\tcreated_at\tupdated_at\n";
+		break;
+	default:
+		break;
+	}
+}
+
+void TaskRenderer::append_listed(const Task* task, std::ostream& out) {
+	append(task);
+	if (style == RenderStyle::Detailed) {
+		buffer += list_rule;
+	}
+	if (buffer.size() >= flush_threshold) {
+		write(out);
+	}
+}
+
+void TaskRenderer::append_tasks(const std::vector<const Task*>& tasks, std::ostream& out) {
+	if (tasks.empty() && is_human_readable(style)) {
+		buffer += "No tasks to display.\n";
+		return;
+	}
+	append_header();
+	for (const Task* task : tasks) {
+		append_listed(task, out);
+	}
+}
+
+void TaskRenderer::append_line(std::string_view line) {
+	buffer += line;
+	buffer += '\n';
+}
+
+void TaskRenderer::write(std::ostream& out) {
+	if (buffer.empty()) {
+		return;
+	}
+	static std::mutex write_mutex;
+	{
+		std::lock_guard<std::mutex> lock(write_mutex);
+		out.write(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+		out.flush();
+	}
+	buffer.clear();
+}
@@ -0,0 +1,107 @@
+#include "shard_set.h"
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <nlohmann/json.hpp>
+
+// Written first and without whitespace, so a manifest is recognized by its
+// first bytes.
+static constexpr std::string_view manifest_prefix = "{\"shard_manifest\":";
+
+ShardSet::ShardSet(std::string manifest_path, std::size_t shard_size)
+	: manifest_path(std::move(manifest_path)), shard_size(shard_size) {
+}
+
+std::int64_t ShardSet::shard_of(int id) const {
+	std::int64_t size = static_cast<std::int64_t>(shard_size);
+	std::int64_t value = id;
+	return value >= 0 ? value / size : -((-value + size - 1) / size);
+}
+
+std::string ShardSet::path(std::int64_t index) const {
+	return manifest_path + ".shard" + std::to_string(index);
+}
+
+bool ShardSet::all_loaded() const {
+	for (const auto& [index, shard] : shards) {
+		if (shard.listed && !shard.loaded) {
+			return false;
+		}
+	}
+	return true;
+}
+
+std::size_t ShardSet::unloaded_count() const {
+	std::size_t count = 0;
+	for (const auto& [index, shard] : shards) {
+		if (shard.listed && !shard.loaded) {
+			count += shard.counts[0] + shard.counts[1] + shard.counts[2];
+		}
+	}
+	return count;
+}
+
+std::size_t ShardSet::unloaded_count(std::size_t status_slot) const {
+	std::size_t count = 0;
+	for (const auto& [index, shard] : shards) {
+		if (shard.listed && !shard.loaded) {
+			count += shard.counts[status_slot];
+		}
+	}
+	return count;
+}
+
+bool ShardSet::read_manifest(const std::string& path, std::string& manifest) {
+	std::ifstream file(path, std::ios::binary);
+	if (!file.is_open()) {
+		return false;
+	}
+	char head[manifest_prefix.size()] = {};
+	file.read(head, sizeof(head));
+	if (std::string_view(head, static_cast<std::size_t>(file.gcount())) != manifest_prefix) {
+		return false;
+	}
+	file.seekg(0, std::ios::beg);
+	manifest.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	return true;
+}
+
+void ShardSet::decode(std::string_view manifest, int& next_id) {
+	try {
+		nlohmann::json root = nlohmann::json::parse(manifest);
+		if (root.at("shard_manifest").get<int>() != 1) {
+			throw std::runtime_error("Unsupported shard manifest version");
+		}
+		shard_size = root.at("shard_size").get<std::size_t>();
+		if (shard_size == 0) {
+			throw std::runtime_error("Shard manifest has a shard size of 0");
+		}
+		generation = root.at("generation").get<std::uint64_t>();
+		next_id = root.at("next_id").get<int>();
+		shards.clear();
+		for (const nlohmann::json& item : root.at("shards")) {
+			Shard& shard = shards[item.at("index").get<std::int64_t>()];
+			shard.listed = true;
+			shard.counts = item.at("counts").get<std::array<std::size_t, 3>>();
+		}
+	}
+	catch (const nlohmann::json::exception& e) {
+		throw std::runtime_error(std::string("Malformed shard manifest: ") + e.what());
+	}
+}
+
+std::string ShardSet::encode(int next_id) {
+	nlohmann::ordered_json root;
+	root["shard_manifest"] = 1;
+	root["shard_size"] = shard_size;
+	root["generation"] = ++generation;
+	root["next_id"] = next_id;
+	nlohmann::ordered_json list = nlohmann::ordered_json::array();
+	for (const auto& [index, shard] : shards) {
+		if (shard.listed) {
+			list.push_back({ {"index", index}, {"counts", shard.counts} });
+		}
+	}
+	root["shards"] = std::move(list);
+	return root.dump() + '\n';
+}
@@ -0,0 +1,723 @@
+#include "snapshot.h"
+#include "json_scanner.h"
+#include "parallel.h"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <deque>
+#include <limits>
+#include <stdexcept>
+#include <nlohmann/json.hpp>
+
+static void store_u32(char* out, std::uint32_t value) {
+	for (int i = 0; i < 4; i++) {
+		out[i] = static_cast<char>((value >> (8 * i)) & 0xff);
+	}
+}
+
+static void store_u64(char* out, std::uint64_t value) {
+	for (int i = 0; i < 8; i++) {
+		out[i] = static_cast<char>((value >> (8 * i)) & 0xff);
+	}
+}
+
+static std::uint32_t get_u32(const char* in) {
+	std::uint32_t value = 0;
+	for (int i = 3; i >= 0; i--) {
+		value = (value << 8) | static_cast<unsigned char>(in[i]);
+	}
+	return value;
+}
+
+static std::uint64_t get_u64(const char* in) {
+	std::uint64_t value = 0;
+	for (int i = 7; i >= 0; i--) {
+		value = (value << 8) | static_cast<unsigned char>(in[i]);
+	}
+	return value;
+}
+
+// FNV-1a over the bytes of each word
+void SnapshotFingerprint::mix(std::uint64_t word) {
+	for (int i = 0; i < 8; i++) {
+		hash ^= (word >> (8 * i)) & 0xff;
+		hash *= 1099511628211ull;
+	}
+}
+
+void SnapshotFingerprint::add(int id, TaskStatus status, std::time_t created_at, std::time_t updated_at,
+	std::size_t length) {
+	mix(static_cast<std::uint64_t>(static_cast<std::int64_t>(id)));
+	mix(static_cast<std::uint64_t>(status));
+	mix(static_cast<std::uint64_t>(static_cast<std::int64_t>(created_at)));
+	mix(static_cast<std::uint64_t>(static_cast<std::int64_t>(updated_at)));
+	mix(length);
+	count++;
+}
+
+std::uint64_t SnapshotFingerprint::value() const {
+	SnapshotFingerprint last = *this;
+	last.mix(count);
+	return last.hash;
+}
+
+std::uint64_t snapshot_fingerprint(const std::vector<const Task*>& tasks) {
+	SnapshotFingerprint fingerprint;
+	for (const Task* task : tasks) {
+		fingerprint.add(*task);
+	}
+	return fingerprint.value();
+}
+
+SnapshotFormat format_for_path(const std::string& path) {
+	std::size_t dot = path.find_last_of('.');
+	if (dot == std::string::npos) {
+		return SnapshotFormat::Json;
+	}
+	std::string ext = path.substr(dot + 1);
+	std::transform(ext.begin(), ext.end(), ext.begin(),
+		[](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+	if (ext == "bin" || ext == "tdb") {
+		return SnapshotFormat::Binary;
+	}
+	return SnapshotFormat::Json;
+}
+
+bool is_binary_snapshot(std::string_view bytes) {
+	return bytes.size() >= sizeof(binary_snapshot::magic)
+		&& std::memcmp(bytes.data(), binary_snapshot::magic, sizeof(binary_snapshot::magic)) == 0;
+}
+
+// Tasks per chunk below which encoding or scanning on another thread costs
+// more than it saves.
+static constexpr std::size_t min_encode_chunk = 4096;
+static constexpr std::size_t min_scan_chunk = 1 << 20; // bytes
+
+std::string encode_binary_snapshot(int next_id, const std::vector<const Task*>& tasks, unsigned threads) {
+	// Description offsets first, so that every chunk knows where its bytes go
+	std::vector<std::uint64_t> offsets(tasks.size() + 1);
+	for (std::size_t i = 0; i < tasks.size(); i++) {
+		offsets[i + 1] = offsets[i] + tasks[i]->get_description().size();
+	}
+	std::uint64_t blob_size = offsets.back();
+
+	std::string out(binary_snapshot::header_size + tasks.size() * binary_snapshot::record_size + blob_size, '\0');
+	char* header = out.data();
+	std::memcpy(header, binary_snapshot::magic, sizeof(binary_snapshot::magic));
+	store_u32(header + 4, binary_snapshot::version);
+	store_u64(header + 8, tasks.size());
+	store_u64(header + 16, static_cast<std::uint64_t>(static_cast<std::int64_t>(next_id)));
+	store_u64(header + 24, blob_size);
+
+	char* records = header + binary_snapshot::header_size;
+	char* blob = records + tasks.size() * binary_snapshot::record_size;
+	parallel_for(tasks.size(), threads, min_encode_chunk, [&](std::size_t, std::size_t begin, std::size_t end) {
+		for (std::size_t i = begin; i < end; i++) {
+			const Task* task = tasks[i];
+			std::string_view description = task->get_description();
+			char* record = records + i * binary_snapshot::record_size;
+			store_u32(record, static_cast<std::uint32_t>(task->get_id()));
+			record[4] = static_cast<char>(task->get_status());
+			store_u64(record + 8, static_cast<std::uint64_t>(static_cast<std::int64_t>(task->get_created_at())));
+			store_u64(record + 16, static_cast<std::uint64_t>(static_cast<std::int64_t>(task->get_updated_at())));
+			store_u64(record + 24, offsets[i]);
+			store_u32(record + 32, static_cast<std::uint32_t>(description.size()));
+			std::memcpy(blob + offsets[i], description.data(), description.size());
+		}
+	});
+	return out;
+}
+
+static void append_integer(std::string& out, std::int64_t value) {
+	char digits[24];
+	auto [end, error] = std::to_chars(digits, digits + sizeof(digits), value);
+	out.append(digits, end);
+}
+
+void append_json_string(std::string& out, std::string_view text) {
+	bool plain = std::all_of(text.begin(), text.end(), [](char c) {
+		unsigned char u = static_cast<unsigned char>(c);
+		return u >= 0x20 && u < 0x80 && c != '"' && c != '\\';
+	});
+	if (plain) {
+		out.push_back('"');
+		out.append(text);
+		out.push_back('"');
+	}
+	else {
+		// Escapes and UTF-8 checks exactly as nlohmann::json does them
+		out.append(nlohmann::json(std::string(text)).dump());
+	}
+}
+
+// One element of the "tasks" array, laid out as nlohmann::json::dump(4)
+// does it: keys sorted, 8 spaces before the braces and 12 before the keys.
+static void append_json_task(std::string& out, const Task& task) {
+	out.append("        {\n            \"created_at\": ");
+	append_integer(out, task.get_created_at());
+	out.append(",\n            \"description\": ");
+	append_json_string(out, task.get_description());
+	out.append(",\n            \"id\": ");
+	append_integer(out, task.get_id());
+	out.append(",\n            \"status\": \"");
+	out.append(status_to_string(task.get_status()));
+	out.append("\",\n            \"updated_at\": ");
+	append_integer(out, task.get_updated_at());
+	out.append("\n        }");
+}
+
+std::string encode_json_snapshot(int next_id, const std::vector<const Task*>& tasks, unsigned threads) {
+	std::string out = "{\n    \"next_id\": ";
+	append_integer(out, next_id);
+	if (tasks.empty()) {
+		out.append(",\n    \"tasks\": []\n}");
+		return out;
+	}
+	out.append(",\n    \"tasks\": [\n");
+
+	// Chunks are written to their own strings in parallel and joined in order
+	std::vector<std::string> parts(parallel_chunks(tasks.size(), threads, min_encode_chunk));
+	parallel_for(tasks.size(), threads, min_encode_chunk, [&](std::size_t chunk, std::size_t begin, std::size_t end) {
+		std::string& part = parts[chunk];
+		part.reserve((end - begin) * 160);
+		for (std::size_t i = begin; i < end; i++) {
+			if (i != 0) {
+				part.append(",\n");
+			}
+			append_json_task(part, *tasks[i]);
+		}
+	});
+	std::size_t size = out.size() + 8;
+	for (const std::string& part : parts) {
+		size += part.size();
+	}
+	out.reserve(size);
+	for (const std::string& part : parts) {
+		out.append(part);
+	}
+	out.append("\n    ]\n}");
+	return out;
+}
+
+std::string encode_snapshot(SnapshotFormat format, int next_id, const std::vector<const Task*>& tasks, unsigned threads) {
+	if (format == SnapshotFormat::Binary) {
+		return encode_binary_snapshot(next_id, tasks, threads);
+	}
+	return encode_json_snapshot(next_id, tasks, threads);
+}
+
+void decode_binary_snapshot(std::string_view bytes, int& next_id,
+	const std::function<void(const SnapshotRecord&)>& emit) {
+	if (bytes.size() < binary_snapshot::header_size || !is_binary_snapshot(bytes)) {
+		throw std::runtime_error("Not a binary task snapshot");
+	}
+	const char* data = bytes.data();
+	std::uint32_t version = get_u32(data + 4);
+	if (version != binary_snapshot::version) {
+		throw std::runtime_error("Unsupported binary snapshot version " + std::to_string(version));
+	}
+	std::uint64_t count = get_u64(data + 8);
+	std::int64_t stored_next_id = static_cast<std::int64_t>(get_u64(data + 16));
+	std::uint64_t blob_size = get_u64(data + 24);
+	if (stored_next_id < 1 || stored_next_id > std::numeric_limits<int>::max()) {
+		throw std::runtime_error("Invalid next_id " + std::to_string(stored_next_id) + " in binary snapshot");
+	}
+
+	std::uint64_t available = bytes.size() - binary_snapshot::header_size;
+	if (count > available / binary_snapshot::record_size
+		|| blob_size != available - count * binary_snapshot::record_size) {
+		throw std::runtime_error("Truncated binary snapshot");
+	}
+
+	const char* records = data + binary_snapshot::header_size;
+	const char* blob = records + count * binary_snapshot::record_size;
+	std::int64_t max_id = 0;
+	for (std::uint64_t i = 0; i < count; i++) {
+		const char* record = records + i * binary_snapshot::record_size;
+		int id = static_cast<int>(get_u32(record));
+		unsigned char status = static_cast<unsigned char>(record[4]);
+		std::time_t created_at = static_cast<std::time_t>(static_cast<std::int64_t>(get_u64(record + 8)));
+		std::time_t updated_at = static_cast<std::time_t>(static_cast<std::int64_t>(get_u64(record + 16)));
+		std::uint64_t offset = get_u64(record + 24);
+		std::uint32_t length = get_u32(record + 32);
+
+		if (status > static_cast<unsigned char>(TaskStatus::DONE)) {
+			throw std::runtime_error("Invalid status in binary snapshot record for task " + std::to_string(id));
+		}
+		if (offset > blob_size || length > blob_size - offset) {
+			throw std::runtime_error("Description out of range in binary snapshot record for task " + std::to_string(id));
+		}
+		emit(SnapshotRecord{ id, static_cast<TaskStatus>(status), created_at, updated_at,
+			std::string_view(blob + offset, length) });
+		max_id = std::max<std::int64_t>(max_id, id);
+	}
+	// Like the JSON loaders, never hand out an id that is already taken,
+	// even when the stored next_id was edited or damaged
+	std::int64_t first_free = std::max(stored_next_id, max_id + 1);
+	if (first_free > std::numeric_limits<int>::max()) {
+		throw std::runtime_error("No free id after task " + std::to_string(max_id) + " in binary snapshot");
+	}
+	next_id = static_cast<int>(first_free);
+}
+
+// SAX handler that turns the "tasks" array of a tasks.json snapshot into
+// SnapshotRecords one object at a time. Depth 1 is the root object, depth 2
+// the tasks array and depth 3 a task record.
+class TaskRecordSax {
+
+public:
+	using number_integer_t = nlohmann::json::number_integer_t;
+	using number_unsigned_t = nlohmann::json::number_unsigned_t;
+	using number_float_t = nlohmann::json::number_float_t;
+	using string_t = nlohmann::json::string_t;
+	using binary_t = nlohmann::json::binary_t;
+
+	TaskRecordSax(int& next_id,
+		const std::function<void(const SnapshotRecord&)>& emit,
+		const std::function<void(const std::string&)>& report)
+		: next_id(next_id), emit(emit), report(report) {
+	}
+
+	bool null() { return scalar("null"); }
+	bool boolean(bool) { return scalar("a boolean"); }
+	bool number_integer(number_integer_t value) { return integer(value); }
+	bool number_unsigned(number_unsigned_t value) {
+		if (value > static_cast<number_unsigned_t>(std::numeric_limits<std::int64_t>::max())) {
+			return scalar("an out of range number");
+		}
+		return integer(static_cast<std::int64_t>(value));
+	}
+	bool number_float(number_float_t, const string_t&) { return scalar("a floating point number"); }
+	bool binary(binary_t&) { return scalar("binary data"); }
+
+	bool string(string_t& value) {
+		if (in_record()) {
+			if (current_key == "description") {
+				description = std::move(value);
+				has_description = true;
+				return true;
+			}
+			if (current_key == "status") {
+				if (!parse_status(value, status)) {
+					fail("field 'status' has invalid value '" + value + "'");
+				}
+				has_status = true;
+				return true;
+			}
+		}
+		return scalar("a string");
+	}
+
+	bool key(string_t& value) {
+		current_key = std::move(value);
+		return true;
+	}
+
+	bool start_object(std::size_t) {
+		depth++;
+		if (in_tasks && depth == 3) {
+			begin_record();
+		}
+		else if (in_tasks && depth == 4) {
+			nested("an object");
+		}
+		return true;
+	}
+
+	bool end_object() {
+		if (in_tasks && depth == 3) {
+			finish_record();
+		}
+		depth--;
+		return true;
+	}
+
+	bool start_array(std::size_t) {
+		depth++;
+		if (depth == 2 && current_key == "tasks") {
+			in_tasks = true;
+		}
+		else if (in_tasks && depth == 3) {
+			element_is_not_object();
+		}
+		else if (in_tasks && depth == 4) {
+			nested("an array");
+		}
+		return true;
+	}
+
+	bool end_array() {
+		if (in_tasks && depth == 2) {
+			in_tasks = false;
+		}
+		depth--;
+		return true;
+	}
+
+	bool parse_error(std::size_t position, const std::string&, const nlohmann::json::exception& e) {
+		report("syntax error at byte " + std::to_string(position) + " after " + std::to_string(records)
+			+ " task records: " + e.what());
+		return false;
+	}
+
+	void finish() {
+		// Never hand out an id that a loaded task already uses. Every id is
+		// below INT_MAX, so max_id + 1 still fits.
+		if (max_id >= next_id) {
+			next_id = max_id + 1;
+		}
+	}
+
+private:
+	int& next_id;
+	const std::function<void(const SnapshotRecord&)>& emit;
+	const std::function<void(const std::string&)>& report;
+
+	int depth = 0;
+	bool in_tasks = false;
+	std::string current_key;
+	std::size_t records = 0;
+	int max_id = 0;
+
+	// Fields of the record being read
+	std::int64_t id = 0;
+	std::string description;
+	TaskStatus status = TaskStatus::TO_DO;
+	std::int64_t created_at = 0;
+	std::int64_t updated_at = 0;
+	bool has_id = false, has_description = false, has_status = false;
+	std::string error;
+
+	bool in_record() const { return in_tasks && depth == 3; }
+
+	bool integer(std::int64_t value) {
+		if (depth == 1 && current_key == "next_id") {
+			// Kept within 1..INT_MAX; finish() still raises it above every id
+			if (value < 1 || value > std::numeric_limits<int>::max()) {
+				report("next_id " + std::to_string(value) + " is out of range; clamped");
+				value = std::clamp<std::int64_t>(value, 1, std::numeric_limits<int>::max());
+			}
+			next_id = static_cast<int>(value);
+			return true;
+		}
+		if (in_record()) {
+			if (current_key == "id") {
+				if (!valid_task_id(value)) {
+					fail("field 'id' is out of range");
+				}
+				id = value;
+				has_id = true;
+				return true;
+			}
+			if (current_key == "created_at") {
+				created_at = value;
+				return true;
+			}
+			if (current_key == "updated_at") {
+				updated_at = value;
+				return true;
+			}
+		}
+		return scalar("a number");
+	}
+
+	// A scalar where the handlers above did not expect one
+	bool scalar(const char* what) {
+		if (in_tasks && depth == 2) {
+			element_is_not_object();
+		}
+		else if (in_record() && is_task_field(current_key)) {
+			fail("field '" + current_key + "' must not be " + what);
+		}
+		return true;
+	}
+
+	void nested(const char* what) {
+		if (depth == 4 && is_task_field(current_key)) {
+			fail("field '" + current_key + "' must not be " + what);
+		}
+	}
+
+	static bool is_task_field(const std::string& name) {
+		return name == "id" || name == "description" || name == "status"
+			|| name == "created_at" || name == "updated_at";
+	}
+
+	void element_is_not_object() {
+		report("task record #" + std::to_string(records + 1) + " is not an object; skipped");
+		records++;
+	}
+
+	void fail(std::string message) {
+		if (error.empty()) {
+			error = std::move(message);
+		}
+	}
+
+	void begin_record() {
+		id = 0;
+		description.clear();
+		status = TaskStatus::TO_DO;
+		created_at = 0;
+		updated_at = 0;
+		has_id = has_description = has_status = false;
+		error.clear();
+	}
+
+	void finish_record() {
+		records++;
+		if (error.empty()) {
+			if (!has_id) fail("field 'id' is missing");
+			else if (!has_description) fail("field 'description' is missing");
+			else if (!has_status) fail("field 'status' is missing");
+		}
+		if (!error.empty()) {
+			std::string which = "task record #" + std::to_string(records);
+			if (has_id) {
+				which += " (id " + std::to_string(id) + ")";
+			}
+			report(which + ": " + error + "; skipped");
+			return;
+		}
+		int task_id = static_cast<int>(id);
+		max_id = std::max(max_id, task_id);
+		emit(SnapshotRecord{ task_id, status, static_cast<std::time_t>(created_at),
+			static_cast<std::time_t>(updated_at), description, false });
+	}
+};
+
+bool decode_json_snapshot(std::istream& input, int& next_id,
+	const std::function<void(const SnapshotRecord&)>& emit,
+	const std::function<void(const std::string&)>& report) {
+	TaskRecordSax sax(next_id, emit, report);
+	bool ok = nlohmann::json::sax_parse(input, &sax);
+	sax.finish();
+	return ok;
+}
+
+bool decode_json_snapshot(std::string_view bytes, int& next_id,
+	const std::function<void(const SnapshotRecord&)>& emit,
+	const std::function<void(const std::string&)>& report) {
+	TaskRecordSax sax(next_id, emit, report);
+	bool ok = nlohmann::json::sax_parse(bytes.begin(), bytes.end(), &sax);
+	sax.finish();
+	return ok;
+}
+
+// Reads one task object of the "tasks" array.
+static bool scan_task_record(JsonScanner& scanner, int& max_id,
+	const std::function<void(const SnapshotRecord&)>& emit) {
+	if (!scanner.consume('{')) {
+		return false;
+	}
+	std::int64_t id = 0, created_at = 0, updated_at = 0;
+	std::string_view description;
+	TaskStatus status = TaskStatus::TO_DO;
+	bool has_id = false, has_description = false, has_status = false, escaped = false;
+	if (!scanner.consume('}')) {
+		do {
+			std::string_view key;
+			bool escaped_key = false;
+			if (!scanner.string(key, escaped_key) || !scanner.consume(':')) {
+				return false;
+			}
+			bool ok = true;
+			if (key == "id") {
+				ok = scanner.integer(id) && valid_task_id(id);
+				has_id = true;
+			}
+			else if (key == "description") {
+				ok = scanner.string(description, escaped);
+				has_description = true;
+			}
+			else if (key == "status") {
+				std::string_view text;
+				bool escaped_status = false;
+				ok = scanner.string(text, escaped_status) && !escaped_status && parse_status(text, status);
+				has_status = true;
+			}
+			else if (key == "created_at") {
+				ok = scanner.integer(created_at);
+			}
+			else if (key == "updated_at") {
+				ok = scanner.integer(updated_at);
+			}
+			else {
+				ok = scanner.skip_value();
+			}
+			if (!ok) {
+				return false;
+			}
+		} while (scanner.consume(','));
+		if (!scanner.consume('}')) {
+			return false;
+		}
+	}
+	if (!has_id || !has_description || !has_status) {
+		return false;
+	}
+
+	int task_id = static_cast<int>(id);
+	max_id = std::max(max_id, task_id);
+	SnapshotRecord record{ task_id, status, static_cast<std::time_t>(created_at),
+		static_cast<std::time_t>(updated_at), description };
+	std::string decoded;
+	if (escaped) {
+		// Rare (quotes, backslashes, control characters): decode just this one
+		decoded = nlohmann::json::parse("\"" + std::string(description) + "\"").get<std::string>();
+		record.description = decoded;
+		record.in_place = false;
+	}
+	emit(record);
+	return true;
+}
+
+// A JSON string cannot hold a raw line break, so a '{' that starts a line
+// starts an object; in a pretty-printed snapshot that is a task record.
+static const char* next_record_line(const char* from, const char* end) {
+	while (const char* line_break = static_cast<const char*>(std::memchr(from, '\n', static_cast<std::size_t>(end - from)))) {
+		from = line_break + 1;
+		while (from != end && (*from == ' ' || *from == '\t' || *from == '\r')) {
+			from++;
+		}
+		if (from != end && *from == '{') {
+			return from;
+		}
+	}
+	return end;
+}
+
+// Records of one stretch of the "tasks" array, scanned on a worker thread.
+struct ScannedChunk {
+	std::vector<SnapshotRecord> records;
+	std::deque<std::string> decoded; // escaped descriptions; a deque keeps them in place
+	int max_id = 0;
+	const char* end = nullptr; // where scanning stopped
+	bool ok = false;
+};
+
+// Scans records from `begin` until the one that starts at `next`, or for the
+// last chunk (`next` null) until the end of the array.
+static void scan_task_chunk(const char* begin, const char* next, const char* end, ScannedChunk& chunk) {
+	JsonScanner scanner(std::string_view(begin, static_cast<std::size_t>(end - begin)));
+	auto keep = [&chunk](const SnapshotRecord& record) {
+		chunk.records.push_back(record);
+		if (!record.in_place) {
+			chunk.decoded.emplace_back(record.description);
+			chunk.records.back().description = chunk.decoded.back();
+		}
+	};
+	while (scan_task_record(scanner, chunk.max_id, keep)) {
+		bool more = scanner.consume(',');
+		const char* at = scanner.position();
+		if (next ? !more || at >= next : !more) {
+			// Anything but landing on the next chunk's first record means the
+			// split was not at a record after all
+			chunk.end = at;
+			chunk.ok = next ? more && at == next : !more;
+			return;
+		}
+	}
+}
+
+// Reads the elements of the "tasks" array and its closing bracket. A large
+// array is split at lines starting with '{' and the pieces are scanned in
+// parallel, then emitted in order. Chunk 0 starts at a real record, so if each
+// chunk ends exactly where the next one starts, every split was at a record.
+static bool scan_task_array(JsonScanner& scanner, const char* end, int& max_id,
+	const std::function<void(const SnapshotRecord&)>& emit, unsigned threads) {
+	if (scanner.consume(']')) {
+		return true;
+	}
+	const char* begin = scanner.position();
+	std::size_t size = static_cast<std::size_t>(end - begin);
+	std::size_t chunks = parallel_chunks(size, threads, min_scan_chunk);
+	std::vector<const char*> starts{ begin };
+	for (std::size_t chunk = 1; chunk < chunks; chunk++) {
+		const char* start = next_record_line(std::max(begin + size * chunk / chunks, starts.back()), end);
+		if (start == end) {
+			break;
+		}
+		starts.push_back(start);
+	}
+
+	if (starts.size() > 1) {
+		std::vector<ScannedChunk> scanned(starts.size());
+		parallel_for(starts.size(), static_cast<unsigned>(starts.size()), 1,
+			[&](std::size_t, std::size_t first, std::size_t last) {
+				for (std::size_t chunk = first; chunk < last; chunk++) {
+					scan_task_chunk(starts[chunk], chunk + 1 < starts.size() ? starts[chunk + 1] : nullptr, end, scanned[chunk]);
+				}
+			});
+		bool ok = std::all_of(scanned.begin(), scanned.end(), [](const ScannedChunk& chunk) { return chunk.ok; });
+		if (ok) {
+			for (const ScannedChunk& chunk : scanned) {
+				for (const SnapshotRecord& record : chunk.records) {
+					emit(record);
+				}
+				max_id = std::max(max_id, chunk.max_id);
+			}
+			scanner.seek(scanned.back().end);
+			return scanner.consume(']');
+		}
+		// Nothing was emitted yet; read the array in one piece instead
+		scanner.seek(begin);
+	}
+
+	do {
+		if (!scan_task_record(scanner, max_id, emit)) {
+			return false;
+		}
+	} while (scanner.consume(','));
+	return scanner.consume(']');
+}
+
+bool scan_json_snapshot(std::string_view bytes, int& next_id,
+	const std::function<void(const SnapshotRecord&)>& emit, unsigned threads) {
+	JsonScanner scanner(bytes);
+	if (scanner.consume('[')) {
+		// The empty store written by TaskManager for a new file
+		return scanner.consume(']') && scanner.finished();
+	}
+	if (!scanner.consume('{')) {
+		return false;
+	}
+	int max_id = 0;
+	if (!scanner.consume('}')) {
+		do {
+			std::string_view key;
+			bool escaped = false;
+			if (!scanner.string(key, escaped) || !scanner.consume(':')) {
+				return false;
+			}
+			if (key == "next_id") {
+				std::int64_t value = 0;
+				// Out of range: the SAX decoder reports and clamps it
+				if (!scanner.integer(value) || value < 1 || value > std::numeric_limits<int>::max()) {
+					return false;
+				}
+				next_id = static_cast<int>(value);
+			}
+			else if (key == "tasks") {
+				if (!scanner.consume('[') || !scan_task_array(scanner, bytes.data() + bytes.size(), max_id, emit, threads)) {
+					return false;
+				}
+			}
+			else if (!scanner.skip_value()) {
+				return false;
+			}
+		} while (scanner.consume(','));
+		if (!scanner.consume('}')) {
+			return false;
+		}
+	}
+	if (!scanner.finished()) {
+		return false;
+	}
+	// Never hand out an id that a loaded task already uses; ids are below
+	// INT_MAX, so this cannot overflow
+	if (max_id >= next_id) {
+		next_id = max_id + 1;
+	}
+	return true;
+}
@@ -0,0 +1,164 @@
+#include "substring_search.h"
+#include <bit>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define TASK_SCAN_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(TASK_SCAN_X86) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define TASK_SCAN_SSE2 1
+#endif
+
+// AVX2 code is compiled into its own functions and only called when the CPU
+// has it, so the rest of the library does not need -mavx2.
+#if defined(TASK_SCAN_SSE2) && (defined(__GNUC__) || defined(__clang__))
+#define TASK_SCAN_AVX2 1
+#define TASK_SCAN_AVX2_TARGET __attribute__((target("avx2")))
+#elif defined(TASK_SCAN_SSE2) && defined(_MSC_VER)
+#define TASK_SCAN_AVX2 1
+#define TASK_SCAN_AVX2_TARGET
+#endif
+
+// The kernels below are only called with 2 <= needle.size() <= text.size().
+
+static bool contains_scalar(std::string_view text, std::string_view needle) {
+	return text.find(needle) != std::string_view::npos;
+}
+
+// Compares the needle's middle bytes at each candidate position in `mask`
+// (bit b set: the first and last byte match at `block + b`).
+static bool check_candidates(unsigned mask, const char* block, std::string_view needle) {
+	while (mask != 0) {
+		unsigned bit = static_cast<unsigned>(std::countr_zero(mask));
+		if (std::memcmp(block + bit + 1, needle.data() + 1, needle.size() - 2) == 0) {
+			return true;
+		}
+		mask &= mask - 1;
+	}
+	return false;
+}
+
+#ifdef TASK_SCAN_SSE2
+static bool contains_sse2(std::string_view text, std::string_view needle) {
+	const std::size_t last_offset = needle.size() - 1;
+	const __m128i first = _mm_set1_epi8(needle.front());
+	const __m128i last = _mm_set1_epi8(needle.back());
+	std::size_t i = 0;
+	for (; i + last_offset + 16 <= text.size(); i += 16) {
+		const char* block = text.data() + i;
+		__m128i first_bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block));
+		__m128i last_bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + last_offset));
+		__m128i both = _mm_and_si128(_mm_cmpeq_epi8(first_bytes, first), _mm_cmpeq_epi8(last_bytes, last));
+		if (check_candidates(static_cast<unsigned>(_mm_movemask_epi8(both)), block, needle)) {
+			return true;
+		}
+	}
+	return contains_scalar(text.substr(i), needle);
+}
+#endif
+
+#ifdef TASK_SCAN_AVX2
+TASK_SCAN_AVX2_TARGET
+static bool contains_avx2(std::string_view text, std::string_view needle) {
+	const std::size_t last_offset = needle.size() - 1;
+	const __m256i first = _mm256_set1_epi8(needle.front());
+	const __m256i last = _mm256_set1_epi8(needle.back());
+	std::size_t i = 0;
+	for (; i + last_offset + 32 <= text.size(); i += 32) {
+		const char* block = text.data() + i;
+		__m256i first_bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block));
+		__m256i last_bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + last_offset));
+		__m256i both = _mm256_and_si256(_mm256_cmpeq_epi8(first_bytes, first), _mm256_cmpeq_epi8(last_bytes, last));
+		if (check_candidates(static_cast<unsigned>(_mm256_movemask_epi8(both)), block, needle)) {
+			return true;
+		}
+	}
+	// Descriptions are short, so the tail is often most of the text
+	return contains_sse2(text.substr(i), needle);
+}
+
+static bool cpu_has_avx2() {
+#if defined(_MSC_VER) && !defined(__clang__)
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] < 7) {
+		return false;
+	}
+	__cpuid(info, 1);
+	bool os_saves_ymm = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && (_xgetbv(0) & 6) == 6;
+	__cpuidex(info, 7, 0);
+	return os_saves_ymm && (info[1] & (1 << 5));
+#else
+	return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif
+
+bool scan_kernel_supported(ScanKernel kernel) {
+	switch (kernel) {
+	case ScanKernel::Scalar:
+		return true;
+	case ScanKernel::Sse2:
+#ifdef TASK_SCAN_SSE2
+		return true;
+#else
+		return false;
+#endif
+	case ScanKernel::Avx2: {
+#ifdef TASK_SCAN_AVX2
+		static const bool avx2 = cpu_has_avx2();
+		return avx2;
+#else
+		return false;
+#endif
+	}
+	}
+	return false;
+}
+
+ScanKernel best_scan_kernel() {
+	static const ScanKernel best = scan_kernel_supported(ScanKernel::Avx2) ? ScanKernel::Avx2
+		: scan_kernel_supported(ScanKernel::Sse2) ? ScanKernel::Sse2 : ScanKernel::Scalar;
+	return best;
+}
+
+const char* scan_kernel_name(ScanKernel kernel) {
+	switch (kernel) {
+	case ScanKernel::Scalar:
+		return "scalar";
+	case ScanKernel::Sse2:
+		return "sse2";
+	case ScanKernel::Avx2:
+		return "avx2";
+	}
+	return "unknown";
+}
+
+SubstringMatcher::SubstringMatcher(std::string_view needle, ScanKernel kernel)
+	: needle(needle), used(scan_kernel_supported(kernel) ? kernel : best_scan_kernel()), search(contains_scalar) {
+#ifdef TASK_SCAN_SSE2
+	if (used == ScanKernel::Sse2) {
+		search = contains_sse2;
+	}
+#endif
+#ifdef TASK_SCAN_AVX2
+	if (used == ScanKernel::Avx2) {
+		search = contains_avx2;
+	}
+#endif
+}
+
+bool SubstringMatcher::operator()(std::string_view text) const {
+	if (needle.size() > text.size()) {
+		return false;
+	}
+	if (needle.size() < 2) {
+		return needle.empty() || std::memchr(text.data(), needle[0], text.size()) != nullptr;
+	}
+	return search(text, needle);
+}
@@ -1,22 +1,25 @@
 #include "task.h"
 #include <iostream>
 #include <ctime>
+#include <algorithm>
 
-Task::Task(int id,const  std::string description) 
-	: id(id), description(description), status(TaskStatus::TO_DO) {
+Task::Task(int id, std::string_view description)
+	: id(id), status(TaskStatus::TO_DO) {
+		assign_owned(description);
 		created_at = std::time(nullptr);
 		updated_at = created_at;
 }
 
-Task::Task(int id, const  std::string description, TaskStatus statu, std::time_t creat, std::time_t update)
-	: id(id), description(description), status(statu), created_at(creat), updated_at(update) {
+Task::Task(int id, std::string_view description, TaskStatus statu, std::time_t creat, std::time_t update)
+	: created_at(creat), updated_at(update), id(id), status(statu) {
+	assign_owned(description);
 }
 
 Task::~Task() {
 	// Destructor logic if needed
 }
 
-void Task::update_status(const std::string new_status) {
+void Task::update_status(std::string_view new_status) {
 	if (new_status == "TO_DO") {
 		status = TaskStatus::TO_DO;
 	} else if (new_status == "IN_PROGRESS") {
@@ -30,10 +33,42 @@ void Task::update_status(const std::string new_status) {
 	updated_at = std::time(nullptr);
 }
 
-void Task::update_description(const std::string new_description) {
-	description = new_description;
+void Task::update_status(TaskStatus new_status) {
+	status = new_status;
 	updated_at = std::time(nullptr);
 }
 
+void Task::update_description(std::string_view new_description) {
+	assign_owned(new_description);
+	updated_at = std::time(nullptr);
+}
+
+void Task::borrow_description(std::string_view text) {
+	owned_description.reset();
+	description = text;
+	borrowed = true;
+}
+
+void Task::own_description() {
+	if (borrowed) {
+		assign_owned(description);
+	}
+}
+
+void Task::assign_owned(std::string_view text) {
+	if (text.empty()) {
+		owned_description.reset();
+		description = std::string_view();
+	}
+	else {
+		// Copy before releasing the old buffer: `text` may point into it
+		std::unique_ptr<char[]> copy(new char[text.size()]);
+		std::copy(text.begin(), text.end(), copy.get());
+		owned_description = std::move(copy);
+		description = std::string_view(owned_description.get(), text.size());
+	}
+	borrowed = false;
+}
+
 
 
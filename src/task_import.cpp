@@ -0,0 +1,292 @@
+#include "task_import.h"
+#include "json_scanner.h"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <stdexcept>
+#include <nlohmann/json.hpp>
+
+template <typename T>
+static bool parse_integer(std::string_view text, T& value) {
+	auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+	return error == std::errc() && end == text.data() + text.size();
+}
+
+ImportReader::ImportReader(std::istream& input, ImportFormat format)
+	: input(input), format(format) {
+	if (format == ImportFormat::Auto) {
+		fill();
+		std::size_t first = buffer.find_first_not_of(" \t\r\n");
+		std::size_t line_end = buffer.find('\n');
+		if (first != std::string::npos && buffer[first] == '{') {
+			this->format = ImportFormat::JsonLines;
+		}
+		else if (buffer.substr(0, line_end).find('\t') != std::string::npos) {
+			this->format = ImportFormat::Tsv;
+		}
+		else {
+			this->format = ImportFormat::Csv;
+		}
+	}
+	if (this->format != ImportFormat::JsonLines) {
+		read_header();
+	}
+}
+
+bool ImportReader::fill() {
+	if (exhausted) {
+		return false;
+	}
+	buffer.erase(0, at);
+	at = 0;
+	std::size_t kept = buffer.size();
+	buffer.resize(kept + block_size);
+	input.read(buffer.data() + kept, static_cast<std::streamsize>(block_size));
+	std::size_t got = static_cast<std::size_t>(input.gcount());
+	buffer.resize(kept + got);
+	exhausted = !input;
+	return got > 0;
+}
+
+// The bytes of the next record, without the line break. A CSV record ends
+// at a line break outside quotes; the other formats cannot hold raw ones.
+bool ImportReader::next_line(std::string_view& text) {
+	std::size_t end = std::string::npos;
+	std::size_t breaks = 0;
+	while (true) {
+		const char* data = buffer.data();
+		std::size_t from = at;
+		bool quoted = false;
+		breaks = 0;
+		while (from < buffer.size()) {
+			const void* found = std::memchr(data + from, '\n', buffer.size() - from);
+			std::size_t line_break = found ? static_cast<std::size_t>(static_cast<const char*>(found) - data) : buffer.size();
+			if (format == ImportFormat::Csv) {
+				quoted ^= std::count(data + from, data + line_break, '"') % 2 == 1;
+			}
+			if (!found) {
+				break;
+			}
+			breaks++;
+			if (!quoted) {
+				end = line_break;
+				break;
+			}
+			from = line_break + 1;
+		}
+		if (end != std::string::npos || !fill()) {
+			break;
+		}
+	}
+	if (end == std::string::npos) {
+		// The last record may lack its line break
+		if (at == buffer.size()) {
+			return false;
+		}
+		end = buffer.size();
+	}
+	record_line = line_number + 1;
+	line_number += std::max<std::size_t>(breaks, 1);
+	text = std::string_view(buffer.data() + at, end - at);
+	at = std::min(end + 1, buffer.size());
+	if (!text.empty() && text.back() == '\r') {
+		text.remove_suffix(1);
+	}
+	return true;
+}
+
+void ImportReader::read_header() {
+	std::string_view header;
+	if (!next_line(header)) {
+		return; // empty input: next() returns End
+	}
+	char separator = format == ImportFormat::Tsv ? '\t' : ',';
+	bool has_description = false;
+	std::size_t start = 0;
+	while (start <= header.size()) {
+		std::size_t stop = std::min(header.find(separator, start), header.size());
+		std::string_view name = header.substr(start, stop - start);
+		if (name.size() >= 2 && name.front() == '"' && name.back() == '"') {
+			name = name.substr(1, name.size() - 2);
+		}
+		Column column = name == "id" ? Id : name == "description" ? Description : name == "status" ? Status
+			: name == "created_at" ? CreatedAt : name == "updated_at" ? UpdatedAt : Ignored;
+		has_description = has_description || column == Description;
+		columns.push_back(column);
+		start = stop + 1;
+	}
+	if (!has_description) {
+		throw std::runtime_error("Import header has no description column");
+	}
+}
+
+ImportReader::Result ImportReader::next(ImportRecord& record) {
+	std::string_view text;
+	do {
+		if (!next_line(text)) {
+			return Result::End;
+		}
+	} while (text.find_first_not_of(" \t") == std::string_view::npos);
+
+	record = ImportRecord();
+	bool ok = format == ImportFormat::JsonLines ? parse_json(text, record) : parse_delimited(text, record);
+	return ok ? Result::Record : Result::Rejected;
+}
+
+bool ImportReader::parse_json(std::string_view text, ImportRecord& record) {
+	JsonScanner scanner(text);
+	if (!scanner.consume('{')) {
+		return false;
+	}
+	bool has_description = false, escaped = false;
+	if (!scanner.consume('}')) {
+		do {
+			std::string_view key;
+			bool escaped_key = false;
+			if (!scanner.string(key, escaped_key) || !scanner.consume(':')) {
+				return false;
+			}
+			bool ok = true;
+			std::int64_t value = 0;
+			if (key == "id") {
+				ok = scanner.integer(value) && valid_task_id(value);
+				record.id = static_cast<int>(value);
+			}
+			else if (key == "description") {
+				ok = scanner.string(record.description, escaped);
+				has_description = true;
+			}
+			else if (key == "status") {
+				std::string_view status;
+				bool escaped_status = false;
+				ok = scanner.string(status, escaped_status) && !escaped_status && parse_status(status, record.status);
+			}
+			else if (key == "created_at") {
+				ok = scanner.integer(value);
+				record.created_at = static_cast<std::time_t>(value);
+			}
+			else if (key == "updated_at") {
+				ok = scanner.integer(value);
+				record.updated_at = static_cast<std::time_t>(value);
+			}
+			else {
+				ok = scanner.skip_value();
+			}
+			if (!ok) {
+				return false;
+			}
+		} while (scanner.consume(','));
+		if (!scanner.consume('}')) {
+			return false;
+		}
+	}
+	if (!has_description || !scanner.finished()) {
+		return false;
+	}
+	if (escaped) {
+		// Rare (quotes, backslashes, control characters): let nlohmann decode it
+		decoded = nlohmann::json::parse("\"" + std::string(record.description) + "\"").get<std::string>();
+		record.description = decoded;
+	}
+	return true;
+}
+
+bool ImportReader::parse_delimited(std::string_view text, ImportRecord& record) {
+	std::size_t index = 0, start = 0;
+	while (true) {
+		if (index == columns.size()) {
+			return false; // more fields than the header names
+		}
+		Column column = columns[index++];
+		std::string_view value;
+		std::size_t stop;
+		if (format == ImportFormat::Csv && start < text.size() && text[start] == '"') {
+			// Quoted: "" stands for one quote; copy only when there is one
+			std::size_t close = start + 1;
+			bool doubled = false;
+			while (true) {
+				close = text.find('"', close);
+				if (close == std::string_view::npos) {
+					return false;
+				}
+				if (close + 1 < text.size() && text[close + 1] == '"') {
+					doubled = true;
+					close += 2;
+					continue;
+				}
+				break;
+			}
+			value = text.substr(start + 1, close - start - 1);
+			stop = close + 1;
+			if (stop < text.size() && text[stop] != ',') {
+				return false;
+			}
+			if (doubled && column == Description) {
+				decoded.clear();
+				for (std::size_t i = 0; i < value.size(); i++) {
+					decoded += value[i];
+					i += value[i] == '"';
+				}
+				value = decoded;
+			}
+		}
+		else {
+			stop = std::min(text.find(format == ImportFormat::Tsv ? '\t' : ',', start), text.size());
+			value = text.substr(start, stop - start);
+			if (format == ImportFormat::Tsv && column == Description && value.find('\\') != std::string_view::npos) {
+				decoded.clear();
+				for (std::size_t i = 0; i < value.size(); i++) {
+					char c = value[i];
+					if (c == '\\' && i + 1 < value.size()) {
+						c = value[++i];
+						c = c == 't' ? '\t' : c == 'n' ? '\n' : c == 'r' ? '\r' : c;
+					}
+					decoded += c;
+				}
+				value = decoded;
+			}
+		}
+		if (!parse_field(column, value, record)) {
+			return false;
+		}
+		if (stop >= text.size()) {
+			break;
+		}
+		start = stop + 1;
+	}
+	return index == columns.size();
+}
+
+// An empty field leaves an optional column unset.
+bool ImportReader::parse_field(Column column, std::string_view value, ImportRecord& record) {
+	if (value.empty() && column != Description) {
+		return true;
+	}
+	std::int64_t number = 0;
+	switch (column) {
+	case Id:
+		if (!parse_integer(value, number) || !valid_task_id(number)) {
+			return false;
+		}
+		record.id = static_cast<int>(number);
+		return true;
+	case Description:
+		// As in JSON lines: saving goes through nlohmann::json, which rejects invalid UTF-8
+		if (!JsonScanner::valid_utf8(value)) {
+			return false;
+		}
+		record.description = value;
+		return true;
+	case Status:
+		return parse_status(value, record.status);
+	case CreatedAt:
+	case UpdatedAt:
+		if (!parse_integer(value, number)) {
+			return false;
+		}
+		(column == CreatedAt ? record.created_at : record.updated_at) = static_cast<std::time_t>(number);
+		return true;
+	default:
+		return true;
+	}
+}
@@ -1,208 +1,1184 @@
 #include "task_manager.h"
 #include <memory>
-#include <stdexcept> // ׳쳣
+#include <stdexcept> // 用于抛出异常
 #include <iostream>
 #include <fstream>
 #include <algorithm>
+#include <iterator>
+#include <cstdio>
+#include <filesystem>
+#include <limits>
+#include "parallel.h"
 #include <nlohmann/json.hpp>
 
-TaskManager::TaskManager(const std::string filename )
-	: filename(filename) {
+static nlohmann::json task_to_json(const Task& task) {
+	nlohmann::json j_task;
+	j_task["id"] = task.get_id();
+	j_task["description"] = task.get_description();
+	j_task["status"] = status_to_string(task.get_status());
+	j_task["created_at"] = task.get_created_at();
+	j_task["updated_at"] = task.get_updated_at();
+	return j_task;
+}
+
+static Task* task_from_json(TaskStore& store, const nlohmann::json& item) {
+	int id = item["id"];
+	const std::string& description = item["description"].get_ref<const std::string&>();
+	std::time_t created_at = item.value("created_at", std::time_t());
+	std::time_t updated_at = item.value("updated_at", std::time_t());
+	std::string status_str = item["status"];
+	TaskStatus statu = string_to_status(status_str);
+	return store.create(id, description, statu, created_at, updated_at);
+}
+
+TaskManager::TaskManager(const std::string filename, TaskManagerOptions options)
+	: store(options.memory), index_nodes(options.memory),
+	by_status{ std::pmr::set<int>(&index_nodes), std::pmr::set<int>(&index_nodes), std::pmr::set<int>(&index_nodes) },
+	by_time{ TimeIndex(&index_nodes), TimeIndex(&index_nodes) },
+	filename(filename), options(options), journal(filename + ".journal", options.durability) {
 	ensure_file_exists(filename);
 	load_from_file(filename);
+	if (options.async_persistence) {
+		writer = std::make_unique<BackgroundWriter>(
+			[this](const std::string& content, std::uint64_t fingerprint) { write_snapshot(content, fingerprint); },
+			[this](const std::string& lines, std::size_t count) { journal.append_lines(lines, count); },
+			options.flush_interval, options.flush_records);
+	}
 }
 TaskManager::~TaskManager() {
-	/*if (data_flag) {
-		save_to_file("tasks.json");
-	}*/
+	if (writer) {
+		// 等待后台线程写完所有修改
+		try {
+			writer->flush();
+		}
+		catch (const std::exception& e) {
+			std::cerr << "Failed to save tasks: " << e.what() << std::endl;
+		}
+	}
+}
+
+void TaskManager::flush() {
+	if (writer) {
+		writer->flush();
+	}
+	journal.flush();
 }
 
 void TaskManager::ensure_file_exists(const std::string filename) {
 	std::ifstream test(filename);
 	if( !test.good() ) {
-		std::ofstream create_file(filename);
-		create_file << "[]" ; // Initialize with empty JSON array
-		create_file.close();
+		if (snapshot_format() == SnapshotFormat::Binary) {
+			write_file_atomically(filename, encode_binary_snapshot(next_id, {}), options.durability);
+		}
+		else {
+			write_file_atomically(filename, "[]", options.durability); // Initialize with empty JSON array
+		}
+		// 旧的 journal 属于已经不存在的快照
+		std::remove(journal.get_path().c_str());
 
 		std::cerr << "File " << filename << " did not exist and was created." << std::endl;
 	}
 }
 
 void TaskManager::load_from_file(std::string filename) {
-	std::ifstream file(filename);
+	clear_store(); // 清空现有任务列表
+	this->next_id = 1; // 重置 next_id
+	shards = ShardSet(filename, options.shard_size);
+
+	// 快照的指纹由读出的元数据算出, 不读描述, 见 SnapshotFingerprint
+	SnapshotFingerprint fingerprint;
+	auto add_record = [this, &fingerprint](const SnapshotRecord& record) {
+		fingerprint.add(record);
+		add_snapshot_task(record);
+	};
+	auto report = [&filename](const std::string& message) {
+		std::cerr << "JSON snapshot " << filename << ": " << message << std::endl;
+	};
+	// 快速路径失败后从头再读一遍
+	auto restart = [this, &fingerprint]() {
+		clear_store();
+		next_id = 1;
+		fingerprint = SnapshotFingerprint();
+	};
+
+	// 两种格式都可以读取, 按文件头识别; 保存时使用配置的格式
+	std::uint64_t snapshot = 0;
+	bool intact = true;
+	bool converting = false;
+	std::string manifest;
+	if (ShardSet::read_manifest(filename, manifest)) {
+		// 分片存储: 只读取清单, 分片在第一次用到时才读取
+		shards.decode(manifest, next_id);
+	}
+	else if (options.memory_map && !shards.enabled()) {
+		// 映射整个文件, 二进制快照的描述直接引用映射中的字节, 只有被访问的页才会读入内存
+		std::shared_ptr<MappedFile> file = std::make_shared<MappedFile>(filename);
+		std::string_view bytes = file->view();
+		if (is_binary_snapshot(bytes)) {
+			mapping = file;
+			intact = load_binary_snapshot(bytes, add_record);
+		}
+		// JSON 快照要从头扫到尾 (还要校验描述的 UTF-8), 每一页都会读到,
+		// 所以描述在加载时复制, 扫描完就不再保留映射
+		else if (!bytes.empty() && !scan_json_snapshot(bytes, next_id, add_record, options.threads)) {
+			// 快速路径不认识的内容 (例如损坏的记录) 交给完整的解析器读取并报告
+			restart();
+			intact = decode_json_snapshot(bytes, next_id, add_record, report);
+		}
+	}
+	else {
+		std::ifstream file(filename, std::ios::binary);
+		if (!file.is_open()) {
+			std::cerr << "Failed to open file: " << filename << std::endl;
+			throw std::runtime_error("Could not open file: " + filename);
+			return;
+		}
+
+		char magic[sizeof(binary_snapshot::magic)] = {};
+		file.read(magic, sizeof(magic));
+		std::string head(magic, static_cast<std::size_t>(file.gcount()));
+		file.clear();
+		file.seekg(0, std::ios::beg); // 重置文件指针到开头
+
+		if (is_binary_snapshot(head)) {
+			std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+			intact = load_binary_snapshot(content, add_record);
+		}
+		// 文件是空的 (0 字节) 时不解析快照, 但仍然回放 journal
+		else if (!head.empty()) {
+			if (resolve_threads(options.threads) > 1) {
+				// 多线程: 整个文件读入内存后分块并行扫描, 任务仍按快照顺序逐个加入
+				std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+				if (!scan_json_snapshot(content, next_id, add_record, options.threads)) {
+					restart();
+					intact = decode_json_snapshot(std::string_view(content), next_id, add_record, report);
+				}
+			}
+			else {
+				// 边读边构造任务, 不建立完整的 JSON DOM
+				intact = decode_json_snapshot(file, next_id, add_record, report);
+			}
+		}
+		file.close();
+	}
+	snapshot = manifest.empty() ? fingerprint.value() : Journal::fingerprint(manifest);
+	if (!intact) {
+		keep_damaged_snapshot(filename);
+	}
+	if (shards.enabled() && manifest.empty()) {
+		// 单文件存储转换为分片存储: 所有任务都已读入, 全部分片都要写出
+		converting = true;
+		for (const Task* task : tasks) {
+			if (task) {
+				ShardSet::Shard& shard = shards.at(shards.shard_of(task->get_id()));
+				shard.loaded = true;
+				shard.dirty = true;
+			}
+		}
+	}
+
+	// 在快照之上回放 journal 中的增量操作
+	// 旧版本的 journal 用整个快照文件的哈希作为指纹 (分片存储一直用清单的哈希)
+	auto legacy_fingerprint = [&]() {
+		if (!manifest.empty()) {
+			return snapshot;
+		}
+		std::ifstream file(filename, std::ios::binary);
+		return Journal::fingerprint(file);
+	};
+	bool replayed = journal.replay(snapshot, legacy_fingerprint, [this](const nlohmann::json& record) {
+		apply_journal_record(record);
+	});
+	if (!replayed) {
+		journal.reset(snapshot);
+	}
+	unsaved_records = journal.size();
+	if (!options.lazy_shards) {
+		load_all_shards();
+	}
+	if (converting) {
+		save_to_file();
+	}
+	else {
+		maybe_compact();
+	}
+}
+
+bool TaskManager::load_binary_snapshot(std::string_view bytes, const std::function<void(const SnapshotRecord&)>& emit) {
+	try {
+		decode_binary_snapshot(bytes, next_id, emit);
+		return true;
+	}
+	catch (const std::runtime_error& e) {
+		std::cerr << "Binary snapshot error in file " << filename << ": " << e.what() << std::endl;
+		return false;
+	}
+}
+
+void TaskManager::keep_damaged_snapshot(const std::string& path) {
+	// 下次保存会覆盖快照, 先留一份原文件, 读不出来的任务还可以手动找回
+	std::string copy = path + ".damaged";
+	std::error_code error;
+	std::filesystem::copy_file(path, copy, std::filesystem::copy_options::overwrite_existing, error);
+	if (error) {
+		std::cerr << "Could not keep a copy of the damaged snapshot " << path << ": " << error.message() << std::endl;
+	}
+	else {
+		std::cerr << "Snapshot " << path << " is damaged; the original was kept as " << copy << "." << std::endl;
+	}
+}
+
+void TaskManager::load_shard(std::int64_t index, ShardSet::Shard& shard) {
+	if (shard.loaded) {
+		return;
+	}
+	shard.loaded = true;
+	if (!shard.listed) {
+		return; // 还没有写出过的分片是空的
+	}
+
+	std::string path = shards.path(index);
+	std::ifstream file(path, std::ios::binary);
 	if (!file.is_open()) {
-		std::cerr << "Failed to open file: " << filename << std::endl;
-		throw std::runtime_error("Could not open file: " + filename);
+		std::cerr << "Shard " << path << " listed in " << filename << " is missing; its tasks were not loaded." << std::endl;
 		return;
 	}
+	std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+	file.close();
 
-	file.seekg(0, std::ios::end);
-	if (file.tellg() == 0) {
-		// ļǿյ (0 ֽ)ֱӷ
-		file.close();
+	// 分片里的 next_id 以清单为准
+	int shard_next_id = 0;
+	auto add_record = [this](const SnapshotRecord& record) {
+		add_snapshot_task(record);
+	};
+	bool intact = true;
+	if (is_binary_snapshot(content)) {
+		try {
+			decode_binary_snapshot(content, shard_next_id, add_record);
+		}
+		catch (const std::runtime_error& e) {
+			std::cerr << "Binary snapshot error in file " << path << ": " << e.what() << std::endl;
+			intact = false;
+		}
+	}
+	else if (!content.empty()) {
+		intact = decode_json_snapshot(std::string_view(content), shard_next_id, add_record,
+			[&path](const std::string& message) {
+				std::cerr << "JSON snapshot " << path << ": " << message << std::endl;
+			});
+	}
+	if (!intact) {
+		keep_damaged_snapshot(path);
+		shard.dirty = true; // 下次保存时写出读到的部分
+	}
+}
+
+void TaskManager::load_shard_of(int id) const {
+	if (!shards.enabled()) {
 		return;
 	}
+	// 只查找不创建, 不存在的分片是空的
+	std::int64_t index = shards.shard_of(id);
+	const ShardSet::Shard* shard = shards.find(index);
+	if (shard && !shard->loaded) {
+		// 只有 lazy_shards 时才会走到这里: 按需读入会修改管理器
+		TaskManager* self = const_cast<TaskManager*>(this);
+		self->load_shard(index, *self->shards.find(index));
+	}
+}
 
-	file.seekg(0, std::ios::beg); // ļָ뵽ͷ
+void TaskManager::load_all_shards() const {
+	// 分片都已读入时什么也不改
+	if (!shards.enabled() || shards.all_loaded()) {
+		return;
+	}
+	TaskManager* self = const_cast<TaskManager*>(this);
+	bool loaded_any = false;
+	for (auto& [index, shard] : self->shards.all()) {
+		if (!shard.loaded) {
+			self->load_shard(index, shard);
+			loaded_any = true;
+		}
+	}
+	if (loaded_any) {
+		self->sort_by_id();
+	}
+}
 
-	nlohmann::json j;
-	try {
-		file >> j;
-		file.close();
+void TaskManager::sort_by_id() {
+	// 分片按访问顺序读入, 全部读入后恢复按 id (即添加顺序) 排列
+	Task* previous = nullptr;
+	bool sorted = true;
+	for (Task* task : tasks) {
+		if (task) {
+			if (previous && previous->get_id() > task->get_id()) {
+				sorted = false;
+				break;
+			}
+			previous = task;
+		}
+	}
+	if (sorted) {
+		return;
+	}
+	std::vector<Task*> live;
+	live.reserve(slots.size());
+	for (Task* task : tasks) {
+		if (task) {
+			live.push_back(task);
+		}
+	}
+	std::sort(live.begin(), live.end(), [](const Task* a, const Task* b) {
+		return a->get_id() < b->get_id();
+	});
+	tasks.clear();
+	for (Task* task : live) {
+		slots.insert_or_assign(task->get_id(), static_cast<std::uint32_t>(tasks.size()));
+		tasks.push_back(task);
+	}
+	tombstones = 0;
+}
 
-		this->tasks.clear(); // б
-		this->next_id = 1; //  next_id
-
-		if (j.contains("next_id")) {
-			next_id = j["next_id"].get<int>();
-		};
-
-		if(j.contains("tasks")) {
-			for (const auto& item : j["tasks"]) {
-				int id = item["id"];
-				std::string description = item["description"];
-				std::time_t created_at = item.value("created_at", std::time_t());
-				std::time_t updated_at = item.value("updated_at", std::time_t());
-				std::string status_str = item["status"];
-				TaskStatus statu = string_to_status(status_str);
-				std::unique_ptr<Task> task = std::make_unique<Task>(id, description, statu, created_at, updated_at);
-				tasks.push_back(std::move(task));
+void TaskManager::touch_shard(int id) {
+	if (shards.enabled()) {
+		std::int64_t index = shards.shard_of(id);
+		ShardSet::Shard& shard = shards.at(index);
+		load_shard(index, shard);
+		shard.dirty = true;
+	}
+}
+
+void TaskManager::clear_shards() {
+	// 清空后每个分片都是空的, 不用再读取
+	for (auto& [index, shard] : shards.all()) {
+		shard.loaded = true;
+		shard.dirty = true;
+	}
+}
+
+void TaskManager::add_snapshot_task(const SnapshotRecord& record) {
+	if (mapping && record.in_place) {
+		insert_task(store.create_borrowed(record.id, record.description, record.status, record.created_at, record.updated_at));
+	}
+	else {
+		insert_task(store.create(record.id, record.description, record.status, record.created_at, record.updated_at));
+	}
+}
+
+void TaskManager::apply_journal_record(const nlohmann::json& record) {
+	const std::string op = record.value("op", "");
+	if (op == "clear") {
+		clear_store();
+		clear_shards();
+		return;
+	}
+
+	// 超出范围的 id 会让 next_id 溢出, 只跳过这一条记录
+	std::int64_t id = record["id"].get<std::int64_t>();
+	if (!valid_task_id(id)) {
+		std::cerr << "Journal record for task " << id << " is out of range; skipped." << std::endl;
+		return;
+	}
+	touch_shard(static_cast<int>(id));
+	if (op == "remove") {
+		erase_task(id);
+		return;
+	}
+
+	// "add" 和 "update" 记录带有任务的完整状态
+	insert_task(task_from_json(store, record));
+	next_id = std::max(next_id, static_cast<int>(id) + 1);
+}
+
+Task* TaskManager::insert_task(Task* task) {
+	collect_retired();
+	task->version = epoch.load(std::memory_order_relaxed);
+	// 快照按 id 顺序加载, 从末尾插入时不用查找位置
+	std::pmr::set<int>& ids = by_status[status_slot(task->get_status())];
+	ids.insert(ids.end(), task->get_id());
+	std::uint32_t* found = slots.find(task->get_id());
+	if (found) {
+		// 同一个 id 再次出现: 用新的状态原地替换旧的
+		Task* old = tasks[*found];
+		if (old->get_status() != task->get_status()) {
+			by_status[status_slot(old->get_status())].erase(old->get_id());
+		}
+		if (text_indexed) {
+			words.remove(old->get_id(), old->get_description());
+			words.add(task->get_id(), task->get_description());
+		}
+		unindex_times(*old);
+		index_times(*task);
+		discard_task(old);
+		tasks.set(*found, task);
+		return task;
+	}
+	if (text_indexed) {
+		words.add(task->get_id(), task->get_description());
+	}
+	index_times(*task);
+	slots.insert_or_assign(task->get_id(), static_cast<std::uint32_t>(tasks.size()));
+	tasks.push_back(task);
+	return task;
+}
+
+bool TaskManager::erase_task(int id) {
+	touch_shard(id);
+	std::uint32_t* found = slots.find(id);
+	if (!found) {
+		return false;
+	}
+	// 留下空位, 后面任务的位置保持不变
+	Task* task = tasks[*found];
+	by_status[status_slot(task->get_status())].erase(id);
+	if (text_indexed) {
+		words.remove(id, task->get_description());
+	}
+	unindex_times(*task);
+	discard_task(task);
+	tasks.set(*found, nullptr);
+	slots.erase(id);
+	tombstones++;
+
+	while (!tasks.empty() && !tasks.back()) {
+		tasks.pop_back();
+		tombstones--;
+	}
+	if (tombstones > slots.size()) {
+		reclaim_tombstones();
+	}
+	return true;
+}
+
+void TaskManager::reclaim_tombstones() {
+	tasks.remove_nulls();
+	tombstones = 0;
+	for (std::size_t slot = 0; slot < tasks.size(); slot++) {
+		slots.insert_or_assign(tasks[slot]->get_id(), static_cast<std::uint32_t>(slot));
+	}
+}
+
+void TaskManager::clear_store() {
+	collect_retired();
+	if (snapshots->empty()) {
+		retired.clear();
+		store.clear();
+	}
+	else {
+		// 快照还在引用这些任务, 只能逐个退休
+		for (Task* task : tasks) {
+			if (task) {
+				discard_task(task);
 			}
 		}
-	}catch (const nlohmann::json::parse_error& e) {
-		std::cerr << "JSON parse error in file " << filename << ": " << e.what() << std::endl;
+	}
+	tasks.clear();
+	slots.clear();
+	tombstones = 0;
+	for (auto& ids : by_status) {
+		ids.clear();
+	}
+	words.clear();
+	for (TimeIndex& index : by_time) {
+		index.clear();
 	}
 }
-	
+
+void TaskManager::reindex_status(int id, TaskStatus old_status, TaskStatus new_status) {
+	if (new_status != old_status) {
+		by_status[status_slot(old_status)].erase(id);
+		by_status[status_slot(new_status)].insert(id);
+	}
+}
+
+void TaskManager::index_times(const Task& task) const {
+	if (time_indexed) {
+		by_time[0].emplace(task.get_created_at(), task.get_id());
+		by_time[1].emplace(task.get_updated_at(), task.get_id());
+	}
+}
+
+void TaskManager::unindex_times(const Task& task) {
+	if (time_indexed) {
+		by_time[0].erase({ task.get_created_at(), task.get_id() });
+		by_time[1].erase({ task.get_updated_at(), task.get_id() });
+	}
+}
+
+void TaskManager::reindex_updated(int id, std::time_t old_updated, std::time_t new_updated) {
+	if (time_indexed && new_updated != old_updated) {
+		by_time[1].erase({ old_updated, id });
+		by_time[1].emplace(new_updated, id);
+	}
+}
+
+TaskSnapshot TaskManager::snapshot() const {
+	load_all_shards();
+	auto state = std::make_shared<TaskSnapshot::State>();
+	state->order = tasks;
+	state->size = slots.size();
+	state->next_id = next_id;
+	state->mapping = mapping;
+	state->registry = snapshots;
+	// 之后写入的任务都带着更新的 epoch, 不会被这个快照看到
+	state->version = epoch.fetch_add(1, std::memory_order_relaxed);
+	snapshots->acquire(state->version);
+	return TaskSnapshot(std::move(state));
+}
+
+bool TaskManager::seen_by_snapshot(const Task* task) const {
+	return !snapshots->empty() && task->version <= snapshots->newest();
+}
+
+Task* TaskManager::writable_task(std::uint32_t slot) {
+	Task* task = tasks[slot];
+	if (seen_by_snapshot(task)) {
+		// 写时复制: 快照继续看旧的任务, 管理器换成新副本
+		Task* copy = store.create(task->get_id(), task->get_description(), task->get_status(),
+			task->get_created_at(), task->get_updated_at());
+		discard_task(task);
+		tasks.set(slot, copy);
+		task = copy;
+	}
+	task->version = epoch.load(std::memory_order_relaxed);
+	return task;
+}
+
+Task* TaskManager::find_writable(int id) {
+	touch_shard(id);
+	std::uint32_t* found = slots.find(id);
+	if (!found) {
+		return nullptr;
+	}
+	return writable_task(*found);
+}
+
+void TaskManager::discard_task(Task* task) {
+	collect_retired();
+	if (seen_by_snapshot(task)) {
+		retired.emplace_back(epoch.load(std::memory_order_relaxed), task);
+	}
+	else {
+		store.destroy(task);
+	}
+}
+
+void TaskManager::collect_retired() {
+	if (retired.empty()) {
+		return;
+	}
+	// 快照 v 看得到在 v 之后的 epoch 中退休的任务; retired 按 epoch 递增排列
+	std::uint64_t oldest = snapshots->empty() ? UINT64_MAX : snapshots->oldest();
+	auto still_seen = std::find_if(retired.begin(), retired.end(),
+		[oldest](const std::pair<std::uint64_t, Task*>& entry) { return entry.first > oldest; });
+	for (auto entry = retired.begin(); entry != still_seen; ++entry) {
+		store.destroy(entry->second);
+	}
+	retired.erase(retired.begin(), still_seen);
+}
+
+void TaskManager::log_update(const Task& task, const char* op) {
+	nlohmann::json record = task_to_json(task);
+	record["op"] = op;
+	append_record(record);
+	maybe_compact();
+}
+
+void TaskManager::log_remove(int id) {
+	append_record({ {"op", "remove"}, {"id", id} });
+	maybe_compact();
+}
+
+void TaskManager::append_record(const nlohmann::json& record) {
+	if (journal.in_batch()) {
+		journal.append(record); // 在 commit() 时计数
+		return;
+	}
+	if (writer) {
+		writer->submit_records(record.dump() + '\n', 1);
+	}
+	else {
+		journal.append(record);
+	}
+	unsaved_records++;
+}
+
+void TaskManager::maybe_compact() {
+	if (in_batch()) {
+		return; // 由 commit() 为整个批处理决定一次
+	}
+	// 重写快照的代价是 O(N), 等 journal 的记录不少于存储中的任务时才重写,
+	// 这样每次修改平摊写入 O(1) 字节
+	if (unsaved_records >= std::max(min_journal_records, slots.size())) {
+		save_to_file();
+	}
+}
+
+void TaskManager::compact() {
+	if (in_batch()) {
+		throw std::runtime_error("Cannot compact while a batch is open");
+	}
+	save_to_file();
+}
+
+void TaskManager::begin_batch() {
+	if (batch_depth++ == 0) {
+		journal.begin_batch();
+	}
+	batch_starts.push_back(journal.batch_lines().size());
+}
+
+void TaskManager::commit() {
+	if (batch_depth == 0) {
+		throw std::runtime_error("No batch to commit");
+	}
+	batch_starts.pop_back();
+	if (--batch_depth > 0) {
+		return;
+	}
+	// 批处理记录比存储还多时, 直接重写快照比先写 journal 再压缩更省
+	std::size_t pending = journal.pending();
+	if (unsaved_records + pending >= std::max(min_journal_records, slots.size())) {
+		journal.discard_batch();
+		save_to_file();
+	}
+	else if (writer) {
+		writer->submit_records(journal.take_batch(), pending);
+		unsaved_records += pending;
+	}
+	else {
+		journal.commit_batch();
+		unsaved_records += pending;
+	}
+}
+
+void TaskManager::rollback() {
+	rollback_to(1);
+}
+
+void TaskManager::rollback_to(int level) {
+	if (level < 1 || level > batch_depth) {
+		return;
+	}
+	// 外层批处理的记录要保留: 它们在这一层开始之前写入, 是批处理缓冲的前缀
+	std::string kept(journal.batch_lines().substr(0, batch_starts[level - 1]));
+	std::vector<std::size_t> outer_starts(batch_starts.begin(), batch_starts.begin() + (level - 1));
+	batch_depth = 0;
+	batch_starts.clear();
+	journal.discard_batch();
+	// 批处理中的修改都还没有落盘, 重新加载即可回到提交前的状态
+	flush(); // 先让后台线程写完批处理之前的修改
+	load_from_file(filename);
+	if (level == 1) {
+		return;
+	}
+
+	// 重新打开外层批处理, 把保留的记录应用到已提交的状态上
+	journal.begin_batch();
+	std::size_t start = 0;
+	while (start < kept.size()) {
+		std::size_t end = kept.find('\n', start);
+		nlohmann::json record = nlohmann::json::parse(std::string_view(kept).substr(start, end - start));
+		apply_journal_record(record);
+		journal.append(record);
+		start = end + 1;
+	}
+	batch_depth = level - 1;
+	batch_starts = std::move(outer_starts);
+}
+
+std::vector<Task*> TaskManager::add_tasks(std::span<const std::string> descriptions) {
+	Transaction transaction(*this);
+	std::vector<Task*> added;
+	added.reserve(descriptions.size());
+	for (const std::string& description : descriptions) {
+		added.push_back(add_task(description));
+	}
+	transaction.commit();
+	return added;
+}
+
+std::size_t TaskManager::update_status_bulk(std::span<const int> ids, TaskStatus status) {
+	Transaction transaction(*this);
+	std::size_t updated = 0;
+	for (int id : ids) {
+		Task* task = find_writable(id);
+		if (!task) {
+			continue;
+		}
+		TaskStatus old_status = task->get_status();
+		std::time_t old_updated = task->get_updated_at();
+		task->update_status(status);
+		reindex_status(id, old_status, status);
+		reindex_updated(id, old_updated, task->get_updated_at());
+		log_update(*task, "update");
+		updated++;
+	}
+	transaction.commit();
+	return updated;
+}
+
+ImportResult TaskManager::import_stream(std::istream& input, ImportOptions import_options) {
+	ImportReader reader(input, import_options.format);
+	ImportResult result;
+	// 只为导入的任务写 journal; 读入的分片任务也会追加在末尾, 不能按位置区分
+	std::vector<int> imported;
+	std::time_t now = std::time(nullptr);
+	ImportRecord record;
+	ImportReader::Result read;
+	while ((read = reader.next(record)) != ImportReader::Result::End) {
+		if (read == ImportReader::Result::Rejected) {
+			result.reject(reader.line());
+			continue;
+		}
+		int id = import_options.ids == ImportIds::Preserve && record.id ? *record.id : next_id;
+		// 重新编号时 next_id 可能已经用完
+		if (!valid_task_id(id)) {
+			result.reject(reader.line());
+			continue;
+		}
+		touch_shard(id);
+		if (slots.find(id)) {
+			result.reject(reader.line());
+			continue;
+		}
+		std::time_t created_at = record.created_at.value_or(now);
+		insert_task(store.create(id, record.description, record.status, created_at, record.updated_at.value_or(created_at)));
+		next_id = std::max(next_id, id + 1);
+		imported.push_back(id);
+		result.imported++;
+	}
+	if (result.imported == 0) {
+		return result;
+	}
+
+	// 导入的任务比存储中其余的还多时, 直接重写快照, 不用为每个任务生成 journal 记录
+	if (!in_batch() && unsaved_records + result.imported >= std::max(min_journal_records, slots.size())) {
+		save_to_file();
+		return result;
+	}
+	Transaction transaction(*this);
+	for (int id : imported) {
+		log_update(*tasks[*slots.find(id)], "add");
+	}
+	transaction.commit();
+	return result;
+}
+
+Transaction::Transaction(TaskManager& manager)
+	: manager(manager) {
+	manager.begin_batch();
+	level = manager.batch_level();
+}
+
+Transaction::~Transaction() {
+	if (open) {
+		try {
+			manager.rollback_to(level);
+		}
+		catch (const std::exception& e) {
+			std::cerr << "Failed to roll back batch: " << e.what() << std::endl;
+		}
+	}
+}
+
+void Transaction::commit() {
+	open = false;
+	manager.commit();
+}
+
 	
 
 
-Task* TaskManager::add_task(std::string description) {
-	std::unique_ptr<Task> task = std::make_unique<Task>(next_id, description);
-	tasks.push_back(std::move(task));
+Task* TaskManager::add_task(std::string_view description) {
+	// ID 用完后再添加会让 next_id 溢出
+	if (!valid_task_id(next_id)) {
+		throw std::runtime_error("No free task id left");
+	}
+	touch_shard(next_id);
+	std::time_t now = std::time(nullptr);
+	Task* added = insert_task(store.create(next_id, description, TaskStatus::TO_DO, now, now));
 	next_id++;
-	save_to_file();
-	return tasks.back().get();
+	log_update(*added, "add");
+	return added;
 }
 
 bool TaskManager::remove_task(int id) {
-	const size_t original_size = tasks.size();
-
-	tasks.erase(
-		std::remove_if(tasks.begin(), tasks.end(),
-			[&id](const std::unique_ptr<Task>& task) {
-				return task->get_id() == id;
-			}),
-		tasks.end()
-	);
-	const size_t new_size = tasks.size();
-	save_to_file();
-	return new_size < original_size;
+	if (!erase_task(id)) {
+		return false;
+	}
+	log_remove(id);
+	return true;
 }
 
 bool TaskManager::remove_last_task() {
+	load_all_shards();
 	if (tasks.empty()) {
 		return false; // No tasks to remove
 	}
-	tasks.pop_back();
-	save_to_file();
+	// erase_task 不会在末尾留下空位
+	int id = tasks.back()->get_id();
+	erase_task(id);
+	log_remove(id);
 	return true;
 }
 
 bool TaskManager::clear_all_tasks() {
-	if (tasks.empty()) {
+	if (IsEmpty()) {
 		return false; // No tasks to clear
 	}
-	tasks.clear();
-	save_to_file();
+	clear_store();
+	clear_shards();
+	append_record({ {"op", "clear"} });
+	maybe_compact();
 	return true;
 }
 
 Task* TaskManager::get_task(int id) {
-	for (const auto& task : tasks) {
-		if (task->get_id() == id) {
-			return task.get();
-		}
+	load_shard_of(id);
+	std::uint32_t* found = slots.find(id);
+	if (!found) {
+		return nullptr;
 	}
-	return nullptr;
+	return tasks[*found];
+}
+
+const Task* TaskManager::get_task(int id) const {
+	load_shard_of(id);
+	const std::uint32_t* found = slots.find(id);
+	if (!found) {
+		return nullptr;
+	}
+	return tasks[*found];
 }
 
 Task*
-TaskManager::update_task_status(int id, std::string new_status) {
-	Task* task = get_task(id);
+TaskManager::update_task_status(int id, std::string_view new_status) {
+	Task* task = find_writable(id);
 	if (task) {
+		TaskStatus old_status = task->get_status();
+		std::time_t old_updated = task->get_updated_at();
 		task->update_status(new_status);
+		reindex_status(id, old_status, task->get_status());
+		reindex_updated(id, old_updated, task->get_updated_at());
+		log_update(*task, "update");
 	}
 	else {
 		std::cerr << "Task with ID " << id << " not found." << std::endl;
 	}
-	save_to_file();
 	return task;
 }
 
-Task* TaskManager::update_task_description(int id, const std::string new_description) {
-	Task* task = get_task(id);
+Task* TaskManager::update_task_description(int id, std::string_view new_description) {
+	Task* task = find_writable(id);
 	if (task) {
-		task->update_description(new_description);
+		if (text_indexed) {
+			words.remove(id, task->get_description());
+			words.add(id, new_description);
+		}
+		std::time_t old_updated = task->get_updated_at();
+		store.update_description(task, new_description);
+		reindex_updated(id, old_updated, task->get_updated_at());
+		log_update(*task, "update");
 	}
 	else {
 		std::cerr << "Task with ID " << id << " not found." << std::endl;
 	}
-	save_to_file();
 	return task;
 }
 
-std::vector<const Task*> TaskManager::list_tasks() {
+std::vector<const Task*> TaskManager::list_tasks() const {
+	load_all_shards();
 	std::vector<const Task*> task_list;
-	tasks.reserve(tasks.size());
+	task_list.reserve(slots.size());
 	for (const auto& task : tasks) {
-		task_list.push_back(task.get());
+		if (task) {
+			task_list.push_back(task);
+		}
 	}
 	return task_list;
 }
 
-std::vector<const Task*> TaskManager::list_tasks(TaskStatus statu){
+std::vector<const Task*> TaskManager::list_tasks(TaskStatus statu) const {
+	load_all_shards();
+	const std::pmr::set<int>& ids = by_status[status_slot(statu)];
 	std::vector<const Task*> filtered_tasks;
-	for (const auto& task : tasks) {
-		if( task->get_status() == statu ) {
-			filtered_tasks.push_back( task.get() );
-		}
+	filtered_tasks.reserve(ids.size());
+	for (int id : ids) {
+		filtered_tasks.push_back( tasks[*slots.find(id)] );
 	}
 	return filtered_tasks;
 }
 
+std::vector<const Task*> TaskManager::search(std::string_view query) const {
+	load_all_shards();
+	if (!text_indexed) {
+		// 第一次搜索时才建立索引, 之后由增删改操作增量维护
+		for (const Task* task : tasks) {
+			if (task) {
+				words.add(task->get_id(), task->get_description());
+			}
+		}
+		text_indexed = true;
+	}
+	std::vector<const Task*> found;
+	for (int id : words.search(query)) {
+		found.push_back(tasks[*slots.find(id)]);
+	}
+	return found;
+}
 
+void TaskManager::build_time_index() const {
+	if (time_indexed) {
+		return;
+	}
+	// 和全文索引一样, 第一次查询时才建立
+	time_indexed = true;
+	for (const Task* task : tasks) {
+		if (task) {
+			index_times(*task);
+		}
+	}
+}
 
-void TaskManager::save_to_file() {
-	nlohmann::json j_root;
+// 按 before 给出的顺序合并几个有序 id 集合的区间 [first, last), 取到 limit 个为止
+template <typename It, typename Before>
+static void merge_id_ranges(std::vector<std::pair<It, It>>& ranges, Before before, std::size_t limit, std::vector<int>& ids) {
+	while (ids.size() < limit) {
+		std::pair<It, It>* next = nullptr;
+		for (std::pair<It, It>& range : ranges) {
+			if (range.first != range.second && (!next || before(*range.first, *next->first))) {
+				next = &range;
+			}
+		}
+		if (!next) {
+			break;
+		}
+		ids.push_back(*next->first++);
+	}
+}
+
+std::vector<const Task*> TaskManager::list_tasks(ListOrder order, std::size_t limit,
+	std::optional<TaskCursor> after, std::optional<TaskStatus> statu) const {
+	load_all_shards();
+	std::vector<const Task*> page;
+	if (limit == 0) {
+		return page;
+	}
+	page.reserve(std::min(limit, slots.size()));
 
-	j_root["next_id"] = next_id; 
+	if (order.key == SortKey::Id) {
+		// 状态索引本身按 id 排序, 合并三个 (或指定状态的一个) 集合即可
+		std::vector<const std::pmr::set<int>*> sets;
+		for (std::size_t slot = 0; slot < by_status.size(); slot++) {
+			if (!statu || status_slot(*statu) == slot) {
+				sets.push_back(&by_status[slot]);
+			}
+		}
+		std::vector<int> ids;
+		if (order.descending) {
+			using It = std::pmr::set<int>::const_reverse_iterator;
+			std::vector<std::pair<It, It>> ranges;
+			for (const std::pmr::set<int>* set : sets) {
+				ranges.emplace_back(It(after ? set->lower_bound(after->id) : set->end()), set->rend());
+			}
+			merge_id_ranges(ranges, std::greater<int>(), limit, ids);
+		}
+		else {
+			using It = std::pmr::set<int>::const_iterator;
+			std::vector<std::pair<It, It>> ranges;
+			for (const std::pmr::set<int>* set : sets) {
+				ranges.emplace_back(after ? set->upper_bound(after->id) : set->begin(), set->end());
+			}
+			merge_id_ranges(ranges, std::less<int>(), limit, ids);
+		}
+		for (int id : ids) {
+			page.push_back(tasks[*slots.find(id)]);
+		}
+		return page;
+	}
 
-	nlohmann::json j_tasks = nlohmann::json::array();
+	build_time_index();
+	const TimeIndex& index = by_time[order.key == SortKey::Created ? 0 : 1];
+	auto collect = [&](auto it, auto end) {
+		for (; it != end && page.size() < limit; ++it) {
+			const Task* task = tasks[*slots.find(it->second)];
+			if (!statu || task->get_status() == *statu) {
+				page.push_back(task);
+			}
+		}
+	};
+	std::pair<std::time_t, int> from = after ? std::make_pair(after->time, after->id) : std::make_pair(std::time_t(), 0);
+	if (order.descending) {
+		collect(TimeIndex::const_reverse_iterator(after ? index.lower_bound(from) : index.end()), index.rend());
+	}
+	else {
+		collect(after ? index.upper_bound(from) : index.begin(), index.end());
+	}
+	return page;
+}
 
-	for (const auto& task : tasks) {
-		nlohmann::json j_task;
+std::vector<const Task*> TaskManager::list_tasks_between(TimeField field, std::time_t from, std::time_t to) const {
+	load_all_shards();
+	build_time_index();
+	std::vector<const Task*> found;
+	if (from > to) {
+		return found;
+	}
+	const TimeIndex& index = by_time[field == TimeField::Created ? 0 : 1];
+	auto end = index.upper_bound({ to, std::numeric_limits<int>::max() });
+	for (auto it = index.lower_bound({ from, std::numeric_limits<int>::min() }); it != end; ++it) {
+		found.push_back(tasks[*slots.find(it->second)]);
+	}
+	return found;
+}
 
-		if (!task) {
-			continue; // Skip null tasks
+std::vector<const Task*> TaskManager::filter_contains(std::string_view text) const {
+	load_all_shards();
+	SubstringMatcher matches(text);
+	// 每块的结果单独收集, 再按顺序拼接
+	std::vector<std::vector<const Task*>> parts(parallel_chunks(tasks.size(), options.threads, min_filter_chunk));
+	parallel_for(tasks.size(), options.threads, min_filter_chunk, [&](std::size_t chunk, std::size_t begin, std::size_t end) {
+		for (std::size_t slot = begin; slot < end; slot++) {
+			const Task* task = tasks[slot];
+			if (task && matches(task->get_description())) {
+				parts[chunk].push_back(task);
+			}
 		}
+	});
+	if (parts.size() == 1) {
+		return std::move(parts[0]);
+	}
+	std::vector<const Task*> found;
+	for (const std::vector<const Task*>& part : parts) {
+		found.insert(found.end(), part.begin(), part.end());
+	}
+	return found;
+}
+
+
 
-		j_task["id"] = task->get_id();
-		j_task["description"] = task->get_description();
-		j_task["status"] = status_to_string(task->get_status());
-		j_task["created_at"] = task->get_created_at();
-		j_task["updated_at"] = task->get_updated_at();
-		j_tasks.push_back(j_task);
+SnapshotFormat TaskManager::snapshot_format() const {
+	if (options.format == SnapshotFormat::Auto) {
+		return format_for_path(filename);
 	}
-	j_root["tasks"] = j_tasks;
+	return options.format;
+}
 
-	std::ofstream file(filename);
-	if(!file.is_open()) {
-		std::cerr << "Failed to open file for writing: " << filename << std::endl;
-		throw std::runtime_error("Could not open file for writing: " + filename);
+void TaskManager::export_snapshot(const std::string& path, SnapshotFormat format) const {
+	if (format == SnapshotFormat::Auto) {
+		format = format_for_path(path);
+	}
+	try {
+		write_file_atomically(path, encode_snapshot(format, next_id, list_tasks(), options.threads), options.durability);
+	}
+	catch (const std::runtime_error&) {
+		std::cerr << "Failed to write file: " << path << std::endl;
+		throw;
+	}
+}
+
+void TaskManager::release_mapping() {
+	if (!mapping) {
 		return;
 	}
+	for (std::size_t slot = 0; slot < tasks.size(); slot++) {
+		if (tasks[slot] && !tasks[slot]->owns_description()) {
+			// 快照看得到的任务会被复制, 旧任务继续引用快照持有的映射
+			store.own_description(writable_task(static_cast<std::uint32_t>(slot)));
+		}
+	}
+	mapping.reset();
+}
 
-	file << j_root.dump(4); // Pretty print with 4 spaces indentation
-	file.close();
+void TaskManager::save_to_file() {
+	if (shards.enabled()) {
+		save_shards();
+		return;
+	}
+	std::vector<const Task*> listed = list_tasks();
+	std::string content = encode_snapshot(snapshot_format(), next_id, listed, options.threads);
+	std::uint64_t fingerprint = snapshot_fingerprint(listed);
+	// 文件即将被覆盖, 先让任务持有自己的描述
+	release_mapping();
+	unsaved_records = 0;
+
+	if (writer) {
+		writer->submit_snapshot(std::move(content), fingerprint);
+	}
+	else {
+		write_snapshot(content, fingerprint);
+	}
+}
+
+void TaskManager::save_shards() {
+	// 只重写改动过的分片, 所以分片存储同步写出, 先等后台线程写完 journal
+	if (writer) {
+		writer->flush();
+	}
+	std::map<std::int64_t, std::vector<const Task*>> changed;
+	for (auto& [index, shard] : shards.all()) {
+		if (shard.dirty) {
+			changed[index];
+		}
+	}
+	for (const Task* task : tasks) {
+		if (task) {
+			auto bucket = changed.find(shards.shard_of(task->get_id()));
+			if (bucket != changed.end()) {
+				bucket->second.push_back(task);
+			}
+		}
+	}
+
+	std::vector<std::string> emptied;
+	for (auto& [index, shard_tasks] : changed) {
+		ShardSet::Shard& shard = shards.at(index);
+		std::string path = shards.path(index);
+		shard.counts = {};
+		if (shard_tasks.empty()) {
+			if (shard.listed) {
+				emptied.push_back(path);
+			}
+			shard.listed = false;
+			continue;
+		}
+		for (const Task* task : shard_tasks) {
+			shard.counts[status_slot(task->get_status())]++;
+		}
+		try {
+			write_file_atomically(path, encode_snapshot(snapshot_format(), next_id, shard_tasks, options.threads), options.durability);
+		}
+		catch (const std::runtime_error&) {
+			std::cerr << "Failed to write file: " << path << std::endl;
+			throw;
+		}
+		shard.listed = true;
+	}
+
+	// 清单写在分片之后, 中途崩溃时旧清单加旧 journal 回放到新分片上结果相同
+	std::string manifest = shards.encode(next_id);
+	write_snapshot(manifest, Journal::fingerprint(manifest));
+	for (const std::string& path : emptied) {
+		std::remove(path.c_str());
+	}
+	for (auto& [index, shard] : shards.all()) {
+		shard.dirty = false;
+	}
+	unsaved_records = 0;
+}
+
+void TaskManager::write_snapshot(const std::string& content, std::uint64_t fingerprint) {
+	// 先写临时文件再改名, 崩溃时 filename 要么是旧快照要么是新快照;
+	// 改名之后、重置 journal 之前崩溃时, 旧 journal 的指纹对不上新快照, 会被丢弃
+	try {
+		write_file_atomically(filename, content, options.durability);
+	}
+	catch (const std::runtime_error&) {
+		std::cerr << "Failed to write file: " << filename << std::endl;
+		throw;
+	}
+
+	// 快照已包含所有修改, 重新开始一个空的 journal
+	journal.reset(fingerprint);
 }
\ No newline at end of file
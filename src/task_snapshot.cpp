@@ -0,0 +1,119 @@
+#include "task_snapshot.h"
+#include <iostream>
+#include <stdexcept>
+
+TaskOrder::Block& TaskOrder::writable(std::size_t block) {
+	std::shared_ptr<Block>& shared = blocks[block];
+	// A count of 1 cannot grow behind our back: only this copy can be copied
+	// from, and that happens on the thread that owns it.
+	if (shared.use_count() > 1) {
+		shared = std::make_shared<Block>(*shared);
+	}
+	return *shared;
+}
+
+void TaskOrder::set(std::size_t index, Task* task) {
+	writable(index / block_size)[index % block_size] = task;
+}
+
+void TaskOrder::push_back(Task* task) {
+	if (count % block_size == 0) {
+		blocks.push_back(std::make_shared<Block>());
+	}
+	writable(count / block_size)[count % block_size] = task;
+	count++;
+}
+
+void TaskOrder::pop_back() {
+	count--;
+	if (count % block_size == 0) {
+		blocks.pop_back();
+	}
+}
+
+void TaskOrder::clear() {
+	blocks.clear();
+	count = 0;
+}
+
+void TaskOrder::remove_nulls() {
+	TaskOrder kept;
+	for (Task* task : *this) {
+		if (task) {
+			kept.push_back(task);
+		}
+	}
+	*this = std::move(kept);
+}
+
+void SnapshotRegistry::acquire(std::uint64_t version) {
+	std::lock_guard<std::mutex> lock(mutex);
+	versions.insert(version);
+	live.fetch_add(1, std::memory_order_release);
+}
+
+void SnapshotRegistry::release(std::uint64_t version) {
+	std::lock_guard<std::mutex> lock(mutex);
+	versions.erase(versions.find(version));
+	live.fetch_sub(1, std::memory_order_release);
+}
+
+std::uint64_t SnapshotRegistry::oldest() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	return versions.empty() ? 0 : *versions.begin();
+}
+
+std::uint64_t SnapshotRegistry::newest() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	return versions.empty() ? 0 : *versions.rbegin();
+}
+
+std::vector<const Task*> TaskSnapshot::list_tasks() const {
+	std::vector<const Task*> task_list;
+	task_list.reserve(state->size);
+	for_each([&task_list](const Task& task) {
+		task_list.push_back(&task);
+	});
+	return task_list;
+}
+
+std::vector<const Task*> TaskSnapshot::list_tasks(TaskStatus statu) const {
+	std::vector<const Task*> filtered_tasks;
+	for_each([&filtered_tasks, statu](const Task& task) {
+		if (task.get_status() == statu) {
+			filtered_tasks.push_back(&task);
+		}
+	});
+	return filtered_tasks;
+}
+
+std::size_t TaskSnapshot::count_tasks(TaskStatus statu) const {
+	std::size_t count = 0;
+	for_each([&count, statu](const Task& task) {
+		count += task.get_status() == statu;
+	});
+	return count;
+}
+
+const Task* TaskSnapshot::get_task(int id) const {
+	for (const Task* task : state->order) {
+		if (task && task->get_id() == id) {
+			return task;
+		}
+	}
+	return nullptr;
+}
+
+void TaskSnapshot::export_snapshot(const std::string& path, SnapshotFormat format, Durability durability,
+	unsigned threads) const {
+	if (format == SnapshotFormat::Auto) {
+		format = format_for_path(path);
+	}
+	try {
+		write_file_atomically(path, encode_snapshot(format, state->next_id, list_tasks(), threads), durability);
+	}
+	catch (const std::runtime_error&) {
+		std::cerr << "Failed to write file: " << path << std::endl;
+		throw;
+	}
+}
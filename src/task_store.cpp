@@ -0,0 +1,180 @@
+#include "task_store.h"
+#include <cstring>
+#include <new>
+#include <unordered_set>
+
+StringPool::StringPool(std::pmr::memory_resource* memory)
+	: memory(memory) {
+}
+
+StringPool::~StringPool() {
+	clear();
+}
+
+std::string_view StringPool::store(std::string_view text) {
+	if (text.empty()) {
+		return std::string_view();
+	}
+	char* bytes;
+	std::size_t size = rounded(text.size());
+	if (size > max_pooled) {
+		// Large texts get an allocation of their own so they do not waste the
+		// tail of the block being filled.
+		bytes = static_cast<char*>(memory->allocate(text.size(), 1));
+		large.emplace(bytes, text.size());
+		reserved += text.size();
+		used += text.size();
+		std::memcpy(bytes, text.data(), text.size());
+		return std::string_view(bytes, text.size());
+	}
+
+	std::size_t size_class = size / granularity;
+	if (size_class < free_lists.size() && free_lists[size_class]) {
+		bytes = free_lists[size_class];
+		std::memcpy(&free_lists[size_class], bytes, sizeof(char*));
+	}
+	else {
+		if (block_size - block_used < size) {
+			blocks.push_back(static_cast<char*>(memory->allocate(block_size, alignof(char*))));
+			reserved += block_size;
+			block_used = 0;
+		}
+		bytes = blocks.back() + block_used;
+		block_used += size;
+	}
+	used += size;
+	std::memcpy(bytes, text.data(), text.size());
+	return std::string_view(bytes, text.size());
+}
+
+void StringPool::release(std::string_view text) {
+	if (text.empty()) {
+		return;
+	}
+	char* bytes = const_cast<char*>(text.data());
+	std::size_t size = rounded(text.size());
+	if (size > max_pooled) {
+		large.erase(bytes);
+		memory->deallocate(bytes, text.size(), 1);
+		reserved -= text.size();
+		used -= text.size();
+		return;
+	}
+	std::size_t size_class = size / granularity;
+	if (size_class >= free_lists.size()) {
+		free_lists.resize(size_class + 1, nullptr);
+	}
+	std::memcpy(bytes, &free_lists[size_class], sizeof(char*));
+	free_lists[size_class] = bytes;
+	used -= size;
+}
+
+void StringPool::clear() {
+	for (char* block : blocks) {
+		memory->deallocate(block, block_size, alignof(char*));
+	}
+	blocks.clear();
+	for (const auto& [bytes, size] : large) {
+		memory->deallocate(const_cast<char*>(bytes), size, 1);
+	}
+	large.clear();
+	free_lists.clear();
+	block_used = block_size;
+	reserved = 0;
+	used = 0;
+}
+
+TaskStore::TaskStore(std::pmr::memory_resource* memory)
+	: memory(memory), strings(memory) {
+}
+
+TaskStore::~TaskStore() {
+	clear();
+}
+
+TaskStore::Slot* TaskStore::allocate_slot() {
+	if (!free_slots.empty()) {
+		Slot* slot = free_slots.back();
+		free_slots.pop_back();
+		return slot;
+	}
+	if (chunk_used == chunk_size) {
+		chunks.push_back(static_cast<Slot*>(memory->allocate(chunk_size * sizeof(Slot), alignof(Slot))));
+		chunk_used = 0;
+	}
+	return &chunks.back()[chunk_used++];
+}
+
+bool TaskStore::pooled(const Task* task) {
+	return !task->borrowed && !task->owned_description;
+}
+
+Task* TaskStore::create(int id, std::string_view description, TaskStatus status, std::time_t created_at, std::time_t updated_at) {
+	Task* task = create_borrowed(id, strings.store(description), status, created_at, updated_at);
+	task->borrowed = false; // the pool lives as long as the task
+	return task;
+}
+
+Task* TaskStore::create_borrowed(int id, std::string_view description, TaskStatus status, std::time_t created_at, std::time_t updated_at) {
+	Slot* slot = allocate_slot();
+	Task* task = new (slot->bytes) Task(id, std::string_view(), status, created_at, updated_at);
+	task->description = description;
+	task->borrowed = true;
+	live++;
+	return task;
+}
+
+void TaskStore::destroy(Task* task) {
+	if (pooled(task)) {
+		strings.release(task->description);
+	}
+	task->~Task();
+	free_slots.push_back(reinterpret_cast<Slot*>(task));
+	live--;
+}
+
+void TaskStore::clear() {
+	if (live > 0) {
+		std::unordered_set<Slot*> free_set(free_slots.begin(), free_slots.end());
+		for (std::size_t c = 0; c < chunks.size(); c++) {
+			std::size_t used = (c + 1 == chunks.size()) ? chunk_used : chunk_size;
+			for (std::size_t i = 0; i < used; i++) {
+				Slot* slot = &chunks[c][i];
+				if (!free_set.count(slot)) {
+					std::launder(reinterpret_cast<Task*>(slot->bytes))->~Task();
+				}
+			}
+		}
+	}
+	for (Slot* chunk : chunks) {
+		memory->deallocate(chunk, chunk_size * sizeof(Slot), alignof(Slot));
+	}
+	chunks.clear();
+	chunk_used = chunk_size;
+	free_slots.clear();
+	live = 0;
+	strings.clear();
+}
+
+void TaskStore::update_description(Task* task, std::string_view description) {
+	// Store first: `description` may view the old text
+	std::string_view stored = strings.store(description);
+	if (pooled(task)) {
+		strings.release(task->description);
+	}
+	task->description = stored;
+	task->owned_description.reset();
+	task->borrowed = false;
+	task->updated_at = std::time(nullptr);
+}
+
+void TaskStore::own_description(Task* task) {
+	if (task->borrowed) {
+		task->description = strings.store(task->description);
+		task->borrowed = false;
+	}
+}
+
+std::size_t TaskStore::bytes_reserved() const {
+	return chunks.size() * chunk_size * sizeof(Slot) + strings.bytes_reserved();
+}
@@ -0,0 +1,104 @@
+#include "text_index.h"
+#include <algorithm>
+
+std::vector<std::string> TextIndex::unique_words(std::string_view text) {
+	std::vector<std::string> words;
+	for_each_word(text, [&words](std::string_view word, std::size_t) {
+		words.emplace_back(word);
+	});
+	std::sort(words.begin(), words.end());
+	words.erase(std::unique(words.begin(), words.end()), words.end());
+	return words;
+}
+
+void TextIndex::add(int id, std::string_view description) {
+	for (std::string& word : unique_words(description)) {
+		std::vector<int>& ids = postings[std::move(word)];
+		if (ids.empty() || ids.back() < id) {
+			ids.push_back(id);
+			continue;
+		}
+		auto at = std::lower_bound(ids.begin(), ids.end(), id);
+		if (*at != id) {
+			ids.insert(at, id);
+		}
+	}
+}
+
+void TextIndex::remove(int id, std::string_view description) {
+	for (const std::string& word : unique_words(description)) {
+		auto found = postings.find(word);
+		if (found == postings.end()) {
+			continue;
+		}
+		std::vector<int>& ids = found->second;
+		auto at = std::lower_bound(ids.begin(), ids.end(), id);
+		if (at != ids.end() && *at == id) {
+			ids.erase(at);
+		}
+		if (ids.empty()) {
+			postings.erase(found);
+		}
+	}
+}
+
+std::vector<int> TextIndex::prefix_postings(std::string_view prefix) const {
+	std::vector<int> ids;
+	for (auto it = postings.lower_bound(prefix); it != postings.end() && it->first.starts_with(prefix); ++it) {
+		ids.insert(ids.end(), it->second.begin(), it->second.end());
+	}
+	std::sort(ids.begin(), ids.end());
+	ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+	return ids;
+}
+
+std::vector<int> TextIndex::search(std::string_view query) const {
+	// A query word is followed by '*' when it is a prefix
+	std::vector<std::string> exact, prefixes;
+	for_each_word(query, [&](std::string_view word, std::size_t end) {
+		(end < query.size() && query[end] == '*' ? prefixes : exact).emplace_back(word);
+	});
+	if (exact.empty() && prefixes.empty()) {
+		return {};
+	}
+
+	std::vector<const std::vector<int>*> lists;
+	for (const std::string& word : exact) {
+		auto found = postings.find(word);
+		if (found == postings.end()) {
+			return {};
+		}
+		lists.push_back(&found->second);
+	}
+	std::vector<std::vector<int>> merged;
+	merged.reserve(prefixes.size());
+	for (const std::string& prefix : prefixes) {
+		merged.push_back(prefix_postings(prefix));
+		if (merged.back().empty()) {
+			return {};
+		}
+		lists.push_back(&merged.back());
+	}
+
+	// Walk the shortest list and look each id up in the others, whose
+	// search ranges only shrink since both sides are sorted
+	std::sort(lists.begin(), lists.end(), [](const std::vector<int>* a, const std::vector<int>* b) {
+		return a->size() < b->size();
+	});
+	std::vector<std::vector<int>::const_iterator> from;
+	for (const std::vector<int>* list : lists) {
+		from.push_back(list->begin());
+	}
+	std::vector<int> result;
+	for (int id : *lists[0]) {
+		bool everywhere = true;
+		for (std::size_t i = 1; i < lists.size() && everywhere; i++) {
+			from[i] = std::lower_bound(from[i], lists[i]->end(), id);
+			everywhere = from[i] != lists[i]->end() && *from[i] == id;
+		}
+		if (everywhere) {
+			result.push_back(id);
+		}
+	}
+	return result;
+}
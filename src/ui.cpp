@@ -1,35 +1,26 @@
-#pragma once
-
 #include <iostream>
 #include <vector>
 #include "task.h"
 #include "ui.h"
 
+// Each thread renders into its own buffer, which keeps its capacity between
+// calls.
+static TaskRenderer& renderer(RenderStyle style) {
+	thread_local TaskRenderer instance;
+	instance.set_style(style);
+	return instance;
+}
+
 void print_task(const Task* task) {
-	if (task == nullptr) {
-		std::cout << "Task is null." << std::endl;
-		return;
-	}
-	std::cout << "-------------------------" << std::endl;
-	std::cout << "Task ID: " << task->get_id() << std::endl;
-	std::cout << "Description: " << task->get_description() << std::endl;
-	std::cout << "Status: " << status_to_string(task->get_status()) << std::endl;
-	std::time_t created_at = task->get_created_at();
-	std::time_t updated_at = task->get_updated_at();
-	std::cout << "Created At: " << std::asctime(std::localtime(&created_at));
-	std::cout << "Updated At: " << std::asctime(std::localtime(&updated_at));
-	std::cout << "-------------------------" << std::endl;
+	TaskRenderer& out = renderer(RenderStyle::Detailed);
+	out.append(task);
+	out.write(std::cout);
 }
 
-void print_tasks(const std::vector<const Task*>& tasks) {
-	if (tasks.empty()) {
-		std::cout << "No tasks to display." << std::endl;
-		return;
-	}
-	for (const auto& task : tasks) {
-		print_task(task);
-		std::cout << "------------------------" << std::endl;
-	}
+void print_tasks(const std::vector<const Task*>& tasks, RenderStyle style) {
+	TaskRenderer& out = renderer(style);
+	out.append_tasks(tasks, std::cout);
+	out.write(std::cout);
 }
 
 void print_added_task(const Task* task) {
@@ -37,7 +28,20 @@ void print_added_task(const Task* task) {
 	print_task(task);
 }	
 
-void print_get_task(const Task* task) {
+void print_get_task(const Task* task, RenderStyle style) {
+	if (!is_human_readable(style)) {
+		// Keep stdout to the records themselves, so it can be parsed
+		if (task) {
+			TaskRenderer& out = renderer(style);
+			out.append_header();
+			out.append(task);
+			out.write(std::cout);
+		}
+		else {
+			std::cerr << "Task not found." << std::endl;
+		}
+		return;
+	}
 	if (task) {
 		std::cout << "Task found:" << std::endl;
 		print_task(task);
@@ -79,3 +83,21 @@ void print_cleared_all_tasks(bool success) {
 	}
 }
 
+std::size_t export_tasks(const TaskManager& manager, std::ostream& out, RenderStyle style,
+	std::optional<TaskStatus> statu) {
+	TaskRenderer& writer = renderer(style);
+	std::size_t count = 0;
+	auto emit = [&](const Task& task) {
+		writer.append_listed(&task, out);
+		count++;
+	};
+	writer.append_header();
+	if (statu) {
+		manager.for_each_task(*statu, emit);
+	}
+	else {
+		manager.for_each_task(emit);
+	}
+	writer.write(out);
+	return count;
+}
@@ -0,0 +1,74 @@
+#include <gtest/gtest.h>
+#include "task-tracker/task_manager.h"
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+
+// 在单独的目录中运行 task-tracker (它总是打开当前目录下的 tasks.json)
+class CliTest : public ::testing::Test {
+protected:
+    std::filesystem::path dir = std::filesystem::absolute("cli_test_dir");
+
+    void SetUp() override {
+#ifdef _WIN32
+        GTEST_SKIP() << "runs the executable through a POSIX shell";
+#endif
+        std::filesystem::remove_all(dir);
+        std::filesystem::create_directories(dir);
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(dir);
+    }
+
+    void write(const std::string& name, const std::string& content) {
+        std::ofstream file(dir / name, std::ios::binary);
+        file << content;
+    }
+
+    std::string read(const std::string& name) {
+        std::ifstream file(dir / name, std::ios::binary);
+        return std::string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    }
+
+    // 返回 0 表示成功; 标准输出和标准错误写入 out.txt 和 err.txt
+    int run(const std::string& args, const std::string& input = "/dev/null") {
+        std::string command = "cd '" + dir.string() + "' && '" TASK_TRACKER_EXE "' " + args
+            + " < " + input + " > out.txt 2> err.txt";
+        return std::system(command.c_str());
+    }
+};
+
+TEST_F(CliTest, FailedScriptKeepsTheOuterBatch) {
+    write("bad.txt", "--add \"Script task\"\n--get 99\n");
+    write("input.txt", "--begin\n--add \"Outer task\"\n--script bad.txt\n--commit\nexit\n");
+    run("", "input.txt");
+    EXPECT_NE(read("err.txt").find("bad.txt:2:"), std::string::npos);
+
+    // 脚本失败只放弃脚本自己的修改, REPL 中 --begin 之后的修改照常提交
+    TaskManager manager((dir / "tasks.json").string());
+    ASSERT_EQ(manager.list_tasks().size(), 1);
+    EXPECT_EQ(manager.get_task(1)->get_description(), "Outer task");
+}
+
+TEST_F(CliTest, ScriptsCannotEndTheirOwnBatch) {
+    // 脚本中的 --commit 是用法错误, 之前的修改也一起放弃
+    write("commit.txt", "--add \"First\"\n--commit\n--add \"Second\"\n");
+    EXPECT_NE(run("--script commit.txt"), 0);
+    EXPECT_NE(read("err.txt").find("commit.txt:2:"), std::string::npos);
+    write("rollback.txt", "--add \"First\"\n--rollback\n");
+    EXPECT_NE(run("--script rollback.txt"), 0);
+    EXPECT_TRUE(TaskManager((dir / "tasks.json").string()).list_tasks().empty());
+
+    write("good.txt", "# comment\n--add \"First\"\n\n--add \"Second\"\n");
+    EXPECT_EQ(run("--script good.txt"), 0);
+    EXPECT_EQ(TaskManager((dir / "tasks.json").string()).list_tasks().size(), 2);
+}
+
+TEST_F(CliTest, ScriptsCannotRunScripts) {
+    // 脚本调用自身不能无限递归, 嵌套的 --script 是用法错误
+    write("self.txt", "--add \"First\"\n--script self.txt\n");
+    EXPECT_NE(run("--script self.txt"), 0);
+    EXPECT_NE(read("err.txt").find("self.txt:2:"), std::string::npos);
+    EXPECT_TRUE(TaskManager((dir / "tasks.json").string()).list_tasks().empty());
+}
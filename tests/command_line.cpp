@@ -0,0 +1,95 @@
+#include <gtest/gtest.h>
+#include "task-tracker/command_line.h"
+#include <iomanip>
+#include <sstream>
+
+static std::vector<std::string> lex(std::string line) {
+    CommandLexer lexer(line);
+    std::vector<std::string> tokens;
+    std::string_view token;
+    while (lexer.next(token)) {
+        tokens.emplace_back(token);
+    }
+    return tokens;
+}
+
+static ParsedCommand parse(std::string& line) {
+    CommandLexer lexer(line);
+    return parse_command(lexer);
+}
+
+TEST(CommandLexerTest, MatchesStdQuoted) {
+    for (std::string line : {
+        "", "   ", "--list", "  --add  \"Buy milk\"  ", "--add \"say \\\"hi\\\"\" --status DONE",
+        "--add=\"a b\"", "\"a\"b c", "\"\"", "\"back\\\\slash\"", "\t--get\t7\r\n", "--add \"unclosed",
+        "--add \"ends in escape\\", "x\"y\" \"z\"" }) {
+        std::istringstream iss(line);
+        std::vector<std::string> expected;
+        std::string token;
+        while (iss >> std::quoted(token)) {
+            expected.push_back(token);
+        }
+        EXPECT_EQ(lex(line), expected) << line;
+    }
+}
+
+TEST(CommandLexerTest, PeekDoesNotConsume) {
+    std::string line = "exit now";
+    CommandLexer lexer(line);
+    std::string_view token;
+    ASSERT_TRUE(lexer.peek(token));
+    EXPECT_EQ(token, "exit");
+    ASSERT_TRUE(lexer.next(token));
+    EXPECT_EQ(token, "exit");
+    ASSERT_TRUE(lexer.next(token));
+    EXPECT_EQ(token, "now");
+    EXPECT_FALSE(lexer.peek(token));
+}
+
+TEST(CommandParserTest, AcceptsTheCxxoptsSyntax) {
+    std::string line = "--update 3 --desc \"New text\" -s DONE";
+    ParsedCommand command = parse(line);
+    EXPECT_EQ(command.count(CommandOption::Update), 1);
+    EXPECT_EQ(command.integer(CommandOption::Update), 3);
+    EXPECT_EQ(command.value(CommandOption::Desc), "New text");
+    EXPECT_EQ(command.value(CommandOption::Status), "DONE");
+    EXPECT_EQ(command.count(CommandOption::List), 0);
+
+    // --name=value, 短选项直接跟值, 组合的短选项, 重复的选项取最后一个值
+    line = "--limit=5 -g7 -lc --sort id --sort updated:desc -- --bogus";
+    command = parse(line);
+    EXPECT_EQ(command.integer(CommandOption::Limit), 5);
+    EXPECT_EQ(command.integer(CommandOption::Get), 7);
+    EXPECT_EQ(command.count(CommandOption::List), 1);
+    EXPECT_EQ(command.count(CommandOption::Clear), 1);
+    EXPECT_EQ(command.count(CommandOption::Sort), 2);
+    EXPECT_EQ(command.value(CommandOption::Sort), "updated:desc");
+
+    // 选项的值可以以 - 开头; 不是选项的词被忽略
+    line = "--add -x stray";
+    command = parse(line);
+    EXPECT_EQ(command.value(CommandOption::Add), "-x");
+
+    line = "words only";
+    EXPECT_TRUE(parse(line).empty());
+
+    const char* argv[] = { "task-tracker", "--r-last", "--remap-ids" };
+    command = parse_command(3, argv);
+    EXPECT_EQ(command.count(CommandOption::RemoveLast), 1);
+    EXPECT_EQ(command.count(CommandOption::RemapIds), 1);
+}
+
+TEST(CommandParserTest, EveryOptionIsFound) {
+    for (std::size_t i = 0; i < command_option_count; i++) {
+        CommandOption option = static_cast<CommandOption>(i);
+        std::string line = "--" + std::string(option_name(option)) + " 1";
+        ParsedCommand command = parse(line);
+        EXPECT_EQ(command.count(option), 1) << option_name(option);
+    }
+}
+
+TEST(CommandParserTest, RejectsMalformedCommands) {
+    for (std::string line : { "--bogus", "--add", "-x", "--get abc", "--get 1x", "--list=true", "-g" }) {
+        EXPECT_THROW(parse(line), CommandLineError) << line;
+    }
+}
@@ -0,0 +1,162 @@
+#include <gtest/gtest.h>
+#include "task-tracker/concurrent_task_manager.h"
+#include <atomic>
+#include <fstream>
+#include <thread>
+#include <vector>
+
+class ConcurrentManagerTest : public ::testing::Test {
+protected:
+    std::string test_file = "concurrent_manager_test_file.json";
+
+    void SetUp() override {
+        std::ofstream ofs(test_file);
+        ASSERT_TRUE(ofs.is_open());
+        ofs << "[]";
+    }
+
+    void TearDown() override {
+        std::remove(test_file.c_str());
+        std::remove((test_file + ".journal").c_str());
+        for (int i = 0; i < 3; i++) {
+            std::remove((test_file + ".shard" + std::to_string(i)).c_str());
+        }
+    }
+};
+
+TEST_F(ConcurrentManagerTest, CopiesOutliveTheTask) {
+    ConcurrentTaskManager manager(test_file);
+    TaskData added = manager.add_task("Short-lived task");
+    std::optional<TaskData> fetched = manager.get_task(added.id);
+    ASSERT_TRUE(fetched.has_value());
+    std::vector<TaskData> listed = manager.list_tasks();
+
+    EXPECT_TRUE(manager.remove_task(added.id));
+    // 副本不受删除影响
+    EXPECT_EQ(fetched->description, "Short-lived task");
+    ASSERT_EQ(listed.size(), 1);
+    EXPECT_EQ(listed[0].description, "Short-lived task");
+    EXPECT_FALSE(manager.get_task(added.id).has_value());
+    EXPECT_FALSE(manager.update_task_status(added.id, "DONE").has_value());
+}
+
+TEST_F(ConcurrentManagerTest, ReadersRunAlongsideWriters) {
+    ConcurrentTaskManager manager(test_file);
+    const int writers = 4, tasks_per_writer = 300;
+    std::atomic<bool> done{ false };
+    std::atomic<int> bad_reads{ 0 };
+
+    std::vector<std::thread> threads;
+    for (int w = 0; w < writers; w++) {
+        threads.emplace_back([&, w] {
+            for (int i = 0; i < tasks_per_writer; i++) {
+                TaskData task = manager.add_task("Writer " + std::to_string(w) + " task " + std::to_string(i));
+                manager.update_task_status(task.id, "IN_PROGRESS");
+                if (i % 3 == 0) {
+                    manager.remove_task(task.id);
+                }
+            }
+        });
+    }
+    for (int r = 0; r < 4; r++) {
+        threads.emplace_back([&] {
+            while (!done) {
+                std::vector<TaskData> tasks = manager.list_tasks();
+                for (const TaskData& task : tasks) {
+                    if (task.description.rfind("Writer ", 0) != 0) {
+                        bad_reads++;
+                    }
+                }
+                // 计数与列表在同一把共享锁下读取, 必然一致
+                bool consistent = manager.read([](const TaskManager& m) {
+                    return m.list_tasks(TaskStatus::IN_PROGRESS).size() == m.count_tasks(TaskStatus::IN_PROGRESS);
+                });
+                if (!consistent) {
+                    bad_reads++;
+                }
+            }
+        });
+    }
+    for (int w = 0; w < writers; w++) {
+        threads[w].join();
+    }
+    done = true;
+    for (std::size_t t = writers; t < threads.size(); t++) {
+        threads[t].join();
+    }
+
+    EXPECT_EQ(bad_reads, 0);
+    EXPECT_EQ(manager.list_tasks().size(), writers * (tasks_per_writer - tasks_per_writer / 3));
+    EXPECT_EQ(manager.count_tasks(TaskStatus::IN_PROGRESS), writers * (tasks_per_writer - tasks_per_writer / 3));
+}
+
+TEST_F(ConcurrentManagerTest, ReadersLookUpIdsPastTheLastShard) {
+    TaskManagerOptions options;
+    options.shard_size = 100;
+    {
+        TaskManager manager(test_file, options);
+        for (int i = 1; i <= 250; i++) {
+            manager.add_task("Task " + std::to_string(i));
+        }
+        manager.compact();
+    }
+
+    // 共享锁下的读者查找不存在的分片时不能创建分片
+    ConcurrentTaskManager manager(test_file, options);
+    std::atomic<int> bad_reads{ 0 };
+    std::vector<std::thread> threads;
+    for (int r = 0; r < 8; r++) {
+        threads.emplace_back([&, r] {
+            for (int i = 0; i < 500; i++) {
+                int id = 300 + (r * 500 + i) * 7;
+                if (manager.get_task(id).has_value() || manager.get_task(-id).has_value()) {
+                    bad_reads++;
+                }
+                if (i % 50 == 0 && manager.list_tasks().size() != 250) {
+                    bad_reads++;
+                }
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(bad_reads, 0);
+    EXPECT_EQ(manager.get_task(250)->description, "Task 250");
+}
+
+TEST_F(ConcurrentManagerTest, ShardsAreLoadedWhenOpened) {
+    TaskManagerOptions options;
+    options.shard_size = 100;
+    {
+        TaskManager manager(test_file, options);
+        for (int i = 1; i <= 250; i++) {
+            manager.add_task("Task " + std::to_string(i));
+        }
+        manager.compact();
+    }
+
+    // 即使要求按需读取, 打开时也读入所有分片, 之后删掉分片文件不影响读者
+    options.lazy_shards = true;
+    ConcurrentTaskManager manager(test_file, options);
+    for (int i = 0; i < 3; i++) {
+        std::remove((test_file + ".shard" + std::to_string(i)).c_str());
+    }
+    manager.read([](const TaskManager& m) {
+        ASSERT_NE(m.get_task(150), nullptr);
+        EXPECT_EQ(m.get_task(150)->get_description(), "Task 150");
+        EXPECT_EQ(m.list_tasks().size(), 250);
+    });
+}
+
+TEST_F(ConcurrentManagerTest, WriteRunsATransaction) {
+    ConcurrentTaskManager manager(test_file);
+    manager.add_task("Existing task");
+    manager.write([](TaskManager& m) {
+        Transaction transaction(m);
+        m.add_task("First of two");
+        m.add_task("Second of two");
+        transaction.commit();
+    });
+    EXPECT_EQ(manager.list_tasks().size(), 3);
+}
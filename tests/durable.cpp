@@ -0,0 +1,57 @@
+#include <gtest/gtest.h>
+#include "task-tracker/durable_file.h"
+#include <filesystem>
+#include <fstream>
+
+static std::string read_file(const std::string& path) {
+    std::ifstream ifs(path, std::ios::binary);
+    return std::string((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+}
+
+class DurableFileTest : public ::testing::Test {
+protected:
+    std::string test_file = "durable_test_file.txt";
+
+    void TearDown() override {
+        std::filesystem::remove_all(test_file + ".tmp");
+        std::remove(test_file.c_str());
+    }
+};
+
+TEST_F(DurableFileTest, ReplacesContentsAtEveryLevel) {
+    for (Durability level : { Durability::None, Durability::Flush, Durability::Fsync }) {
+        std::string content = "contents " + std::to_string(static_cast<int>(level));
+        write_file_atomically(test_file, content, level);
+        EXPECT_EQ(read_file(test_file), content);
+        EXPECT_FALSE(std::filesystem::exists(test_file + ".tmp"));
+    }
+}
+
+TEST_F(DurableFileTest, FailedWriteKeepsTheOldFile) {
+    write_file_atomically(test_file, "old contents", Durability::Flush);
+    // 临时文件的位置被目录占用, 写入失败
+    std::filesystem::create_directory(test_file + ".tmp");
+    EXPECT_THROW(write_file_atomically(test_file, "new contents", Durability::Fsync), std::runtime_error);
+    EXPECT_EQ(read_file(test_file), "old contents");
+}
+
+TEST_F(DurableFileTest, AppendFileBuffersUntilFlush) {
+    AppendFile file;
+    file.open(test_file, true);
+    file.write("first\n");
+    EXPECT_EQ(read_file(test_file), "");
+    file.flush();
+    EXPECT_EQ(read_file(test_file), "first\n");
+    file.write("second\n");
+    file.sync();
+    EXPECT_EQ(read_file(test_file), "first\nsecond\n");
+    file.write("third\n");
+    file.close();
+    EXPECT_EQ(read_file(test_file), "first\nsecond\nthird\n");
+
+    // 以追加方式重新打开
+    file.open(test_file, false);
+    file.write("fourth\n");
+    file.close();
+    EXPECT_EQ(read_file(test_file), "first\nsecond\nthird\nfourth\n");
+}
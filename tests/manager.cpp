@@ -1,23 +1,25 @@
 #include <gtest/gtest.h>
 #include "task-tracker/task_manager.h"
-#include <thread>  //  std::this_thread::sleep_for
-#include <chrono>  //  std::chrono::seconds
+#include <thread>  // 用于 std::this_thread::sleep_for
+#include <chrono>  // 用于 std::chrono::seconds
+#include <filesystem>
 
 class EmptyManagerTest : public ::testing::Test {
 protected:
     std::string test_file_name = "empty_manager_test_file.json";
 
     void SetUp() override {
-        // ȷļǸɾģֻһյ JSON 
+        // 确保文件是干净的，只包含一个空的 JSON 数组
         std::ofstream ofs(test_file_name);
         ASSERT_TRUE(ofs.is_open());
-        ofs << "[]"; // дһյ JSON 
+        ofs << "[]"; // 写入一个空的 JSON 数组
         ofs.close();
     }
 
     void TearDown() override {
-        // ɾʱļΪһ׼
+        // 删除这个临时文件，为下一个测试做准备
         std::remove(test_file_name.c_str());
+        std::remove((test_file_name + ".journal").c_str());
     }
 };
 
@@ -63,9 +65,9 @@ protected:
             "updated_at": 1672830059
         }
     ]
-})"; // ע
+})"; // 注意这里的括号
     void SetUp() override {
-        // ÿǰļ
+        // 在每个测试前创建测试文件
         std::ofstream ofs(test_file);
         ASSERT_TRUE(ofs.is_open()) << "Failed to create test file for SetUp.";
 
@@ -73,18 +75,19 @@ protected:
         ofs.close();
 	}
     void TearDown() override {
-        // ÿԺɾļ
+        // 在每个测试后删除测试文件
         std::remove(test_file.c_str());
+        std::remove((test_file + ".journal").c_str());
 	}
 };
 
 TEST_F(EmptyManagerTest, AddAndGetTask) {
     TaskManager manager(test_file_name);
 	Task* empty_task = manager.get_task(648);
-	EXPECT_EQ(empty_task, nullptr); // ȷڵ񷵻 nullptr
+	EXPECT_EQ(empty_task, nullptr); // 确保不存在的任务返回 nullptr
     manager.add_task("Manage tasks effectively");
     Task* task = manager.get_task(1);
-    ASSERT_NE(task, nullptr); // ȷȷ
+    ASSERT_NE(task, nullptr); // 确保任务被正确添加
     EXPECT_EQ(task->get_id(), 1);
     EXPECT_EQ(task->get_description(), "Manage tasks effectively");
 }
@@ -93,11 +96,11 @@ TEST_F(EmptyManagerTest, RemoveTask) {
     TaskManager manager(test_file_name);
     manager.add_task("Task to be removed from manager");
     Task* task = manager.get_task(1);
-    ASSERT_NE(task, nullptr); // ȷȷ
+    ASSERT_NE(task, nullptr); // 确保任务被正确添加
     bool flag = manager.remove_task(1);
-	EXPECT_EQ(flag, true); // ȷƳɹ
+	EXPECT_EQ(flag, true); // 确保移除操作成功
     Task* removed_task = manager.get_task(1);
-    EXPECT_EQ(removed_task, nullptr); // ȷȷƳ
+    EXPECT_EQ(removed_task, nullptr); // 确保任务被正确移除
 }
 
 TEST_F(EmptyManagerTest, UpdateTaskStatusAndDescription) {
@@ -106,7 +109,7 @@ TEST_F(EmptyManagerTest, UpdateTaskStatusAndDescription) {
     manager.update_task_status(1, "IN_PROGRESS");
     manager.update_task_description(1, "Updated description");
     Task* task = manager.get_task(1);
-    ASSERT_NE(task, nullptr); // ȷ
+    ASSERT_NE(task, nullptr); // 确保任务存在
     EXPECT_NE(task->get_status(), TaskStatus::TO_DO);
     EXPECT_EQ(task->get_status(), TaskStatus::IN_PROGRESS);
     EXPECT_NE(task->get_description(), "Initial description");
@@ -119,7 +122,7 @@ TEST_F(EmptyManagerTest, ListAllTasks) {
     manager.add_task("Task 10");
     manager.add_task("Task 11");
 	std::vector<const Task*> need_list = manager.list_tasks();
-	EXPECT_EQ(need_list.size(), 3); // ȷ
+	EXPECT_EQ(need_list.size(), 3); // 确保返回了所有任务
 }
 
 TEST_F(EmptyManagerTest, ListTasksByStatu) {
@@ -134,44 +137,46 @@ TEST_F(EmptyManagerTest, ListTasksByStatu) {
 	manager.update_task_status(5, "IN_PROGRESS");
 	manager.update_task_status(6, "DONE");
     std::vector<const Task*> TO_DO_list = manager.list_tasks(TaskStatus::TO_DO);
-	EXPECT_EQ(TO_DO_list.size(), 3); // ȷ TO_DO ״̬
+	EXPECT_EQ(TO_DO_list.size(), 3); // 确保返回了所有 TO_DO 状态的任务
     std::vector<const Task*> IN_PROGRESS_list = manager.list_tasks(TaskStatus::IN_PROGRESS);
-	EXPECT_EQ(IN_PROGRESS_list.size(), 2); // ȷ IN_PROGRESS ״̬
+	EXPECT_EQ(IN_PROGRESS_list.size(), 2); // 确保返回了所有 IN_PROGRESS 状态的任务
     std::vector<const Task*> DONE_list = manager.list_tasks(TaskStatus::DONE);
-	EXPECT_EQ(DONE_list.size(), 1); // ȷ DONE ״̬
+	EXPECT_EQ(DONE_list.size(), 1); // 确保返回了所有 DONE 状态的任务
 }
 
 TEST_F(FilereaderTest, FileCreationIfNotExist) {
     std::string non_existent_file = "non_existent_test_file.json";
-    // ȷļ
+    // 确保文件不存在
     std::remove(non_existent_file.c_str());
-    //  TaskManager ʵӦûᴴļ
+    // 创建 TaskManager 实例，应该会创建文件
     TaskManager manager(non_existent_file);
     EXPECT_EQ(manager.IsEmpty(), true);
-    // ļǷ񱻴    
+    // 检查文件是否被创建    
     std::ifstream ifs(non_existent_file);
     EXPECT_TRUE(ifs.is_open()) << "File was not created.";
     ifs.close();
-    // ɾļ
+    // 删除测试文件
     std::remove(non_existent_file.c_str());
+    std::remove((non_existent_file + ".journal").c_str());
 }
 
 TEST_F(FilereaderTest, readEMptyFile) {
     std::string empty_filename = "empty_test_file.json";
-    // һļ
+    // 创建一个空文件
     std::ofstream ofs(empty_filename);
     ASSERT_TRUE(ofs.is_open());
-    ofs.close(); // رգʹΪ
+    ofs.close(); // 立即关闭，使其为空
     TaskManager manager(empty_filename);
-    // ȷû񱻼
+    // 确保没有任务被加载
     EXPECT_EQ(manager.IsEmpty(), true);
-    // ɾļ
+    // 删除测试文件
     std::remove(empty_filename.c_str());
+    std::remove((empty_filename + ".journal").c_str());
 }
 
 TEST_F(FilereaderTest, LoadFromFile) {
     TaskManager manager("test_tasks.json");
-    // Ƿȷ
+    // 检查任务是否正确加载
     Task* task1 = manager.get_task(1);
     ASSERT_NE(task1, nullptr);
     EXPECT_EQ(task1->get_description(), "Test task 1");
@@ -198,19 +203,19 @@ TEST_F(FilereaderTest, SaveToFile) {
     TaskManager manager("test_tasks.json");
     std::vector<const Task*> list = manager.list_tasks();
     EXPECT_EQ(list.size(), 5); 
-    // һ
+    // 添加一个新任务
     manager.add_task("Newly added task");
     std::vector<const Task*> new_list = manager.list_tasks();
 	EXPECT_EQ(new_list.size(), 6);
-    // 浽ļ
+    // 保存到文件
     manager.update_task_status(6, "IN_PROGRESS");
     manager.update_task_description(6, "Updated description for new task");
-    // ¼ļ֤
+    // 重新加载文件以验证保存
     TaskManager reloaded_manager("test_tasks.json");
     std::vector<const Task*> final_list = reloaded_manager.list_tasks();
 	EXPECT_EQ(final_list.size(), 6);
     Task* task = reloaded_manager.get_task(6);
-    ASSERT_NE(task, nullptr); // ȷ
+    ASSERT_NE(task, nullptr); // 确保任务存在
     EXPECT_EQ(task->get_description(), "Updated description for new task");
     EXPECT_EQ(task->get_status(), TaskStatus::IN_PROGRESS);
 }
@@ -219,23 +224,538 @@ TEST_F(FilereaderTest, RemoveLastTask) {
     TaskManager manager("test_tasks.json");
     std::vector<const Task*> list = manager.list_tasks();
     EXPECT_EQ(list.size(), 5); 
-    // Ƴһ
+    // 移除最后一个任务
     bool flag = manager.remove_last_task();
     EXPECT_EQ(flag, true);
     std::vector<const Task*> new_list = manager.list_tasks();
     EXPECT_EQ(new_list.size(), 4); 
-    // ֤һѱƳ
+    // 验证最后一个任务已被移除
     Task* task = manager.get_task(5);
-    EXPECT_EQ(task, nullptr); // ȷȷƳ
+    EXPECT_EQ(task, nullptr); // 确保任务被正确移除
 }   
 
 TEST_F(FilereaderTest, ClearAllTasks) {
     TaskManager manager("test_tasks.json");
     std::vector<const Task*> list = manager.list_tasks();
     EXPECT_EQ(list.size(), 5); 
-    // 
+    // 清除所有任务
     bool flag = manager.clear_all_tasks();
     EXPECT_EQ(flag, true);
     std::vector<const Task*> new_list = manager.list_tasks();
     EXPECT_EQ(new_list.size(), 0); 
-}
\ No newline at end of file
+}
+
+static std::string read_whole_file(const std::string& path) {
+    std::ifstream ifs(path, std::ios::binary);
+    return std::string((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+}
+
+TEST_F(FilereaderTest, MutationsGoToJournal) {
+    std::string snapshot_before = read_whole_file(test_file);
+    {
+        TaskManager manager(test_file);
+        manager.add_task("Journaled task");
+        manager.update_task_status(2, "DONE");
+        manager.update_task_description(3, "Journaled description");
+        manager.remove_task(4);
+    }
+    // 快照没有被重写, 修改只追加到 journal
+    EXPECT_EQ(read_whole_file(test_file), snapshot_before);
+    EXPECT_NE(read_whole_file(test_file + ".journal").find("Journaled task"), std::string::npos);
+
+    TaskManager reloaded(test_file);
+    EXPECT_EQ(reloaded.list_tasks().size(), 5);
+    ASSERT_NE(reloaded.get_task(6), nullptr);
+    EXPECT_EQ(reloaded.get_task(6)->get_description(), "Journaled task");
+    EXPECT_EQ(reloaded.get_task(2)->get_status(), TaskStatus::DONE);
+    EXPECT_EQ(reloaded.get_task(3)->get_description(), "Journaled description");
+    EXPECT_EQ(reloaded.get_task(4), nullptr);
+    // next_id 也通过 journal 恢复
+    EXPECT_EQ(reloaded.add_task("After reload")->get_id(), 7);
+}
+
+TEST_F(FilereaderTest, CompactFoldsJournalIntoSnapshot) {
+    {
+        TaskManager manager(test_file);
+        manager.add_task("Compacted task");
+        manager.remove_last_task();
+        manager.clear_all_tasks();
+        manager.add_task("Survivor");
+        manager.compact();
+    }
+    std::string journal = read_whole_file(test_file + ".journal");
+    EXPECT_EQ(std::count(journal.begin(), journal.end(), '\n'), 1); // 只剩头部
+    TaskManager reloaded(test_file);
+    ASSERT_EQ(reloaded.list_tasks().size(), 1);
+    EXPECT_EQ(reloaded.list_tasks()[0]->get_id(), 7);
+    EXPECT_EQ(reloaded.list_tasks()[0]->get_description(), "Survivor");
+}
+
+TEST_F(FilereaderTest, StaleJournalIsDiscarded) {
+    {
+        TaskManager manager(test_file);
+        manager.add_task("Belongs to the old snapshot");
+    }
+    // 外部替换快照后, 旧的 journal 不再适用
+    std::ofstream ofs(test_file);
+    ofs << R"({"next_id": 2, "tasks": [{"id": 1, "description": "Replaced", "status": "DONE"}]})";
+    ofs.close();
+
+    TaskManager manager(test_file);
+    ASSERT_EQ(manager.list_tasks().size(), 1);
+    EXPECT_EQ(manager.get_task(1)->get_description(), "Replaced");
+}
+
+TEST_F(FilereaderTest, TornJournalTailIsIgnored) {
+    {
+        TaskManager manager(test_file);
+        manager.add_task("Complete record");
+    }
+    // 模拟写到一半崩溃
+    std::ofstream ofs(test_file + ".journal", std::ios::app | std::ios::binary);
+    ofs << R"({"op":"add","id":7,"descr)";
+    ofs.close();
+
+    {
+        TaskManager manager(test_file);
+        EXPECT_NE(manager.get_task(6), nullptr);
+        EXPECT_EQ(manager.get_task(7), nullptr);
+        manager.add_task("Appended after truncation");
+    }
+    TaskManager reloaded(test_file);
+    ASSERT_NE(reloaded.get_task(7), nullptr);
+    EXPECT_EQ(reloaded.get_task(7)->get_description(), "Appended after truncation");
+}
+
+TEST_F(FilereaderTest, DamagedJournalRecordIsNotTruncated) {
+    {
+        TaskManager manager(test_file);
+        manager.add_task("Before the damage");
+        manager.add_task("Replaced by garbage");
+        manager.add_task("After the damage");
+    }
+    // 中间一条完整的记录损坏, 后面的记录是已经提交的修改, 不能当作写到一半的尾部丢掉
+    std::string journal = read_whole_file(test_file + ".journal");
+    std::size_t start = journal.find("{\"", journal.find("Before the damage"));
+    std::size_t end = journal.find('\n', start);
+    journal.replace(start, end - start, "{\"op\":\"add\",\"id\":");
+    {
+        std::ofstream ofs(test_file + ".journal", std::ios::binary | std::ios::trunc);
+        ofs << journal;
+    }
+
+    EXPECT_THROW(TaskManager manager(test_file), std::runtime_error);
+    EXPECT_EQ(read_whole_file(test_file + ".journal"), journal);
+}
+
+TEST_F(FilereaderTest, OutOfRangeJournalIdsSkipOnlyThatRecord) {
+    {
+        TaskManager manager(test_file);
+        manager.add_task("Before");
+        manager.add_task("Out of range");
+        manager.add_task("After");
+        manager.remove_task(1);
+    }
+    // id 超出范围的记录会让 next_id 溢出, 只跳过这一条, 其余记录照常回放
+    std::string journal = read_whole_file(test_file + ".journal");
+    std::size_t id = journal.find("\"id\":7", journal.find("Out of range"));
+    ASSERT_NE(id, std::string::npos);
+    journal.replace(id, 6, "\"id\":2147483647");
+    std::size_t removed = journal.find("{\"id\":1,");
+    ASSERT_NE(removed, std::string::npos);
+    journal.replace(removed, 8, "{\"id\":-1,");
+    {
+        std::ofstream ofs(test_file + ".journal", std::ios::binary | std::ios::trunc);
+        ofs << journal;
+    }
+
+    TaskManager manager(test_file);
+    EXPECT_EQ(manager.get_task(7), nullptr);
+    EXPECT_NE(manager.get_task(1), nullptr);
+    ASSERT_NE(manager.get_task(8), nullptr);
+    EXPECT_EQ(manager.get_task(8)->get_description(), "After");
+    EXPECT_EQ(manager.add_task("Next")->get_id(), 9);
+}
+
+TEST_F(FilereaderTest, ReplaysVersionOneJournal) {
+    {
+        TaskManager manager(test_file);
+        manager.add_task("Recorded by an older version");
+    }
+    // 旧版本的 journal 头用整个快照文件的哈希作为指纹
+    std::string journal = read_whole_file(test_file + ".journal");
+    std::string legacy = "{\"journal\":1,\"snapshot\":" + std::to_string(Journal::fingerprint(read_whole_file(test_file))) + "}";
+    journal.replace(0, journal.find('\n'), legacy);
+    {
+        std::ofstream ofs(test_file + ".journal", std::ios::binary | std::ios::trunc);
+        ofs << journal;
+    }
+
+    {
+        TaskManager manager(test_file);
+        ASSERT_NE(manager.get_task(6), nullptr);
+        EXPECT_EQ(manager.get_task(6)->get_description(), "Recorded by an older version");
+    }
+    // 回放后换成新的头, 记录保持不变
+    std::string rewritten = read_whole_file(test_file + ".journal");
+    EXPECT_NE(rewritten.find("\"journal\":2"), std::string::npos);
+    EXPECT_EQ(rewritten.substr(rewritten.find('\n')), journal.substr(journal.find('\n')));
+    TaskManager reopened(test_file);
+    EXPECT_EQ(reopened.get_task(6)->get_description(), "Recorded by an older version");
+}
+
+TEST_F(EmptyManagerTest, LookupStaysConsistentAfterRemovals) {
+    TaskManager manager(test_file_name);
+    for (int i = 1; i <= 20; i++) {
+        manager.add_task("Task " + std::to_string(i));
+    }
+    // 删除大部分偶数任务, 触发墓碑回收
+    for (int i = 2; i <= 16; i += 2) {
+        EXPECT_TRUE(manager.remove_task(i));
+    }
+    EXPECT_FALSE(manager.remove_task(2));
+    for (int i = 1; i <= 20; i++) {
+        Task* task = manager.get_task(i);
+        if (i % 2 == 0 && i <= 16) {
+            EXPECT_EQ(task, nullptr);
+        }
+        else {
+            ASSERT_NE(task, nullptr);
+            EXPECT_EQ(task->get_id(), i);
+            EXPECT_EQ(task->get_description(), "Task " + std::to_string(i));
+        }
+    }
+    EXPECT_EQ(manager.list_tasks().size(), 12);
+
+    // r-last 仍然删除最后添加的任务
+    EXPECT_TRUE(manager.remove_last_task());
+    EXPECT_EQ(manager.get_task(20), nullptr);
+    EXPECT_EQ(manager.get_last_id(), 19);
+    EXPECT_NE(manager.update_task_status(19, "DONE"), nullptr);
+
+    TaskManager reloaded(test_file_name);
+    EXPECT_EQ(reloaded.list_tasks().size(), 11);
+    ASSERT_NE(reloaded.get_task(19), nullptr);
+    EXPECT_EQ(reloaded.get_task(19)->get_status(), TaskStatus::DONE);
+    EXPECT_EQ(reloaded.get_task(20), nullptr);
+}
+
+TEST_F(FilereaderTest, StatusIndexFollowsMutations) {
+    TaskManager manager(test_file);
+    EXPECT_EQ(manager.count_tasks(TaskStatus::TO_DO), 3);
+    EXPECT_EQ(manager.count_tasks(TaskStatus::IN_PROGRESS), 1);
+    EXPECT_EQ(manager.count_tasks(TaskStatus::DONE), 1);
+
+    manager.update_task_status(1, "DONE");
+    manager.update_task_status(2, "INVALID"); // 无效状态不改变索引
+    manager.remove_task(3);
+    manager.add_task("Fresh task");
+
+    EXPECT_EQ(manager.count_tasks(TaskStatus::TO_DO), 3);
+    EXPECT_EQ(manager.count_tasks(TaskStatus::IN_PROGRESS), 1);
+    EXPECT_EQ(manager.count_tasks(TaskStatus::DONE), 1);
+    std::vector<const Task*> done = manager.list_tasks(TaskStatus::DONE);
+    ASSERT_EQ(done.size(), 1);
+    EXPECT_EQ(done[0]->get_id(), 1);
+
+    // 重新加载后 (快照 + journal 回放) 索引一致
+    TaskManager reloaded(test_file);
+    std::vector<const Task*> to_do = reloaded.list_tasks(TaskStatus::TO_DO);
+    ASSERT_EQ(to_do.size(), 3);
+    EXPECT_EQ(to_do[0]->get_id(), 4);
+    EXPECT_EQ(to_do[1]->get_id(), 5);
+    EXPECT_EQ(to_do[2]->get_id(), 6);
+
+    reloaded.clear_all_tasks();
+    EXPECT_EQ(reloaded.count_tasks(TaskStatus::TO_DO), 0);
+    EXPECT_TRUE(reloaded.list_tasks(TaskStatus::DONE).empty());
+}
+
+TEST_F(FilereaderTest, TimeRangeIndexFollowsMutations) {
+    TaskManager manager(test_file);
+    auto ids = [](const std::vector<const Task*>& tasks) {
+        std::vector<int> result;
+        for (const Task* task : tasks) {
+            result.push_back(task->get_id());
+        }
+        return result;
+    };
+    // 区间两端都包含在内, 结果按时间排序
+    EXPECT_EQ(ids(manager.list_tasks_between(TimeField::Created, 1672657200, 1672830000)), (std::vector<int>{ 2, 3, 4 }));
+    EXPECT_EQ(ids(manager.list_tasks_between(TimeField::Updated, 1672830000, 1672830059)), (std::vector<int>{ 4, 5 }));
+    EXPECT_TRUE(manager.list_tasks_between(TimeField::Created, 1672830000, 1672567200).empty());
+    EXPECT_TRUE(manager.has_time_index());
+
+    // 修改会更新 updated_at, 索引要跟着变
+    std::time_t before = std::time(nullptr);
+    manager.update_task_status(1, "DONE");
+    manager.update_task_description(2, "Edited");
+    manager.remove_task(4);
+    manager.add_task("Fresh task");
+    std::time_t after = std::time(nullptr);
+    EXPECT_EQ(ids(manager.list_tasks_between(TimeField::Updated, before, after)), (std::vector<int>{ 1, 2, 6 }));
+    EXPECT_EQ(ids(manager.list_tasks_between(TimeField::Created, before, after)), (std::vector<int>{ 6 }));
+    EXPECT_EQ(ids(manager.list_tasks_between(TimeField::Updated, 0, 1672830099)), (std::vector<int>{ 3, 5 }));
+
+    manager.begin_batch();
+    manager.remove_task(6);
+    manager.rollback();
+    EXPECT_EQ(ids(manager.list_tasks_between(TimeField::Created, before, after)), (std::vector<int>{ 6 }));
+    manager.clear_all_tasks();
+    EXPECT_TRUE(manager.list_tasks_between(TimeField::Updated, 0, after).empty());
+}
+
+TEST_F(FilereaderTest, PagedListingFollowsCursor) {
+    TaskManager manager(test_file);
+    auto ids = [](const std::vector<const Task*>& tasks) {
+        std::vector<int> result;
+        for (const Task* task : tasks) {
+            result.push_back(task->get_id());
+        }
+        return result;
+    };
+    // 按 id 翻页: 游标是上一页最后一个任务
+    std::vector<const Task*> page = manager.list_tasks(ListOrder{}, 2);
+    EXPECT_EQ(ids(page), (std::vector<int>{ 1, 2 }));
+    page = manager.list_tasks(ListOrder{}, 2, TaskCursor::after(*page.back(), SortKey::Id));
+    EXPECT_EQ(ids(page), (std::vector<int>{ 3, 4 }));
+    // 翻页之间删除游标所在的任务也能继续
+    TaskCursor cursor = TaskCursor::after(*page.back(), SortKey::Id);
+    manager.remove_task(4);
+    EXPECT_EQ(ids(manager.list_tasks(ListOrder{}, 2, cursor)), (std::vector<int>{ 5 }));
+    EXPECT_EQ(ids(manager.list_tasks(ListOrder{ SortKey::Id, true }, 10, TaskCursor{ 0, 3 })), (std::vector<int>{ 2, 1 }));
+    EXPECT_EQ(ids(manager.list_tasks(ListOrder{}, 10, std::nullopt, TaskStatus::TO_DO)), (std::vector<int>{ 1, 5 }));
+    EXPECT_TRUE(manager.list_tasks(ListOrder{}, 0).empty());
+
+    // 最近更新的前 k 个
+    manager.update_task_status(1, "IN_PROGRESS");
+    ListOrder newest{ SortKey::Updated, true };
+    page = manager.list_tasks(newest, 2);
+    EXPECT_EQ(ids(page), (std::vector<int>{ 1, 5 }));
+    EXPECT_EQ(ids(manager.list_tasks(newest, 10, TaskCursor::after(*page.back(), SortKey::Updated))), (std::vector<int>{ 3, 2 }));
+    EXPECT_EQ(ids(manager.list_tasks(ListOrder{ SortKey::Created }, 10, std::nullopt, TaskStatus::TO_DO)), (std::vector<int>{ 5 }));
+    page = manager.list_tasks(ListOrder{ SortKey::Created }, 2);
+    EXPECT_EQ(ids(page), (std::vector<int>{ 1, 2 }));
+    EXPECT_EQ(ids(manager.list_tasks(ListOrder{ SortKey::Created }, 2, TaskCursor::after(*page.back(), SortKey::Created))), (std::vector<int>{ 3, 5 }));
+}
+
+TEST_F(FilereaderTest, BatchIsPersistedOnlyOnCommit) {
+    std::string journal_file = test_file + ".journal";
+    TaskManager manager(test_file);
+    std::string journal_before = read_whole_file(journal_file);
+
+    manager.begin_batch();
+    manager.add_task("Batched task");
+    manager.update_task_status(1, "DONE");
+    manager.remove_task(2);
+    EXPECT_TRUE(manager.in_batch());
+    EXPECT_EQ(manager.get_task(6)->get_description(), "Batched task");
+    // 提交前磁盘上没有任何变化
+    EXPECT_EQ(read_whole_file(journal_file), journal_before);
+    {
+        TaskManager other(test_file);
+        EXPECT_EQ(other.get_task(6), nullptr);
+        EXPECT_NE(other.get_task(2), nullptr);
+    }
+
+    manager.commit();
+    EXPECT_FALSE(manager.in_batch());
+    TaskManager reloaded(test_file);
+    ASSERT_NE(reloaded.get_task(6), nullptr);
+    EXPECT_EQ(reloaded.get_task(1)->get_status(), TaskStatus::DONE);
+    EXPECT_EQ(reloaded.get_task(2), nullptr);
+    EXPECT_THROW(manager.commit(), std::runtime_error);
+}
+
+TEST_F(FilereaderTest, RollbackRestoresCommittedState) {
+    TaskManager manager(test_file);
+    manager.add_task("Committed task");
+
+    manager.begin_batch();
+    manager.add_task("Dropped task");
+    manager.update_task_description(1, "Dropped description");
+    manager.clear_all_tasks();
+    manager.rollback();
+
+    EXPECT_FALSE(manager.in_batch());
+    EXPECT_EQ(manager.list_tasks().size(), 6);
+    EXPECT_EQ(manager.get_task(1)->get_description(), "Test task 1");
+    EXPECT_EQ(manager.get_task(6)->get_description(), "Committed task");
+    EXPECT_EQ(manager.get_task(7), nullptr);
+    EXPECT_EQ(manager.count_tasks(TaskStatus::TO_DO), 4);
+    // id 不会被回滚的任务占用
+    EXPECT_EQ(manager.add_task("Next task")->get_id(), 7);
+}
+
+TEST_F(FilereaderTest, RollbackToKeepsOuterBatches) {
+    TaskManager manager(test_file);
+    manager.begin_batch();
+    manager.add_task("Outer task");
+    manager.update_task_status(1, "DONE");
+
+    manager.begin_batch();
+    int inner = manager.batch_level();
+    EXPECT_EQ(inner, 2);
+    manager.add_task("Inner task");
+    manager.update_task_description(6, "Inner description");
+    manager.remove_task(2);
+    manager.rollback_to(inner);
+
+    // 只放弃内层的修改, 外层批处理仍然打开
+    EXPECT_EQ(manager.batch_level(), 1);
+    EXPECT_EQ(manager.get_task(6)->get_description(), "Outer task");
+    EXPECT_EQ(manager.get_task(1)->get_status(), TaskStatus::DONE);
+    EXPECT_NE(manager.get_task(2), nullptr);
+    EXPECT_EQ(manager.get_task(7), nullptr);
+    {
+        TaskManager other(test_file);
+        EXPECT_EQ(other.get_task(6), nullptr);
+    }
+
+    manager.commit();
+    TaskManager reloaded(test_file);
+    EXPECT_EQ(reloaded.get_task(6)->get_description(), "Outer task");
+    EXPECT_EQ(reloaded.get_task(1)->get_status(), TaskStatus::DONE);
+    EXPECT_EQ(reloaded.get_task(7), nullptr);
+    EXPECT_EQ(reloaded.list_tasks().size(), 6);
+}
+
+TEST_F(FilereaderTest, TransactionInsideBatchKeepsTheBatch) {
+    TaskManager manager(test_file);
+    manager.begin_batch();
+    manager.add_task("Kept task");
+    try {
+        Transaction transaction(manager);
+        manager.remove_task(1);
+        throw std::runtime_error("import failed");
+    }
+    catch (const std::runtime_error&) {
+    }
+    EXPECT_TRUE(manager.in_batch());
+    EXPECT_NE(manager.get_task(1), nullptr);
+    EXPECT_EQ(manager.get_task(6)->get_description(), "Kept task");
+    manager.commit();
+    EXPECT_EQ(TaskManager(test_file).list_tasks().size(), 6);
+}
+
+TEST_F(FilereaderTest, TransactionRollsBackOnException) {
+    TaskManager manager(test_file);
+    try {
+        Transaction transaction(manager);
+        manager.add_task("Never committed");
+        manager.remove_task(1);
+        throw std::runtime_error("import failed");
+    }
+    catch (const std::runtime_error&) {
+    }
+    EXPECT_FALSE(manager.in_batch());
+    EXPECT_EQ(manager.list_tasks().size(), 5);
+    EXPECT_NE(manager.get_task(1), nullptr);
+    EXPECT_EQ(manager.get_task(6), nullptr);
+}
+
+TEST_F(EmptyManagerTest, BulkAddAndStatusUpdate) {
+    TaskManager manager(test_file_name);
+    std::vector<std::string> descriptions;
+    for (int i = 1; i <= 3000; i++) {
+        descriptions.push_back("Imported task " + std::to_string(i));
+    }
+    std::vector<Task*> added = manager.add_tasks(descriptions);
+    ASSERT_EQ(added.size(), 3000);
+    EXPECT_EQ(added.front()->get_id(), 1);
+    EXPECT_EQ(added.back()->get_description(), "Imported task 3000");
+    EXPECT_FALSE(manager.in_batch());
+    // 大批量提交直接重写快照, journal 中只剩头部
+    EXPECT_LT(read_whole_file(test_file_name + ".journal").size(), 100);
+
+    std::vector<int> ids = { 1, 2, 3, 9999 };
+    EXPECT_EQ(manager.update_status_bulk(ids, TaskStatus::DONE), 3);
+    EXPECT_EQ(manager.count_tasks(TaskStatus::DONE), 3);
+    EXPECT_EQ(manager.count_tasks(TaskStatus::TO_DO), 2997);
+
+    TaskManager reloaded(test_file_name);
+    EXPECT_EQ(reloaded.list_tasks().size(), 3000);
+    EXPECT_EQ(reloaded.list_tasks(TaskStatus::DONE).size(), 3);
+}
+
+TEST_F(FilereaderTest, AsyncPersistenceWritesOnFlush) {
+    std::string journal_file = test_file + ".journal";
+    TaskManagerOptions options;
+    options.async_persistence = true;
+    options.flush_interval = std::chrono::seconds(30);
+    {
+        TaskManager manager(test_file, options);
+        std::string journal_before = read_whole_file(journal_file);
+        manager.add_task("Async task");
+        manager.update_task_status(1, "DONE");
+        // 写入被合并, 间隔未到时还没有落盘
+        EXPECT_EQ(read_whole_file(journal_file), journal_before);
+
+        manager.flush();
+        EXPECT_NE(read_whole_file(journal_file), journal_before);
+        TaskManager reader(test_file);
+        ASSERT_NE(reader.get_task(6), nullptr);
+        EXPECT_EQ(reader.get_task(1)->get_status(), TaskStatus::DONE);
+
+        manager.compact();
+        manager.remove_task(2);
+    }
+    // 析构时等待后台线程写完
+    TaskManager reloaded(test_file);
+    EXPECT_EQ(reloaded.list_tasks().size(), 5);
+    EXPECT_EQ(reloaded.get_task(2), nullptr);
+    EXPECT_EQ(reloaded.get_task(6)->get_description(), "Async task");
+}
+
+TEST_F(FilereaderTest, AsyncRollbackSeesEarlierWrites) {
+    TaskManagerOptions options;
+    options.async_persistence = true;
+    options.flush_interval = std::chrono::seconds(30);
+    TaskManager manager(test_file, options);
+    manager.add_task("Written before the batch");
+    manager.begin_batch();
+    manager.remove_task(1);
+    manager.rollback();
+    EXPECT_NE(manager.get_task(1), nullptr);
+    ASSERT_NE(manager.get_task(6), nullptr);
+    EXPECT_EQ(manager.get_task(6)->get_description(), "Written before the batch");
+}
+
+TEST_F(FilereaderTest, DamagedSnapshotIsKeptAside) {
+    std::string damaged_file = test_file + ".damaged";
+    // 模拟写到一半被中断的快照
+    std::string truncated = test_json_content.substr(0, test_json_content.find("Test task 3"));
+    {
+        std::ofstream ofs(test_file, std::ios::binary);
+        ofs << truncated;
+    }
+    {
+        TaskManager manager(test_file);
+        EXPECT_EQ(manager.list_tasks().size(), 2);
+        manager.compact();
+    }
+    EXPECT_EQ(read_whole_file(damaged_file), truncated);
+    std::remove(damaged_file.c_str());
+}
+
+TEST_F(FilereaderTest, EveryDurabilityLevelPersists) {
+    for (Durability level : { Durability::None, Durability::Flush, Durability::Fsync }) {
+        TaskManagerOptions options;
+        options.durability = level;
+        int id;
+        {
+            TaskManager manager(test_file, options);
+            id = manager.add_task("Durable task")->get_id();
+            manager.flush();
+            // flush() 之后其他进程就能读到
+            TaskManager reader(test_file);
+            ASSERT_NE(reader.get_task(id), nullptr);
+            manager.compact();
+            manager.update_task_status(id, "DONE");
+        }
+        TaskManager reloaded(test_file);
+        ASSERT_NE(reloaded.get_task(id), nullptr);
+        EXPECT_EQ(reloaded.get_task(id)->get_status(), TaskStatus::DONE);
+        EXPECT_FALSE(std::filesystem::exists(test_file + ".tmp"));
+    }
+}
@@ -0,0 +1,222 @@
+#include <gtest/gtest.h>
+#include "task-tracker/shard_set.h"
+#include "task-tracker/task_manager.h"
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+TEST(ShardSetTest, ShardsById) {
+    ShardSet shards("tasks.json", 100);
+    EXPECT_EQ(shards.shard_of(0), 0);
+    EXPECT_EQ(shards.shard_of(99), 0);
+    EXPECT_EQ(shards.shard_of(100), 1);
+    EXPECT_EQ(shards.shard_of(-1), -1);
+    EXPECT_EQ(shards.shard_of(-100), -1);
+    EXPECT_EQ(shards.shard_of(-101), -2);
+    EXPECT_EQ(shards.path(3), "tasks.json.shard3");
+}
+
+TEST(ShardSetTest, FindDoesNotCreateShards) {
+    ShardSet shards("tasks.json", 100);
+    const ShardSet& view = shards;
+    EXPECT_EQ(view.find(3), nullptr);
+    EXPECT_TRUE(shards.all().empty());
+    shards.at(3).loaded = true;
+    ASSERT_NE(view.find(3), nullptr);
+    EXPECT_TRUE(view.find(3)->loaded);
+    EXPECT_EQ(shards.all().size(), 1);
+}
+
+TEST(ShardSetTest, ManifestRoundTrip) {
+    ShardSet shards("tasks.json", 64);
+    shards.at(0).listed = true;
+    shards.at(0).counts = { 3, 2, 1 };
+    shards.at(5).listed = true;
+    shards.at(5).counts = { 0, 0, 7 };
+    shards.at(7).loaded = true; // 未写出的分片不在清单中
+    std::string manifest = shards.encode(330);
+
+    ShardSet decoded("tasks.json", 0);
+    int next_id = 0;
+    decoded.decode(manifest, next_id);
+    EXPECT_EQ(next_id, 330);
+    EXPECT_EQ(decoded.get_shard_size(), 64);
+    EXPECT_EQ(decoded.all().size(), 2);
+    EXPECT_EQ(decoded.unloaded_count(), 13);
+    EXPECT_EQ(decoded.unloaded_count(2), 8);
+    // 每次写出的清单都不同
+    EXPECT_NE(shards.encode(330), manifest);
+    EXPECT_THROW(decoded.decode("{\"shard_manifest\":1}", next_id), std::runtime_error);
+}
+
+class ShardedManagerTest : public ::testing::Test {
+protected:
+    std::string test_file = "shard_test_store.json";
+    TaskManagerOptions options;
+
+    void SetUp() override {
+        options.shard_size = 100;
+        std::ofstream ofs(test_file);
+        ASSERT_TRUE(ofs.is_open());
+        ofs << "[]";
+    }
+
+    void TearDown() override {
+        std::remove(test_file.c_str());
+        std::remove((test_file + ".journal").c_str());
+        for (int i = 0; i < 10; i++) {
+            std::remove(shard(i).c_str());
+        }
+    }
+
+    std::string shard(int index) const {
+        return test_file + ".shard" + std::to_string(index);
+    }
+
+    void fill(int count) {
+        TaskManager manager(test_file, options);
+        for (int i = 1; i <= count; i++) {
+            manager.add_task("Task " + std::to_string(i));
+        }
+        manager.update_task_status(150, "DONE");
+        manager.compact();
+    }
+};
+
+TEST_F(ShardedManagerTest, CompactionWritesOneFilePerShard) {
+    fill(250);
+    std::string manifest;
+    ASSERT_TRUE(ShardSet::read_manifest(test_file, manifest));
+    EXPECT_TRUE(std::filesystem::exists(shard(0)));
+    EXPECT_TRUE(std::filesystem::exists(shard(1)));
+    EXPECT_TRUE(std::filesystem::exists(shard(2)));
+    EXPECT_FALSE(std::filesystem::exists(shard(3)));
+
+    // 已有的清单决定分片大小
+    TaskManager reopened(test_file);
+    EXPECT_EQ(reopened.list_tasks().size(), 250);
+    EXPECT_EQ(reopened.get_task(150)->get_status(), TaskStatus::DONE);
+    EXPECT_EQ(reopened.list_tasks().front()->get_id(), 1);
+    EXPECT_EQ(reopened.add_task("Next")->get_id(), 251);
+}
+
+TEST_F(ShardedManagerTest, ShardsAreLoadedOnFirstAccess) {
+    fill(250);
+    TaskManager manager(test_file, options);
+    // 没有读取分片也能计数
+    EXPECT_FALSE(manager.IsEmpty());
+    EXPECT_EQ(manager.count_tasks(TaskStatus::DONE), 1);
+    EXPECT_EQ(manager.count_tasks(TaskStatus::TO_DO), 249);
+
+    // 分片 0 还没有被读取, 删除它的文件不影响其他分片
+    std::filesystem::rename(shard(0), shard(9));
+    EXPECT_EQ(manager.get_task(150)->get_description(), "Task 150");
+    EXPECT_EQ(manager.get_task(5), nullptr);
+    std::filesystem::rename(shard(9), shard(0));
+}
+
+TEST_F(ShardedManagerTest, OnlyChangedShardsAreRewritten) {
+    fill(250);
+    auto old_time = std::filesystem::file_time_type::clock::now() - std::chrono::hours(1);
+    for (int i = 0; i < 3; i++) {
+        std::filesystem::last_write_time(shard(i), old_time);
+    }
+    {
+        TaskManager manager(test_file, options);
+        manager.update_task_description(120, "Changed");
+        manager.remove_task(130);
+        manager.compact();
+    }
+    EXPECT_EQ(std::filesystem::last_write_time(shard(0)), old_time);
+    EXPECT_NE(std::filesystem::last_write_time(shard(1)), old_time);
+    EXPECT_EQ(std::filesystem::last_write_time(shard(2)), old_time);
+
+    TaskManager reopened(test_file, options);
+    EXPECT_EQ(reopened.get_task(120)->get_description(), "Changed");
+    EXPECT_EQ(reopened.get_task(130), nullptr);
+    EXPECT_EQ(reopened.list_tasks().size(), 249);
+}
+
+TEST_F(ShardedManagerTest, JournalIsReplayedOverShards) {
+    fill(250);
+    {
+        TaskManager manager(test_file, options);
+        manager.update_task_status(10, "IN_PROGRESS");
+        manager.add_task("Journaled");
+    }
+    TaskManager reopened(test_file, options);
+    EXPECT_EQ(reopened.get_task(10)->get_status(), TaskStatus::IN_PROGRESS);
+    EXPECT_EQ(reopened.get_task(251)->get_description(), "Journaled");
+    EXPECT_EQ(reopened.count_tasks(TaskStatus::TO_DO), 249);
+}
+
+TEST_F(ShardedManagerTest, ImportJournalsOnlyImportedTasks) {
+    fill(250);
+    {
+        // 导入时读入的分片任务也追加在末尾, 它们不能被当作新任务写入 journal
+        TaskManager manager(test_file, options);
+        std::istringstream input("id,description\n260,Imported\n");
+        EXPECT_EQ(manager.import_stream(input).imported, 1);
+    }
+    std::ifstream journal(test_file + ".journal");
+    std::string line;
+    std::vector<std::string> records;
+    while (std::getline(journal, line)) {
+        if (line.find("\"op\"") != std::string::npos) {
+            records.push_back(line);
+        }
+    }
+    ASSERT_EQ(records.size(), 1);
+    EXPECT_NE(records[0].find("Imported"), std::string::npos);
+
+    TaskManager reopened(test_file, options);
+    EXPECT_EQ(reopened.list_tasks().size(), 251);
+    EXPECT_EQ(reopened.get_task(260)->get_description(), "Imported");
+}
+
+TEST_F(ShardedManagerTest, ClearRemovesShardFiles) {
+    fill(250);
+    {
+        TaskManager manager(test_file, options);
+        EXPECT_TRUE(manager.clear_all_tasks());
+        manager.add_task("After clear");
+        manager.compact();
+    }
+    EXPECT_FALSE(std::filesystem::exists(shard(0)));
+    EXPECT_FALSE(std::filesystem::exists(shard(1)));
+    EXPECT_TRUE(std::filesystem::exists(shard(2)));
+
+    TaskManager reopened(test_file, options);
+    ASSERT_EQ(reopened.list_tasks().size(), 1);
+    EXPECT_EQ(reopened.list_tasks()[0]->get_id(), 251);
+}
+
+TEST_F(ShardedManagerTest, SingleFileStoreIsConverted) {
+    {
+        TaskManager manager(test_file);
+        manager.add_task("First");
+        manager.add_task("Second");
+    }
+    {
+        TaskManager manager(test_file, options);
+        EXPECT_EQ(manager.list_tasks().size(), 2);
+    }
+    std::string manifest;
+    EXPECT_TRUE(ShardSet::read_manifest(test_file, manifest));
+    EXPECT_TRUE(std::filesystem::exists(shard(0)));
+    TaskManager reopened(test_file);
+    EXPECT_EQ(reopened.get_task(2)->get_description(), "Second");
+}
+
+TEST_F(ShardedManagerTest, RollbackReloadsShards) {
+    fill(250);
+    TaskManager manager(test_file, options);
+    manager.begin_batch();
+    manager.remove_task(50);
+    manager.update_task_status(220, "DONE");
+    manager.rollback();
+    EXPECT_NE(manager.get_task(50), nullptr);
+    EXPECT_EQ(manager.get_task(220)->get_status(), TaskStatus::TO_DO);
+    EXPECT_EQ(manager.count_tasks(TaskStatus::DONE), 1);
+}
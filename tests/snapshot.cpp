@@ -0,0 +1,532 @@
+#include <gtest/gtest.h>
+#include "task-tracker/snapshot.h"
+#include "task-tracker/task_manager.h"
+#include <algorithm>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+TEST(SnapshotTest, FormatForPath) {
+    EXPECT_EQ(format_for_path("tasks.json"), SnapshotFormat::Json);
+    EXPECT_EQ(format_for_path("tasks.bin"), SnapshotFormat::Binary);
+    EXPECT_EQ(format_for_path("dir.v2/tasks.TDB"), SnapshotFormat::Binary);
+    EXPECT_EQ(format_for_path("tasks"), SnapshotFormat::Json);
+}
+
+TEST(SnapshotTest, BinaryRoundTrip) {
+    Task first(1, "First task", TaskStatus::IN_PROGRESS, 1672567200, 1672568200);
+    Task second(7, "", TaskStatus::DONE, 1672657200, 1672658200);
+    Task third(9, "带有 UTF-8 的描述", TaskStatus::TO_DO, 1672743600, 1672743600);
+    std::string bytes = encode_binary_snapshot(10, { &first, &second, &third });
+
+    EXPECT_TRUE(is_binary_snapshot(bytes));
+    EXPECT_EQ(bytes.size(), binary_snapshot::header_size + 3 * binary_snapshot::record_size
+        + first.get_description().size() + third.get_description().size());
+
+    int next_id = 0;
+    std::vector<SnapshotRecord> decoded;
+    decode_binary_snapshot(bytes, next_id, [&decoded](const SnapshotRecord& record) {
+        decoded.push_back(record);
+    });
+    EXPECT_EQ(next_id, 10);
+    ASSERT_EQ(decoded.size(), 3);
+    EXPECT_EQ(decoded[0].id, 1);
+    EXPECT_EQ(decoded[0].description, "First task");
+    EXPECT_EQ(decoded[0].status, TaskStatus::IN_PROGRESS);
+    EXPECT_EQ(decoded[0].created_at, 1672567200);
+    EXPECT_EQ(decoded[0].updated_at, 1672568200);
+    EXPECT_EQ(decoded[1].description, "");
+    EXPECT_EQ(decoded[1].status, TaskStatus::DONE);
+    EXPECT_EQ(decoded[2].id, 9);
+    EXPECT_EQ(decoded[2].description, "带有 UTF-8 的描述");
+}
+
+TEST(SnapshotTest, RejectsTruncatedSnapshot) {
+    Task task(1, "Some description");
+    std::string bytes = encode_binary_snapshot(2, { &task });
+    bytes.pop_back();
+    int next_id = 0;
+    auto ignore = [](const SnapshotRecord&) {};
+    EXPECT_THROW(decode_binary_snapshot(bytes, next_id, ignore), std::runtime_error);
+    EXPECT_THROW(decode_binary_snapshot("[]", next_id, ignore), std::runtime_error);
+}
+
+TEST(SnapshotTest, BinaryNextIdIsAboveEveryId) {
+    Task task(9, "Highest id");
+    int next_id = 0;
+    auto ignore = [](const SnapshotRecord&) {};
+    // 手动改过的 next_id 不能让新任务重用已有的 id
+    decode_binary_snapshot(encode_binary_snapshot(3, { &task }), next_id, ignore);
+    EXPECT_EQ(next_id, 10);
+
+    EXPECT_THROW(decode_binary_snapshot(encode_binary_snapshot(0, { &task }), next_id, ignore), std::runtime_error);
+    std::string bytes = encode_binary_snapshot(10, { &task });
+    bytes[16 + 4] = 1; // next_id 超出 int 的范围
+    EXPECT_THROW(decode_binary_snapshot(bytes, next_id, ignore), std::runtime_error);
+}
+
+class BinaryManagerTest : public ::testing::Test {
+protected:
+    std::string test_file = "binary_manager_test.bin";
+    std::string json_file = "binary_manager_test.json";
+
+    void TearDown() override {
+        for (const std::string& file : { test_file, json_file }) {
+            std::remove(file.c_str());
+            std::remove((file + ".journal").c_str());
+        }
+    }
+};
+
+TEST_F(BinaryManagerTest, PersistsInBinaryFormat) {
+    std::remove(test_file.c_str());
+    {
+        TaskManager manager(test_file);
+        manager.add_task("Binary task 1");
+        manager.add_task("Binary task 2");
+        manager.update_task_status(2, "DONE");
+        manager.compact();
+    }
+    std::ifstream ifs(test_file, std::ios::binary);
+    std::string bytes((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+    EXPECT_TRUE(is_binary_snapshot(bytes));
+
+    TaskManager reloaded(test_file);
+    ASSERT_EQ(reloaded.list_tasks().size(), 2);
+    EXPECT_EQ(reloaded.get_task(2)->get_description(), "Binary task 2");
+    EXPECT_EQ(reloaded.get_task(2)->get_status(), TaskStatus::DONE);
+    EXPECT_EQ(reloaded.add_task("Binary task 3")->get_id(), 3);
+}
+
+TEST_F(BinaryManagerTest, ExportsAndImportsJson) {
+    std::remove(test_file.c_str());
+    {
+        TaskManager manager(test_file);
+        manager.add_task("Exported task");
+        manager.export_snapshot(json_file);
+    }
+    // 导出的 JSON 仍然可以直接作为存储打开
+    TaskManager from_json(json_file);
+    ASSERT_NE(from_json.get_task(1), nullptr);
+    EXPECT_EQ(from_json.get_task(1)->get_description(), "Exported task");
+
+    // 用二进制格式选项打开 JSON 文件, 合并后即迁移为二进制
+    {
+        TaskManager migrated(json_file, TaskManagerOptions{ SnapshotFormat::Binary });
+        migrated.compact();
+    }
+    std::ifstream ifs(json_file, std::ios::binary);
+    std::string bytes((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+    EXPECT_TRUE(is_binary_snapshot(bytes));
+    TaskManager reloaded(json_file);
+    EXPECT_EQ(reloaded.get_task(1)->get_description(), "Exported task");
+}
+
+TEST_F(BinaryManagerTest, MemoryMappedLoadBorrowsDescriptions) {
+    std::remove(test_file.c_str());
+    {
+        TaskManager manager(test_file);
+        manager.add_task("Mapped task 1");
+        manager.add_task("Mapped task 2");
+        manager.compact();
+    }
+    TaskManagerOptions options;
+    options.memory_map = true;
+    {
+        TaskManager manager(test_file, options);
+        Task* first = manager.get_task(1);
+        Task* second = manager.get_task(2);
+        ASSERT_NE(first, nullptr);
+        ASSERT_NE(second, nullptr);
+        // 描述直接引用映射的文件, 没有复制
+        EXPECT_FALSE(first->owns_description());
+        EXPECT_EQ(first->get_description(), "Mapped task 1");
+
+        // 修改时才持有自己的副本
+        manager.update_task_description(2, "Changed while mapped");
+        EXPECT_TRUE(second->owns_description());
+        EXPECT_FALSE(first->owns_description());
+
+        // 重写快照前释放映射
+        manager.compact();
+        EXPECT_TRUE(first->owns_description());
+        EXPECT_EQ(first->get_description(), "Mapped task 1");
+    }
+    TaskManager reloaded(test_file, options);
+    EXPECT_EQ(reloaded.get_task(1)->get_description(), "Mapped task 1");
+    EXPECT_EQ(reloaded.get_task(2)->get_description(), "Changed while mapped");
+}
+
+// 本进程对 path 的映射占用的 Rss (kB), 没有映射时返回 -1
+static long mapped_rss_kb(const std::string& path) {
+    std::ifstream smaps("/proc/self/smaps");
+    std::string line;
+    bool inside = false;
+    while (std::getline(smaps, line)) {
+        if (line.size() > path.size() && line.ends_with(" " + path)) {
+            inside = true;
+        }
+        else if (inside && line.starts_with("Rss:")) {
+            return std::stol(line.substr(4));
+        }
+    }
+    return -1;
+}
+
+TEST_F(BinaryManagerTest, MemoryMappedLoadLeavesDescriptionPagesUnread) {
+    if (!std::filesystem::exists("/proc/self/smaps")) {
+        GTEST_SKIP() << "needs /proc/self/smaps";
+    }
+    // 32 MB 的描述, 元数据只有 160 KB
+    std::deque<Task> tasks;
+    std::vector<const Task*> list;
+    for (int i = 1; i <= 4000; i++) {
+        list.push_back(&tasks.emplace_back(i, std::string(8192, 'a' + i % 26), TaskStatus::TO_DO, 1672567200, 1672567200));
+    }
+    {
+        std::ofstream ofs(test_file, std::ios::binary | std::ios::trunc);
+        ofs << encode_binary_snapshot(4001, list);
+    }
+    std::string path = std::filesystem::absolute(test_file).string();
+    TaskManagerOptions options;
+    options.memory_map = true;
+    {
+        TaskManager manager(path, options);
+        ASSERT_EQ(manager.list_tasks().size(), 4000);
+        long rss = mapped_rss_kb(path);
+        ASSERT_GE(rss, 0);
+        // 加载和计算 journal 指纹都不读描述所在的页;
+        // 内核按大页或 fault-around 映射元数据附近的页, 所以只要求远小于整个文件
+        EXPECT_LT(rss, 32 * 1024 / 4);
+        EXPECT_EQ(manager.get_task(4000)->get_description(), std::string(8192, 'a' + 4000 % 26));
+    }
+    // 指纹与写入快照时算出的一致, journal 没有被当作不匹配丢弃
+    {
+        TaskManager manager(path, options);
+        manager.add_task("Journaled on top of the mapping");
+    }
+    TaskManager reloaded(path, options);
+    ASSERT_NE(reloaded.get_task(4001), nullptr);
+    EXPECT_EQ(reloaded.get_task(4001)->get_description(), "Journaled on top of the mapping");
+}
+
+TEST(SnapshotTest, JsonStreamingSkipsMalformedRecords) {
+    std::string json = R"({
+        "tasks": [
+            {"id": 1, "description": "Good task", "status": "DONE", "created_at": 10, "updated_at": 20},
+            {"id": 2, "description": "Bad status", "status": "FINISHED"},
+            {"description": "No id", "status": "TO_DO"},
+            42,
+            {"id": 5, "description": ["not", "a", "string"], "status": "TO_DO"},
+            {"id": 6, "description": "Extra fields are fine", "status": "IN_PROGRESS", "owner": {"name": "x"}}
+        ],
+        "next_id": 3
+    })";
+    int next_id = 1;
+    std::vector<std::pair<int, std::string>> tasks;
+    std::vector<std::string> problems;
+    bool ok = decode_json_snapshot(std::string_view(json), next_id,
+        [&tasks](const SnapshotRecord& record) {
+            tasks.emplace_back(record.id, std::string(record.description));
+        },
+        [&problems](const std::string& message) { problems.push_back(message); });
+
+    EXPECT_TRUE(ok);
+    ASSERT_EQ(tasks.size(), 2);
+    EXPECT_EQ(tasks[0].first, 1);
+    EXPECT_EQ(tasks[0].second, "Good task");
+    EXPECT_EQ(tasks[1].first, 6);
+    // next_id 不会小于已加载的最大 ID
+    EXPECT_EQ(next_id, 7);
+
+    // 每条错误都指出记录序号和字段
+    ASSERT_EQ(problems.size(), 4);
+    EXPECT_NE(problems[0].find("#2 (id 2)"), std::string::npos);
+    EXPECT_NE(problems[0].find("'FINISHED'"), std::string::npos);
+    EXPECT_NE(problems[1].find("'id' is missing"), std::string::npos);
+    EXPECT_NE(problems[2].find("#4 is not an object"), std::string::npos);
+    EXPECT_NE(problems[3].find("'description' must not be an array"), std::string::npos);
+}
+
+TEST(SnapshotTest, JsonIdsOutsideTheUsableRangeAreSkipped) {
+    // ID 只能是 1 到 INT_MAX - 1, 否则下一个 ID 会溢出
+    std::string json = R"({"next_id": 99999999999, "tasks": [
+        {"id": 0, "description": "Zero", "status": "TO_DO"},
+        {"id": -3, "description": "Negative", "status": "TO_DO"},
+        {"id": 2147483647, "description": "Last int", "status": "TO_DO"},
+        {"id": 2147483646, "description": "Last usable", "status": "TO_DO"}
+    ]})";
+    int next_id = 1;
+    std::vector<int> ids;
+    std::vector<std::string> problems;
+    EXPECT_TRUE(decode_json_snapshot(std::string_view(json), next_id,
+        [&ids](const SnapshotRecord& record) { ids.push_back(record.id); },
+        [&problems](const std::string& message) { problems.push_back(message); }));
+    EXPECT_EQ(ids, (std::vector<int>{ 2147483646 }));
+    EXPECT_EQ(next_id, 2147483647);
+    ASSERT_EQ(problems.size(), 4);
+    EXPECT_NE(problems[0].find("next_id 99999999999 is out of range"), std::string::npos);
+    EXPECT_NE(problems[1].find("#1 (id 0): field 'id' is out of range"), std::string::npos);
+    EXPECT_NE(problems[3].find("#3 (id 2147483647)"), std::string::npos);
+
+    // 超出范围的 next_id 被限制在 1 到 INT_MAX 之间, 并且仍然大于所有 ID
+    auto ignore = [](const SnapshotRecord&) {};
+    auto quiet = [](const std::string&) {};
+    next_id = 7;
+    EXPECT_TRUE(decode_json_snapshot(std::string_view(R"({"next_id": 0, "tasks": []})"), next_id, ignore, quiet));
+    EXPECT_EQ(next_id, 1);
+    EXPECT_TRUE(decode_json_snapshot(std::string_view(
+        R"({"next_id": -5, "tasks": [{"id": 4, "description": "", "status": "TO_DO"}]})"), next_id, ignore, quiet));
+    EXPECT_EQ(next_id, 5);
+}
+
+TEST(SnapshotTest, JsonSyntaxErrorKeepsEarlierRecords) {
+    std::string json = R"({"next_id": 3, "tasks": [
+        {"id": 1, "description": "Before the damage", "status": "TO_DO"},
+        {"id": 2, "description": "Cut off)";
+    std::istringstream input(json);
+    int next_id = 1;
+    std::vector<int> ids;
+    std::vector<std::string> problems;
+    bool ok = decode_json_snapshot(input, next_id,
+        [&ids](const SnapshotRecord& record) { ids.push_back(record.id); },
+        [&problems](const std::string& message) { problems.push_back(message); });
+
+    EXPECT_FALSE(ok);
+    ASSERT_EQ(ids.size(), 1);
+    EXPECT_EQ(ids[0], 1);
+    ASSERT_EQ(problems.size(), 1);
+    EXPECT_NE(problems[0].find("syntax error at byte"), std::string::npos);
+}
+
+TEST(SnapshotTest, JsonEmptyArrayIsEmptyStore) {
+    int next_id = 1;
+    int emitted = 0;
+    EXPECT_TRUE(decode_json_snapshot(std::string_view("[]"), next_id,
+        [&emitted](const SnapshotRecord&) { emitted++; },
+        [](const std::string&) {}));
+    EXPECT_EQ(emitted, 0);
+    EXPECT_EQ(next_id, 1);
+}
+
+TEST(SnapshotTest, JsonScanLeavesDescriptionsInPlace) {
+    std::string json = R"({"next_id": 2, "tasks": [
+        {"id": 1, "description": "Plain 描述", "status": "DONE", "created_at": 10, "updated_at": 20, "owner": [1, {"x": null}]},
+        {"id": 4, "description": "Say \"hi\"\n", "status": "TO_DO"}
+    ]})";
+    int next_id = 1;
+    std::vector<SnapshotRecord> records;
+    std::vector<std::string> texts;
+    EXPECT_TRUE(scan_json_snapshot(json, next_id, [&](const SnapshotRecord& record) {
+        records.push_back(record);
+        texts.emplace_back(record.description);
+    }));
+    ASSERT_EQ(records.size(), 2);
+    EXPECT_EQ(next_id, 5);
+    // 没有转义的描述直接引用原文
+    EXPECT_TRUE(records[0].in_place);
+    EXPECT_EQ(records[0].description.data(), json.data() + json.find("Plain"));
+    EXPECT_EQ(texts[0], "Plain 描述");
+    EXPECT_EQ(records[0].status, TaskStatus::DONE);
+    EXPECT_EQ(records[0].updated_at, 20);
+    EXPECT_FALSE(records[1].in_place);
+    EXPECT_EQ(texts[1], "Say \"hi\"\n");
+
+    // 快速路径不处理的内容交给完整的解析器
+    auto ignore = [](const SnapshotRecord&) {};
+    EXPECT_TRUE(scan_json_snapshot("[]", next_id, ignore));
+    EXPECT_FALSE(scan_json_snapshot(R"({"tasks": [{"id": 1, "status": "TO_DO"}]})", next_id, ignore));
+    EXPECT_FALSE(scan_json_snapshot(R"({"tasks": [{"id": 1.5, "description": "", "status": "TO_DO"}]})", next_id, ignore));
+    EXPECT_FALSE(scan_json_snapshot(R"({"tasks": [)", next_id, ignore));
+    EXPECT_FALSE(scan_json_snapshot("{\"tasks\": [{\"id\": 1, \"description\": \"\xff\", \"status\": \"TO_DO\"}]}", next_id, ignore));
+}
+
+TEST(SnapshotTest, JsonScanAgreesWithSaxOnUtf8) {
+    // 快速路径和完整解析器对同一段字节给出相同的结论
+    const std::vector<std::pair<std::string, bool>> cases = {
+        { "\xc0\xaf", false }, { "\xc1\xbf", false }, { "\xe0\x9f\xbf", false }, { "\xed\xa0\x80", false },
+        { "\xf0\x8f\xbf\xbf", false }, { "\xf4\x90\x80\x80", false }, { "\xf5\x80\x80\x80", false },
+        { "\xe4\xb8", false }, { "\xff", false },
+        { "\xc2\x80", true }, { "\xe0\xa0\x80", true }, { "\xed\x9f\xbf", true }, { "\xf0\x90\x80\x80", true },
+        { "\xf4\x8f\xbf\xbf", true },
+    };
+    for (const auto& [bytes, valid] : cases) {
+        std::string json = "{\"tasks\": [{\"id\": 1, \"description\": \"a" + bytes + "\", \"status\": \"TO_DO\"}]}";
+        for (unsigned threads : { 1u, 2u }) {
+            int next_id = 1;
+            std::string scanned;
+            bool fast = scan_json_snapshot(json, next_id,
+                [&scanned](const SnapshotRecord& record) { scanned = record.description; }, threads);
+            next_id = 1;
+            std::string decoded;
+            bool full = decode_json_snapshot(std::string_view(json), next_id,
+                [&decoded](const SnapshotRecord& record) { decoded = record.description; },
+                [](const std::string&) {});
+            EXPECT_EQ(full, valid);
+            EXPECT_EQ(fast, full);
+            if (valid) {
+                EXPECT_EQ(scanned, decoded);
+            }
+        }
+    }
+}
+
+TEST(SnapshotTest, JsonScanLeavesOutOfRangeIdsToSax) {
+    // 超出范围的 ID 和 next_id 由完整解析器报告
+    auto ignore = [](const SnapshotRecord&) {};
+    for (const char* json : {
+             R"({"tasks": [{"id": 0, "description": "", "status": "TO_DO"}]})",
+             R"({"tasks": [{"id": -1, "description": "", "status": "TO_DO"}]})",
+             R"({"tasks": [{"id": 2147483647, "description": "", "status": "TO_DO"}]})",
+             R"({"next_id": 0, "tasks": []})",
+             R"({"next_id": 2147483648, "tasks": []})" }) {
+        int next_id = 1;
+        EXPECT_FALSE(scan_json_snapshot(json, next_id, ignore)) << json;
+    }
+
+    int next_id = 1;
+    EXPECT_TRUE(scan_json_snapshot(R"({"next_id": 2147483647, "tasks": [{"id": 2147483646, "description": "", "status": "TO_DO"}]})",
+        next_id, ignore));
+    EXPECT_EQ(next_id, 2147483647);
+}
+
+TEST(SnapshotTest, JsonEncoderMatchesNlohmannDump) {
+    Task first(1, "Plain", TaskStatus::IN_PROGRESS, 1672567200, 1672568200);
+    Task second(2, "Quote \" backslash \\ tab \t bell \x07 中文", TaskStatus::DONE, -5, 0);
+    std::vector<const Task*> tasks = { &first, &second };
+
+    nlohmann::json expected;
+    expected["next_id"] = 3;
+    expected["tasks"] = nlohmann::json::array();
+    for (const Task* task : tasks) {
+        nlohmann::json item;
+        item["id"] = task->get_id();
+        item["description"] = task->get_description();
+        item["status"] = status_to_string(task->get_status());
+        item["created_at"] = task->get_created_at();
+        item["updated_at"] = task->get_updated_at();
+        expected["tasks"].push_back(item);
+    }
+    EXPECT_EQ(encode_json_snapshot(3, tasks), expected.dump(4));
+
+    nlohmann::json empty;
+    empty["next_id"] = 1;
+    empty["tasks"] = nlohmann::json::array();
+    EXPECT_EQ(encode_json_snapshot(1, {}), empty.dump(4));
+
+    // 与 nlohmann::json 一样拒绝无效的 UTF-8
+    Task invalid(3, "\xff");
+    EXPECT_THROW(encode_json_snapshot(4, { &invalid }), nlohmann::json::exception);
+}
+
+TEST(SnapshotTest, ParallelEncodingAndScanningKeepOrder) {
+    std::deque<Task> owned;
+    for (int i = 1; i <= 20000; i++) {
+        std::string description = "Task " + std::to_string(i) + (i % 7 == 0 ? " \"quoted\"" : "");
+        owned.emplace_back(i, description, static_cast<TaskStatus>(i % 3), 1672567200 + i, 1672567200 + 2 * i);
+    }
+    std::vector<const Task*> tasks;
+    for (const Task& task : owned) {
+        tasks.push_back(&task);
+    }
+    // 多线程编码的结果与单线程相同
+    std::string json = encode_json_snapshot(20001, tasks, 1);
+    EXPECT_EQ(encode_json_snapshot(20001, tasks, 4), json);
+    EXPECT_EQ(encode_binary_snapshot(20001, tasks, 4), encode_binary_snapshot(20001, tasks, 1));
+
+    auto scan = [](std::string_view bytes, unsigned threads, std::vector<std::string>& texts) {
+        int next_id = 1;
+        std::vector<int> ids;
+        bool ok = scan_json_snapshot(bytes, next_id, [&](const SnapshotRecord& record) {
+            ids.push_back(record.id);
+            texts.emplace_back(record.description);
+        }, threads);
+        EXPECT_TRUE(ok);
+        EXPECT_EQ(next_id, static_cast<int>(ids.size()) + 1);
+        return ids;
+    };
+    std::vector<std::string> sequential_texts, parallel_texts;
+    std::vector<int> ids = scan(json, 1, sequential_texts);
+    ASSERT_EQ(ids.size(), 20000);
+    EXPECT_TRUE(std::is_sorted(ids.begin(), ids.end()));
+    EXPECT_EQ(scan(json, 4, parallel_texts), ids);
+    EXPECT_EQ(parallel_texts, sequential_texts);
+    EXPECT_EQ(parallel_texts[6], "Task 7 \"quoted\"");
+
+    // 行首的 '{' 不一定是任务记录, 分块对不上时整体重新扫描
+    std::string nested = "{\"next_id\": 1, \"tasks\": [\n";
+    for (int i = 1; i <= 40000; i++) {
+        nested += std::string(i == 1 ? "" : ",\n") + "{\"id\": " + std::to_string(i)
+            + ", \"description\": \"Nested " + std::to_string(i) + "\", \"meta\":\n{\"a\":\n{\"b\":\n{\"c\": 1}}},\n\"status\": \"TO_DO\"}";
+    }
+    nested += "\n]}";
+    std::vector<std::string> nested_texts;
+    EXPECT_EQ(scan(nested, 4, nested_texts).size(), 40000);
+    EXPECT_EQ(nested_texts.back(), "Nested 40000");
+}
+
+TEST_F(BinaryManagerTest, ParallelLoadMatchesSequentialLoad) {
+    TaskManagerOptions options;
+    options.threads = 4;
+    {
+        TaskManager manager(json_file, options);
+        std::vector<std::string> descriptions;
+        for (int i = 1; i <= 20000; i++) {
+            descriptions.push_back("Task " + std::to_string(i));
+        }
+        manager.add_tasks(descriptions);
+        manager.update_task_status(5000, "DONE");
+        manager.compact();
+    }
+    TaskManager parallel(json_file, options);
+    TaskManager sequential(json_file);
+    ASSERT_EQ(parallel.list_tasks().size(), 20000);
+    EXPECT_EQ(parallel.list_tasks().back()->get_id(), 20000);
+    EXPECT_EQ(parallel.get_task(5000)->get_status(), TaskStatus::DONE);
+    EXPECT_EQ(parallel.count_tasks(TaskStatus::DONE), sequential.count_tasks(TaskStatus::DONE));
+    EXPECT_EQ(parallel.get_task(9999)->get_description(), sequential.get_task(9999)->get_description());
+    EXPECT_EQ(parallel.add_task("Next")->get_id(), 20001);
+}
+
+TEST_F(BinaryManagerTest, MemoryMappedJsonCopiesDescriptions) {
+    {
+        std::ofstream ofs(json_file);
+        ofs << R"({"next_id": 3, "tasks": [
+            {"id": 1, "description": "Left in the file", "status": "TO_DO"},
+            {"id": 2, "description": "Has a \"quote\"", "status": "DONE"}
+        ]})";
+    }
+    TaskManagerOptions options;
+    options.memory_map = true;
+    {
+        TaskManager manager(json_file, options);
+        // 扫描 JSON 要读遍整个文件, 借用映射省不下什么, 描述都有自己的副本
+        EXPECT_TRUE(manager.get_task(1)->owns_description());
+        EXPECT_EQ(manager.get_task(1)->get_description(), "Left in the file");
+        EXPECT_TRUE(manager.get_task(2)->owns_description());
+        EXPECT_EQ(manager.get_task(2)->get_description(), "Has a \"quote\"");
+        manager.compact();
+        EXPECT_EQ(manager.get_task(1)->get_description(), "Left in the file");
+    }
+    TaskManager reloaded(json_file, options);
+    EXPECT_EQ(reloaded.list_tasks().size(), 2);
+    EXPECT_EQ(reloaded.get_task(2)->get_description(), "Has a \"quote\"");
+}
+
+TEST_F(BinaryManagerTest, MemoryMappedJsonFallsBackOnBadRecords) {
+    {
+        std::ofstream ofs(json_file);
+        ofs << R"({"tasks": [
+            {"id": 1, "description": "Still loaded", "status": "TO_DO"},
+            {"id": 2, "description": "Bad status", "status": "FINISHED"}
+        ]})";
+    }
+    TaskManagerOptions options;
+    options.memory_map = true;
+    TaskManager manager(json_file, options);
+    ASSERT_EQ(manager.list_tasks().size(), 1);
+    // 完整解析器读出的描述都有自己的副本
+    EXPECT_TRUE(manager.get_task(1)->owns_description());
+    EXPECT_EQ(manager.get_task(1)->get_description(), "Still loaded");
+}
@@ -0,0 +1,127 @@
+#include <gtest/gtest.h>
+#include "task-tracker/task_store.h"
+#include "task-tracker/id_index.h"
+#include <memory_resource>
+
+TEST(StringPoolTest, StoresSmallAndLargeTexts) {
+    StringPool pool;
+    std::string_view small = pool.store("short text");
+    std::string large(100 * 1024, 'x');
+    std::string_view big = pool.store(large);
+    std::string_view after = pool.store("after the large one");
+    // 大文本单独分配, 不影响正在填充的块
+    EXPECT_EQ(small, "short text");
+    EXPECT_EQ(big, large);
+    EXPECT_EQ(after, "after the large one");
+    EXPECT_EQ(after.data(), small.data() + 16); // 按 8 字节取整
+    EXPECT_TRUE(pool.store("").empty());
+}
+
+TEST(StringPoolTest, ReleasedTextsAreReused) {
+    StringPool pool;
+    std::string_view first = pool.store("twelve bytes");
+    pool.store("keeps the block busy");
+    std::size_t used = pool.bytes_used();
+    pool.release(first);
+    EXPECT_EQ(pool.bytes_used(), used - 16);
+    // 同一大小等级的文本复用刚释放的空间
+    std::string_view again = pool.store("fifteen bytes..");
+    EXPECT_EQ(again.data(), first.data());
+    EXPECT_EQ(again, "fifteen bytes..");
+    EXPECT_EQ(pool.bytes_used(), used);
+
+    std::size_t reserved = pool.bytes_reserved();
+    std::string_view big = pool.store(std::string(100 * 1024, 'y'));
+    EXPECT_EQ(pool.bytes_reserved(), reserved + big.size());
+    pool.release(big);
+    EXPECT_EQ(pool.bytes_reserved(), reserved);
+}
+
+TEST(StringPoolTest, UsesTheGivenMemoryResource) {
+    std::pmr::monotonic_buffer_resource arena;
+    StringPool pool(&arena);
+    std::string_view text = pool.store("from the arena");
+    EXPECT_EQ(text, "from the arena");
+    pool.clear();
+}
+
+TEST(TaskStoreTest, PointersStayValidAcrossChunks) {
+    TaskStore store;
+    std::vector<Task*> created;
+    for (int i = 1; i <= 5000; i++) {
+        created.push_back(store.create(i, "Task " + std::to_string(i), TaskStatus::TO_DO, 100, 200));
+    }
+    EXPECT_EQ(store.size(), 5000);
+    for (int i = 1; i <= 5000; i++) {
+        EXPECT_EQ(created[i - 1]->get_id(), i);
+        EXPECT_EQ(created[i - 1]->get_description(), "Task " + std::to_string(i));
+    }
+    // 相邻任务在内存中连续存放
+    EXPECT_EQ(reinterpret_cast<char*>(created[1]) - reinterpret_cast<char*>(created[0]), sizeof(Task));
+}
+
+TEST(TaskStoreTest, DestroyedSlotsAreReused) {
+    TaskStore store;
+    Task* first = store.create(1, "First", TaskStatus::TO_DO, 100, 200);
+    store.create(2, "Second", TaskStatus::DONE, 100, 200);
+    store.destroy(first);
+    EXPECT_EQ(store.size(), 1);
+    Task* third = store.create(3, "Third", TaskStatus::IN_PROGRESS, 300, 400);
+    EXPECT_EQ(third, first);
+    EXPECT_EQ(third->get_id(), 3);
+    EXPECT_EQ(third->get_description(), "Third");
+    EXPECT_EQ(third->get_status(), TaskStatus::IN_PROGRESS);
+    // 描述 "First" 的空间也已归还并被 "Third" 复用
+    EXPECT_EQ(store.descriptions().bytes_used(), 16u);
+    store.clear();
+    EXPECT_EQ(store.size(), 0);
+}
+
+TEST(TaskStoreTest, UpdateAndOwnDescription) {
+    TaskStore store;
+    std::string external = "Borrowed text";
+    Task* task = store.create_borrowed(1, external, TaskStatus::TO_DO, 100, 100);
+    EXPECT_FALSE(task->owns_description());
+    EXPECT_EQ(task->get_description().data(), external.data());
+
+    store.own_description(task);
+    EXPECT_TRUE(task->owns_description());
+    EXPECT_NE(task->get_description().data(), external.data());
+    EXPECT_EQ(task->get_description(), "Borrowed text");
+
+    store.update_description(task, "Pooled text");
+    EXPECT_EQ(task->get_description(), "Pooled text");
+    EXPECT_GT(task->get_updated_at(), 100);
+}
+
+TEST(IdIndexTest, FindInsertErase) {
+    IdIndex index;
+    for (int id = 1; id <= 1000; id++) {
+        index.insert_or_assign(id, static_cast<std::uint32_t>(id * 2));
+    }
+    index.insert_or_assign(-2147483647 - 1, 7); // 与空位标记相同的 id
+    EXPECT_EQ(index.size(), 1001u);
+
+    // 删除一半后，其余 id 仍能找到（检验回移删除）
+    for (int id = 1; id <= 1000; id += 2) {
+        EXPECT_TRUE(index.erase(id));
+    }
+    EXPECT_FALSE(index.erase(1));
+    for (int id = 1; id <= 1000; id++) {
+        const std::uint32_t* slot = index.find(id);
+        if (id % 2) {
+            EXPECT_EQ(slot, nullptr);
+        }
+        else {
+            ASSERT_NE(slot, nullptr);
+            EXPECT_EQ(*slot, static_cast<std::uint32_t>(id * 2));
+        }
+    }
+    ASSERT_NE(index.find(-2147483647 - 1), nullptr);
+    EXPECT_EQ(*index.find(-2147483647 - 1), 7u);
+    EXPECT_EQ(index.size(), 501u);
+
+    index.clear();
+    EXPECT_TRUE(index.empty());
+    EXPECT_EQ(index.find(2), nullptr);
+}
@@ -0,0 +1,89 @@
+#include <gtest/gtest.h>
+#include "task-tracker/substring_search.h"
+#include "task-tracker/task_manager.h"
+#include <fstream>
+#include <random>
+
+static const ScanKernel all_kernels[] = { ScanKernel::Scalar, ScanKernel::Sse2, ScanKernel::Avx2 };
+
+TEST(SubstringSearchTest, KernelsAgreeWithFind) {
+    std::mt19937 random(42);
+    // 小字母表让首尾字节经常匹配, 能覆盖候选位置的比较
+    auto text_of = [&random](std::size_t size) {
+        std::string text;
+        for (std::size_t i = 0; i < size; i++) {
+            text.push_back(static_cast<char>('a' + random() % 3));
+        }
+        return text;
+    };
+    for (ScanKernel kernel : all_kernels) {
+        if (!scan_kernel_supported(kernel)) {
+            continue;
+        }
+        for (int round = 0; round < 2000; round++) {
+            std::string text = text_of(random() % 120);
+            std::string needle = text_of(random() % 8);
+            SubstringMatcher matches(needle, kernel);
+            EXPECT_EQ(matches.kernel(), kernel);
+            ASSERT_EQ(matches(text), text.find(needle) != std::string::npos)
+                << scan_kernel_name(kernel) << ": '" << needle << "' in '" << text << "'";
+        }
+    }
+}
+
+TEST(SubstringSearchTest, MatchesAtBlockEdges) {
+    for (ScanKernel kernel : all_kernels) {
+        if (!scan_kernel_supported(kernel)) {
+            continue;
+        }
+        SubstringMatcher matches("deploy", kernel);
+        for (std::size_t at = 0; at < 80; at++) {
+            std::string text(at, 'x');
+            text += "deploy";
+            EXPECT_TRUE(matches(text)) << scan_kernel_name(kernel) << " at " << at;
+            text.pop_back();
+            EXPECT_FALSE(matches(text)) << scan_kernel_name(kernel) << " at " << at;
+        }
+        EXPECT_TRUE(SubstringMatcher("", kernel)(""));
+        EXPECT_TRUE(SubstringMatcher("部署", kernel)("检查部署清单"));
+        EXPECT_FALSE(SubstringMatcher("Deploy", kernel)("deploy"));
+    }
+    EXPECT_TRUE(scan_kernel_supported(best_scan_kernel()));
+}
+
+class FilterContainsTest : public ::testing::Test {
+protected:
+    std::string test_file = "filter_contains_test_file.json";
+
+    void SetUp() override {
+        std::ofstream ofs(test_file);
+        ASSERT_TRUE(ofs.is_open());
+        ofs << "[]";
+    }
+
+    void TearDown() override {
+        std::remove(test_file.c_str());
+        std::remove((test_file + ".journal").c_str());
+    }
+};
+
+TEST_F(FilterContainsTest, ScansEveryDescription) {
+    TaskManagerOptions options;
+    options.threads = 4;
+    TaskManager manager(test_file, options);
+    std::vector<std::string> descriptions;
+    for (int i = 1; i <= 40000; i++) {
+        descriptions.push_back(i % 1000 == 0 ? "Deploy build " + std::to_string(i) : "Task " + std::to_string(i));
+    }
+    manager.add_tasks(descriptions);
+    manager.remove_task(5000);
+
+    std::vector<const Task*> found = manager.filter_contains("Deploy");
+    ASSERT_EQ(found.size(), 39);
+    EXPECT_EQ(found.front()->get_id(), 1000);
+    EXPECT_EQ(found.back()->get_id(), 40000);
+    // 子串不必是完整的词
+    EXPECT_EQ(manager.filter_contains("ploy build 7000").size(), 1);
+    EXPECT_EQ(manager.filter_contains("Task 39999").size(), 1);
+    EXPECT_TRUE(manager.filter_contains("deploy").empty());
+}
@@ -0,0 +1,312 @@
+#include <gtest/gtest.h>
+#include "task-tracker/task_import.h"
+#include "task-tracker/task_manager.h"
+#include "task-tracker/ui.h"
+#include <fstream>
+#include <sstream>
+
+static std::vector<std::string> read_descriptions(const std::string& text, ImportFormat format,
+    std::size_t* rejected = nullptr) {
+    std::istringstream input(text);
+    ImportReader reader(input, format);
+    std::vector<std::string> descriptions;
+    ImportRecord record;
+    ImportReader::Result read;
+    while ((read = reader.next(record)) != ImportReader::Result::End) {
+        if (read == ImportReader::Result::Record) {
+            descriptions.emplace_back(record.description);
+        }
+        else if (rejected) {
+            (*rejected)++;
+        }
+    }
+    return descriptions;
+}
+
+TEST(ImportReaderTest, DetectsTheFormat) {
+    std::istringstream jsonl("\n  {\"description\":\"a\"}\n");
+    EXPECT_EQ(ImportReader(jsonl, ImportFormat::Auto).get_format(), ImportFormat::JsonLines);
+    std::istringstream tsv("id\tdescription\n1\ta\n");
+    EXPECT_EQ(ImportReader(tsv, ImportFormat::Auto).get_format(), ImportFormat::Tsv);
+    std::istringstream csv("description,status\na,DONE\n");
+    EXPECT_EQ(ImportReader(csv, ImportFormat::Auto).get_format(), ImportFormat::Csv);
+    // CSV 和 TSV 必须有 description 列
+    std::istringstream headless("id,status\n1,DONE\n");
+    EXPECT_THROW(ImportReader(headless, ImportFormat::Auto), std::runtime_error);
+}
+
+TEST(ImportReaderTest, ReadsJsonLines) {
+    std::istringstream input(
+        "{\"id\":7,\"description\":\"Plain\",\"status\":\"DONE\",\"created_at\":100,\"updated_at\":200,\"extra\":[1,{}]}\n"
+        "{\"description\":\"Say \\\"hi\\\"\\n\"}\r\n"
+        "{\"description\":\"Bad status\",\"status\":\"done\"}\n"
+        "{\"description\":\"Trailing\"} x\n"
+        "\n"
+        "{\"status\":\"DONE\"}\n"
+        "{\"description\":\"No line break\"}");
+    ImportReader reader(input, ImportFormat::JsonLines);
+    ImportRecord record;
+    ASSERT_EQ(reader.next(record), ImportReader::Result::Record);
+    EXPECT_EQ(record.id, 7);
+    EXPECT_EQ(record.description, "Plain");
+    EXPECT_EQ(record.status, TaskStatus::DONE);
+    EXPECT_EQ(record.created_at, 100);
+    EXPECT_EQ(record.updated_at, 200);
+
+    ASSERT_EQ(reader.next(record), ImportReader::Result::Record);
+    EXPECT_FALSE(record.id);
+    EXPECT_EQ(record.description, "Say \"hi\"\n");
+    EXPECT_EQ(record.status, TaskStatus::TO_DO);
+    EXPECT_FALSE(record.created_at);
+
+    // 无效的状态, 多余的内容, 缺少描述都会被拒绝; 空行被跳过
+    EXPECT_EQ(reader.next(record), ImportReader::Result::Rejected);
+    EXPECT_EQ(reader.line(), 3);
+    EXPECT_EQ(reader.next(record), ImportReader::Result::Rejected);
+    EXPECT_EQ(reader.next(record), ImportReader::Result::Rejected);
+    EXPECT_EQ(reader.line(), 6);
+    ASSERT_EQ(reader.next(record), ImportReader::Result::Record);
+    EXPECT_EQ(record.description, "No line break");
+    EXPECT_EQ(reader.next(record), ImportReader::Result::End);
+}
+
+TEST(ImportReaderTest, ReadsCsvAndTsv) {
+    std::size_t rejected = 0;
+    std::vector<std::string> csv = read_descriptions(
+        "status,description,ignored\r\n"
+        "DONE,plain,x\r\n"
+        "TO_DO,\"comma, \"\"quote\"\"\nand line break\",\r\n"
+        "TO_DO,missing field\r\n"
+        "BAD,bad status,x\r\n"
+        "\"IN_PROGRESS\",last,x", ImportFormat::Csv, &rejected);
+    EXPECT_EQ(csv, (std::vector<std::string>{ "plain", "comma, \"quote\"\nand line break", "last" }));
+    EXPECT_EQ(rejected, 2);
+
+    std::vector<std::string> tsv = read_descriptions(
+        "id\tdescription\n"
+        "1\ttab\\there\\\\\n"
+        "\tno id\n", ImportFormat::Tsv);
+    EXPECT_EQ(tsv, (std::vector<std::string>{ "tab\there\\", "no id" }));
+}
+
+TEST(ImportReaderTest, RejectsIdsOutsideTheUsableRange) {
+    // 0 和负数不是有效的 id; INT_MAX 之后的下一个 id 会溢出
+    for (ImportFormat format : { ImportFormat::JsonLines, ImportFormat::Csv, ImportFormat::Tsv }) {
+        std::string text = format == ImportFormat::Csv ? "id,description\n" : format == ImportFormat::Tsv ? "id\tdescription\n" : "";
+        for (const char* id : { "0", "-1", "2147483647", "2147483646" }) {
+            if (format == ImportFormat::JsonLines) {
+                text += std::string("{\"id\":") + id + ",\"description\":\"x\"}\n";
+            }
+            else {
+                text += std::string(id) + (format == ImportFormat::Csv ? "," : "\t") + "x\n";
+            }
+        }
+        std::istringstream input(text);
+        ImportReader reader(input, format);
+        ImportRecord record;
+        std::size_t first = format == ImportFormat::JsonLines ? 1 : 2;
+        for (std::size_t line = first; line < first + 3; line++) {
+            EXPECT_EQ(reader.next(record), ImportReader::Result::Rejected) << text;
+            EXPECT_EQ(reader.line(), line);
+        }
+        ASSERT_EQ(reader.next(record), ImportReader::Result::Record);
+        EXPECT_EQ(record.id, 2147483646);
+    }
+}
+
+TEST(ImportReaderTest, RejectsDescriptionsThatAreNotUtf8) {
+    // 第二行是 GBK 编码的 "中文", 第三行在多字节字符中间被截断, 最后一行是 UTF-8 的 "中文"
+    for (ImportFormat format : { ImportFormat::Csv, ImportFormat::Tsv }) {
+        std::istringstream input(std::string("description\n") + "Plain\n" + "\xd6\xd0\xce\xc4\n" + "cut \xe4\xb8\n"
+            + "\xe4\xb8\xad\xe6\x96\x87\n");
+        ImportReader reader(input, format);
+        ImportRecord record;
+        ASSERT_EQ(reader.next(record), ImportReader::Result::Record);
+        EXPECT_EQ(reader.next(record), ImportReader::Result::Rejected);
+        EXPECT_EQ(reader.line(), 3);
+        EXPECT_EQ(reader.next(record), ImportReader::Result::Rejected);
+        EXPECT_EQ(reader.line(), 4);
+        ASSERT_EQ(reader.next(record), ImportReader::Result::Record);
+        EXPECT_EQ(record.description, "\xe4\xb8\xad\xe6\x96\x87");
+    }
+}
+
+TEST(ImportReaderTest, RejectsOverlongSurrogateAndOutOfRangeUtf8) {
+    // 过长编码, 代理项和超过 U+10FFFF 的值都不是合法的 UTF-8
+    const std::vector<std::string> invalid = {
+        "\xc0\xaf", "\xc1\xbf", "\xe0\x9f\xbf", "\xed\xa0\x80", "\xed\xbf\xbf", "\xf0\x8f\xbf\xbf",
+        "\xf4\x90\x80\x80", "\xf5\x80\x80\x80", "\xf8\x88\x80\x80\x80", "\xff",
+    };
+    // 每个限制的边界值本身是合法的
+    const std::vector<std::string> valid = {
+        "\xc2\x80", "\xe0\xa0\x80", "\xed\x9f\xbf", "\xee\x80\x80", "\xf0\x90\x80\x80", "\xf4\x8f\xbf\xbf",
+    };
+    for (ImportFormat format : { ImportFormat::JsonLines, ImportFormat::Csv, ImportFormat::Tsv }) {
+        for (const std::vector<std::string>* list : { &invalid, &valid }) {
+            std::string text = format == ImportFormat::JsonLines ? "" : "description\n";
+            for (const std::string& bytes : *list) {
+                text += format == ImportFormat::JsonLines ? "{\"description\":\"a" + bytes + "\"}\n" : "a" + bytes + "\n";
+            }
+            std::size_t rejected = 0;
+            std::vector<std::string> descriptions = read_descriptions(text, format, &rejected);
+            if (list == &invalid) {
+                EXPECT_TRUE(descriptions.empty());
+                EXPECT_EQ(rejected, invalid.size());
+            }
+            else {
+                EXPECT_EQ(descriptions.size(), valid.size());
+                EXPECT_EQ(rejected, 0);
+            }
+        }
+    }
+}
+
+TEST(ImportReaderTest, RecordsSpanBlocks) {
+    std::string text;
+    for (int i = 0; i < 30000; i++) {
+        text += "{\"id\":" + std::to_string(i + 1) + ",\"description\":\"Imported task number " + std::to_string(i) + "\"}\n";
+    }
+    ASSERT_GT(text.size(), std::size_t(1) << 20);
+    std::vector<std::string> descriptions = read_descriptions(text, ImportFormat::Auto);
+    ASSERT_EQ(descriptions.size(), 30000);
+    for (int i = 0; i < 30000; i++) {
+        ASSERT_EQ(descriptions[i], "Imported task number " + std::to_string(i));
+    }
+}
+
+class ImportTest : public ::testing::Test {
+protected:
+    std::string test_file = "import_test_store.json";
+
+    void SetUp() override {
+        std::ofstream ofs(test_file);
+        ASSERT_TRUE(ofs.is_open());
+        ofs << "[]";
+    }
+
+    void TearDown() override {
+        std::remove(test_file.c_str());
+        std::remove((test_file + ".journal").c_str());
+    }
+};
+
+TEST_F(ImportTest, PreservesOrRemapsIds) {
+    TaskManager manager(test_file);
+    manager.add_task("Existing");
+    std::istringstream preserved(
+        "{\"id\":10,\"description\":\"Ten\",\"status\":\"DONE\",\"created_at\":100}\n"
+        "{\"id\":1,\"description\":\"Taken\"}\n"
+        "{\"description\":\"No id\"}\n"
+        "{\"id\":10,\"description\":\"Duplicate\"}\n");
+    ImportResult result = manager.import_stream(preserved);
+    EXPECT_EQ(result.imported, 2);
+    EXPECT_EQ(result.rejected, 2);
+    EXPECT_EQ(result.rejected_lines, (std::vector<std::size_t>{ 2, 4 }));
+    EXPECT_EQ(manager.get_task(10)->get_status(), TaskStatus::DONE);
+    EXPECT_EQ(manager.get_task(10)->get_updated_at(), 100);
+    EXPECT_EQ(manager.get_task(11)->get_description(), "No id");
+    EXPECT_EQ(manager.count_tasks(TaskStatus::DONE), 1);
+
+    ImportOptions remap;
+    remap.ids = ImportIds::Remap;
+    std::istringstream remapped("id,description\n1,First\n2,Second\n");
+    EXPECT_EQ(manager.import_stream(remapped, remap).imported, 2);
+    EXPECT_EQ(manager.get_task(12)->get_description(), "First");
+    EXPECT_EQ(manager.add_task("Next")->get_id(), 14);
+}
+
+TEST_F(ImportTest, RejectedIdsDoNotMoveNextId) {
+    TaskManager manager(test_file);
+    std::istringstream input(
+        "{\"id\":0,\"description\":\"Zero\"}\n"
+        "{\"id\":-1,\"description\":\"Negative\"}\n"
+        "{\"id\":2147483647,\"description\":\"Last int\"}\n"
+        "{\"id\":5,\"description\":\"Five\"}\n");
+    ImportResult result = manager.import_stream(input);
+    EXPECT_EQ(result.imported, 1);
+    EXPECT_EQ(result.rejected_lines, (std::vector<std::size_t>{ 1, 2, 3 }));
+    EXPECT_EQ(manager.add_task("Next")->get_id(), 6);
+}
+
+TEST_F(ImportTest, InvalidUtf8IsRejectedBeforeSaving) {
+    // 代理项在导入时就被拒绝, 不会让之后的 journal 或快照写入失败
+    {
+        TaskManager manager(test_file);
+        std::istringstream input("{\"description\":\"Surrogate \xed\xa0\x80\"}\n{\"description\":\"Fine\"}\n");
+        ImportResult result = manager.import_stream(input);
+        EXPECT_EQ(result.imported, 1);
+        EXPECT_EQ(result.rejected_lines, (std::vector<std::size_t>{ 1 }));
+        EXPECT_NO_THROW(manager.compact());
+    }
+    TaskManager reopened(test_file);
+    ASSERT_EQ(reopened.list_tasks().size(), 1);
+    EXPECT_EQ(reopened.get_task(1)->get_description(), "Fine");
+}
+
+TEST_F(ImportTest, RemapStopsWhenIdsRunOut) {
+    // 最后一个可用 ID 之后, 重新编号的记录和新任务都没有 ID 可用
+    TaskManager manager(test_file);
+    std::istringstream last("{\"id\":2147483646,\"description\":\"Last usable\"}\n");
+    EXPECT_EQ(manager.import_stream(last).imported, 1);
+    ImportOptions remap;
+    remap.ids = ImportIds::Remap;
+    std::istringstream more("description\nNo id left\n");
+    ImportResult result = manager.import_stream(more, remap);
+    EXPECT_EQ(result.imported, 0);
+    EXPECT_EQ(result.rejected_lines, (std::vector<std::size_t>{ 2 }));
+    EXPECT_THROW(manager.add_task("No id left"), std::runtime_error);
+    EXPECT_EQ(manager.list_tasks().size(), 1);
+}
+
+TEST_F(ImportTest, ImportIsPersisted) {
+    std::string many;
+    for (int i = 1; i <= 2000; i++) {
+        many += "{\"id\":" + std::to_string(i) + ",\"description\":\"Task " + std::to_string(i) + "\"}\n";
+    }
+    {
+        // 大量导入直接重写快照, 少量导入写入 journal
+        TaskManager manager(test_file);
+        std::istringstream large(many);
+        EXPECT_EQ(manager.import_stream(large).imported, 2000);
+        std::istringstream small("description\nJournaled\n");
+        EXPECT_EQ(manager.import_stream(small).imported, 1);
+    }
+    std::ifstream journal(test_file + ".journal");
+    std::string journal_text((std::istreambuf_iterator<char>(journal)), std::istreambuf_iterator<char>());
+    EXPECT_EQ(journal_text.find("Task 1\""), std::string::npos);
+    EXPECT_NE(journal_text.find("Journaled"), std::string::npos);
+
+    TaskManager reopened(test_file);
+    EXPECT_EQ(reopened.list_tasks().size(), 2001);
+    EXPECT_EQ(reopened.get_task(2001)->get_description(), "Journaled");
+}
+
+TEST_F(ImportTest, ExportRoundTrips) {
+    TaskManager manager(test_file);
+    manager.add_task("Plain");
+    manager.add_task("Comma, \"quotes\"\tand\nbreaks \\");
+    manager.update_task_status(2, "IN_PROGRESS");
+    for (RenderStyle style : { RenderStyle::JsonLines, RenderStyle::Csv, RenderStyle::Tsv }) {
+        std::stringstream exported;
+        export_tasks(manager, exported, style);
+        std::string store = "import_test_copy.json";
+        std::remove(store.c_str());
+        {
+            TaskManager copy(store);
+            ImportResult result = copy.import_stream(exported);
+            EXPECT_EQ(result.imported, 2);
+            EXPECT_EQ(result.rejected, 0);
+            for (int id : { 1, 2 }) {
+                const Task* original = manager.get_task(id);
+                const Task* imported = copy.get_task(id);
+                ASSERT_NE(imported, nullptr);
+                EXPECT_EQ(imported->get_description(), original->get_description());
+                EXPECT_EQ(imported->get_status(), original->get_status());
+                EXPECT_EQ(imported->get_created_at(), original->get_created_at());
+                EXPECT_EQ(imported->get_updated_at(), original->get_updated_at());
+            }
+        }
+        std::remove(store.c_str());
+        std::remove((store + ".journal").c_str());
+    }
+}
@@ -0,0 +1,215 @@
+#include <gtest/gtest.h>
+#include "task-tracker/task_snapshot.h"
+#include "task-tracker/task_manager.h"
+#include "task-tracker/concurrent_task_manager.h"
+#include <atomic>
+#include <fstream>
+#include <thread>
+#include <vector>
+
+TEST(TaskOrderTest, CopiesShareBlocksUntilWritten) {
+    std::vector<Task*> tasks;
+    for (int i = 0; i < 600; i++) {
+        tasks.push_back(reinterpret_cast<Task*>(static_cast<std::uintptr_t>(8 * (i + 1))));
+    }
+    TaskOrder order;
+    for (Task* task : tasks) {
+        order.push_back(task);
+    }
+    TaskOrder copy = order;
+    order.set(10, nullptr);
+    order.push_back(tasks[0]);
+    order.pop_back();
+    order.pop_back();
+    // 副本不受原列表修改的影响
+    ASSERT_EQ(copy.size(), 600);
+    for (std::size_t i = 0; i < copy.size(); i++) {
+        EXPECT_EQ(copy[i], tasks[i]);
+    }
+    EXPECT_EQ(order.size(), 599);
+    EXPECT_EQ(order[10], nullptr);
+
+    order.remove_nulls();
+    EXPECT_EQ(order.size(), 598);
+    EXPECT_EQ(order[10], tasks[11]);
+    EXPECT_EQ(order.back(), tasks[598]);
+    EXPECT_EQ(copy[10], tasks[10]);
+}
+
+class TaskSnapshotTest : public ::testing::Test {
+protected:
+    std::string test_file = "task_snapshot_test_file.json";
+    std::string export_file = "task_snapshot_test_export.json";
+
+    void SetUp() override {
+        std::ofstream ofs(test_file);
+        ASSERT_TRUE(ofs.is_open());
+        ofs << "[]";
+    }
+
+    void TearDown() override {
+        std::remove(test_file.c_str());
+        std::remove((test_file + ".journal").c_str());
+        std::remove(export_file.c_str());
+    }
+};
+
+TEST_F(TaskSnapshotTest, SnapshotIgnoresLaterChanges) {
+    TaskManager manager(test_file);
+    manager.add_task("First task");
+    manager.add_task("Second task");
+    manager.add_task("Third task");
+
+    TaskSnapshot snapshot = manager.snapshot();
+    manager.update_task_status(1, "DONE");
+    manager.update_task_description(2, "Second task, edited");
+    manager.remove_task(3);
+    manager.add_task("Fourth task");
+
+    ASSERT_EQ(snapshot.size(), 3);
+    EXPECT_EQ(snapshot.next_id(), 4);
+    std::vector<const Task*> listed = snapshot.list_tasks();
+    ASSERT_EQ(listed.size(), 3);
+    EXPECT_EQ(listed[0]->get_status(), TaskStatus::TO_DO);
+    EXPECT_EQ(listed[1]->get_description(), "Second task");
+    EXPECT_EQ(listed[2]->get_description(), "Third task");
+    EXPECT_EQ(snapshot.count_tasks(TaskStatus::TO_DO), 3);
+    EXPECT_EQ(snapshot.get_task(4), nullptr);
+
+    // 管理器看到的是最新状态
+    EXPECT_EQ(manager.get_task(1)->get_status(), TaskStatus::DONE);
+    EXPECT_EQ(manager.get_task(2)->get_description(), "Second task, edited");
+    EXPECT_EQ(manager.get_task(3), nullptr);
+    EXPECT_EQ(manager.list_tasks().size(), 3);
+}
+
+TEST_F(TaskSnapshotTest, TasksAreCopiedOnlyWhileSeen) {
+    TaskManager manager(test_file);
+    Task* task = manager.add_task("Copied on write");
+    EXPECT_EQ(manager.update_task_status(1, "IN_PROGRESS"), task);
+    {
+        TaskSnapshot snapshot = manager.snapshot();
+        Task* copy = manager.update_task_status(1, "DONE");
+        EXPECT_NE(copy, task);
+        EXPECT_GT(copy->get_version(), snapshot.version());
+        // 副本是快照之后写入的, 可以直接修改
+        EXPECT_EQ(manager.update_task_description(1, "Edited in place"), copy);
+        EXPECT_EQ(snapshot.get_task(1), task);
+        EXPECT_EQ(task->get_status(), TaskStatus::IN_PROGRESS);
+    }
+    // 快照释放后不再复制
+    Task* current = manager.get_task(1);
+    EXPECT_EQ(manager.update_task_status(1, "TO_DO"), current);
+}
+
+TEST_F(TaskSnapshotTest, SnapshotSurvivesReclaimAndClear) {
+    TaskManager manager(test_file);
+    for (int i = 1; i <= 1000; i++) {
+        manager.add_task("Task " + std::to_string(i));
+    }
+    TaskSnapshot before_removal = manager.snapshot();
+    // 删除大部分任务会触发墓碑回收, 旧的 list_tasks() 指针会失效, 快照不会
+    for (int i = 1; i <= 900; i++) {
+        manager.remove_task(i);
+    }
+    TaskSnapshot before_clear = manager.snapshot();
+    manager.clear_all_tasks();
+    manager.add_task("After clear");
+
+    ASSERT_EQ(before_removal.size(), 1000);
+    int expected = 1;
+    before_removal.for_each([&expected](const Task& task) {
+        EXPECT_EQ(task.get_id(), expected);
+        EXPECT_EQ(task.get_description(), "Task " + std::to_string(expected));
+        expected++;
+    });
+    EXPECT_EQ(expected, 1001);
+    ASSERT_EQ(before_clear.size(), 100);
+    EXPECT_EQ(before_clear.list_tasks().front()->get_id(), 901);
+    EXPECT_EQ(manager.list_tasks().size(), 1);
+}
+
+TEST_F(TaskSnapshotTest, SnapshotSurvivesRollback) {
+    TaskManager manager(test_file);
+    manager.add_task("Committed");
+    manager.begin_batch();
+    manager.add_task("Rolled back");
+    TaskSnapshot snapshot = manager.snapshot();
+    manager.rollback();
+
+    EXPECT_EQ(snapshot.size(), 2);
+    EXPECT_EQ(snapshot.get_task(2)->get_description(), "Rolled back");
+    EXPECT_EQ(manager.list_tasks().size(), 1);
+}
+
+TEST_F(TaskSnapshotTest, ExportWritesTheSnapshotState) {
+    {
+        TaskManager manager(test_file);
+        manager.add_task("Exported");
+        TaskSnapshot snapshot = manager.snapshot();
+        manager.update_task_status(1, "DONE");
+        manager.add_task("Not exported");
+        snapshot.export_snapshot(export_file);
+    }
+    TaskManager exported(export_file);
+    ASSERT_EQ(exported.list_tasks().size(), 1);
+    EXPECT_EQ(exported.get_task(1)->get_status(), TaskStatus::TO_DO);
+    EXPECT_EQ(exported.add_task("Next")->get_id(), 2);
+}
+
+TEST_F(TaskSnapshotTest, MappedDescriptionsOutliveCompaction) {
+    std::string bin_file = "task_snapshot_test_file.bin";
+    std::remove(bin_file.c_str());
+    {
+        TaskManager manager(bin_file);
+        manager.add_task("Mapped task");
+        manager.compact();
+    }
+    {
+        TaskManagerOptions options;
+        options.memory_map = true;
+        TaskManager manager(bin_file, options);
+        TaskSnapshot snapshot = manager.snapshot();
+        // 重写快照时管理器放弃映射, 快照仍然引用映射中的描述
+        manager.compact();
+        EXPECT_TRUE(manager.get_task(1)->owns_description());
+        const Task* mapped = snapshot.get_task(1);
+        ASSERT_NE(mapped, nullptr);
+        EXPECT_FALSE(mapped->owns_description());
+        EXPECT_EQ(mapped->get_description(), "Mapped task");
+    }
+    std::remove(bin_file.c_str());
+    std::remove((bin_file + ".journal").c_str());
+}
+
+TEST_F(TaskSnapshotTest, ReadersIterateWithoutTheLock) {
+    ConcurrentTaskManager manager(test_file);
+    const int count = 200;
+    for (int i = 0; i < count; i++) {
+        manager.add_task("Task " + std::to_string(i));
+    }
+    std::vector<int> ids;
+    for (int i = 1; i <= count; i++) {
+        ids.push_back(i);
+    }
+    std::atomic<bool> done{ false };
+    std::thread writer([&] {
+        // 每次批量修改所有任务的状态, 一致的视图中所有任务状态相同
+        for (int round = 0; round < 50; round++) {
+            manager.update_status_bulk(ids, round % 2 ? TaskStatus::DONE : TaskStatus::IN_PROGRESS);
+        }
+        done = true;
+    });
+    int torn = 0, seen = 0;
+    while (!done || seen == 0) {
+        TaskSnapshot snapshot = manager.snapshot();
+        std::size_t done_count = snapshot.count_tasks(TaskStatus::DONE);
+        if (done_count != 0 && done_count != static_cast<std::size_t>(count)) {
+            torn++;
+        }
+        seen++;
+    }
+    writer.join();
+    EXPECT_EQ(torn, 0);
+    EXPECT_EQ(manager.snapshot().count_tasks(TaskStatus::DONE), static_cast<std::size_t>(count));
+}
@@ -0,0 +1,115 @@
+#include <gtest/gtest.h>
+#include "task-tracker/text_index.h"
+#include "task-tracker/task_manager.h"
+#include "task-tracker/concurrent_task_manager.h"
+#include <fstream>
+
+TEST(TextIndexTest, MatchesEveryWord) {
+    TextIndex index;
+    index.add(1, "Deploy the API server");
+    index.add(2, "Review deploy checklist");
+    index.add(3, "deploy, deploy, DEPLOY!");
+    index.add(4, "修复 登录 问题");
+
+    EXPECT_EQ(index.search("deploy"), (std::vector<int>{ 1, 2, 3 }));
+    EXPECT_EQ(index.search("DEPLOY server"), (std::vector<int>{ 1 }));
+    EXPECT_EQ(index.search("deploy missing"), std::vector<int>());
+    EXPECT_EQ(index.search("登录"), (std::vector<int>{ 4 }));
+    // 没有词的查询不匹配任何任务
+    EXPECT_EQ(index.search(" ,. "), std::vector<int>());
+
+    index.remove(3, "deploy, deploy, DEPLOY!");
+    EXPECT_EQ(index.search("deploy"), (std::vector<int>{ 1, 2 }));
+    index.add(0, "deploy first");
+    EXPECT_EQ(index.search("deploy"), (std::vector<int>{ 0, 1, 2 }));
+}
+
+TEST(TextIndexTest, PrefixWords) {
+    TextIndex index;
+    index.add(1, "deploy api");
+    index.add(2, "deployment notes");
+    index.add(3, "depot api");
+    index.add(4, "notes");
+
+    EXPECT_EQ(index.search("deploy*"), (std::vector<int>{ 1, 2 }));
+    EXPECT_EQ(index.search("dep* api"), (std::vector<int>{ 1, 3 }));
+    EXPECT_EQ(index.search("dep* not*"), (std::vector<int>{ 2 }));
+    EXPECT_EQ(index.search("x*"), std::vector<int>());
+    // 没有 * 时必须完全匹配
+    EXPECT_EQ(index.search("dep"), std::vector<int>());
+
+    index.remove(2, "deployment notes");
+    EXPECT_EQ(index.search("deploy*"), (std::vector<int>{ 1 }));
+    EXPECT_EQ(index.word_count(), 4);
+}
+
+class SearchTest : public ::testing::Test {
+protected:
+    std::string test_file = "search_test_file.json";
+
+    void SetUp() override {
+        std::ofstream ofs(test_file);
+        ASSERT_TRUE(ofs.is_open());
+        ofs << "[]";
+    }
+
+    void TearDown() override {
+        std::remove(test_file.c_str());
+        std::remove((test_file + ".journal").c_str());
+    }
+
+    static std::vector<int> ids(const std::vector<const Task*>& tasks) {
+        std::vector<int> result;
+        for (const Task* task : tasks) {
+            result.push_back(task->get_id());
+        }
+        return result;
+    }
+};
+
+TEST_F(SearchTest, IndexFollowsMutations) {
+    TaskManager manager(test_file);
+    manager.add_task("Write release notes");
+    manager.add_task("Deploy release");
+    EXPECT_FALSE(manager.has_text_index());
+    EXPECT_EQ(ids(manager.search("release")), (std::vector<int>{ 1, 2 }));
+    EXPECT_TRUE(manager.has_text_index());
+
+    // 建立索引之后的修改都要反映在结果中
+    manager.add_task("Release party");
+    manager.update_task_description(1, "Write changelog");
+    manager.remove_task(2);
+    EXPECT_EQ(ids(manager.search("release")), (std::vector<int>{ 3 }));
+    EXPECT_EQ(ids(manager.search("change*")), (std::vector<int>{ 1 }));
+    EXPECT_EQ(manager.search("release")[0]->get_description(), "Release party");
+
+    manager.clear_all_tasks();
+    EXPECT_TRUE(manager.search("release").empty());
+    manager.add_task("Release again");
+    EXPECT_EQ(ids(manager.search("release")), (std::vector<int>{ 4 }));
+}
+
+TEST_F(SearchTest, IndexSurvivesRollbackAndReload) {
+    TaskManager manager(test_file);
+    manager.add_task("Kept task");
+    EXPECT_EQ(manager.search("kept").size(), 1);
+    manager.begin_batch();
+    manager.add_task("Kept too, but rolled back");
+    manager.update_task_description(1, "Renamed");
+    manager.rollback();
+    // 回滚重新加载快照, 索引随之重建
+    EXPECT_EQ(ids(manager.search("kept")), (std::vector<int>{ 1 }));
+    EXPECT_TRUE(manager.search("renamed").empty());
+}
+
+TEST_F(SearchTest, ConcurrentSearch) {
+    ConcurrentTaskManager manager(test_file);
+    manager.add_task("Alpha task");
+    manager.add_task("Beta task");
+    std::vector<TaskData> found = manager.search("beta");
+    ASSERT_EQ(found.size(), 1);
+    EXPECT_EQ(found[0].id, 2);
+    manager.add_task("Beta again");
+    EXPECT_EQ(manager.search("task").size(), 2);
+    EXPECT_EQ(manager.search("beta").size(), 2);
+}
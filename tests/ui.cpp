@@ -1,6 +1,12 @@
 #include <gtest/gtest.h>
 #include "ui.h"
 #include "task_manager.h"
+#include "renderer.h"
+#include <cstdlib>
+#include <ctime>
+#include <nlohmann/json.hpp>
+#include <sstream>
+#include <thread>
 
 class PrintTest : public ::testing::Test {
 protected:
@@ -45,9 +51,9 @@ protected:
             "updated_at": 1672830059
         }
     ]
-})"; // ע
+})"; // 注意这里的括号
     void SetUp() override {
-        // ÿǰļ
+        // 在每个测试前创建测试文件
         std::ofstream ofs(test_file);
         ASSERT_TRUE(ofs.is_open()) << "Failed to create test file for SetUp.";
 
@@ -55,8 +61,9 @@ protected:
         ofs.close();
     }
     void TearDown() override {
-        // ÿԺɾļ
+        // 在每个测试后删除测试文件
         std::remove(test_file.c_str());
+        std::remove((test_file + ".journal").c_str());
     }
 };
 
@@ -66,7 +73,7 @@ TEST_F(PrintTest, PrintTests) {
     testing::internal::CaptureStdout();
     print_tasks(all_tasks);
     std::string output = testing::internal::GetCapturedStdout();
-    // Ƿ ID ,״̬
+    // 检查输出是否包含所有任务的 ID ,状态和描述
     for (const auto& task : all_tasks) {
         EXPECT_NE(output.find(std::to_string(task->get_id())), std::string::npos);
         EXPECT_NE(output.find(task->get_description()), std::string::npos);
@@ -101,7 +108,7 @@ TEST_F(PrintTest, PrintRemovedTask) {
     print_removed_task(3, success);
     std::string output = testing::internal::GetCapturedStdout();
     EXPECT_NE(output.find("removed successfully"), std::string::npos);
-    // Ƴڵ
+    // 尝试移除不存在的任务
     success = manager.remove_task(999);
     testing::internal::CaptureStdout();
     print_removed_task(999, success);
@@ -127,7 +134,7 @@ TEST_F(PrintTest, PrintGetTask) {
     std::string output = testing::internal::GetCapturedStdout();
     EXPECT_NE(output.find(std::to_string(1)), std::string::npos);
     EXPECT_NE(output.find("Test task 1"), std::string::npos);
-    // Իȡڵ
+    // 尝试获取不存在的任务
     task = manager.get_task(9999);
     testing::internal::CaptureStdout();
     print_get_task(task);
@@ -137,7 +144,7 @@ TEST_F(PrintTest, PrintGetTask) {
 
 TEST_F(PrintTest, PrintEmptyTaskList) {
     TaskManager manager(test_file);
-    // 
+    // 清空所有任务
     manager.clear_all_tasks();
     testing::internal::CaptureStdout();
     std::vector<const Task*> empty_tasks = manager.list_tasks();
@@ -153,7 +160,7 @@ TEST_F(PrintTest, PrintClearedAllTasks) {
     print_cleared_all_tasks(success);
     std::string output = testing::internal::GetCapturedStdout();
     EXPECT_NE(output.find("cleared successfully"), std::string::npos);
-    // ѾΪյб
+    // 尝试清空已经为空的任务列表
     success = manager.clear_all_tasks();
     testing::internal::CaptureStdout();
     print_cleared_all_tasks(success);
@@ -166,22 +173,210 @@ TEST_F(PrintTest, PrintRemovedLastTask) {
     bool success = manager.remove_last_task();
     testing::internal::CaptureStdout();
 	int id = 5;
-    print_removed_last_task(id, success); // һ ID  5
+    print_removed_last_task(id, success); // 假设最后一个任务 ID 是 5
     std::string output = testing::internal::GetCapturedStdout();
     EXPECT_NE(output.find("Last task removed successfully"), std::string::npos);
-    // ƳһֱûΪֹ
+    // 尝试移除最后一个任务直到没有任务为止
     manager.remove_last_task();
     manager.remove_last_task();
     manager.remove_last_task();
     manager.remove_last_task();
-    success = manager.remove_last_task(); // Ӧû
+    success = manager.remove_last_task(); // 现在应该没有任务了
     testing::internal::CaptureStdout();
 	id = -1;
-    print_removed_last_task(id, success); // ID 
+    print_removed_last_task(id, success); // ID 无意义
     output = testing::internal::GetCapturedStdout();
     EXPECT_NE(output.find("No tasks to remove"), std::string::npos);
 }
 
+TEST(TimestampCacheTest, MatchesAsctime) {
+    TimestampCache cache;
+    std::time_t start = 1672567200;
+    // 每步 7 分 13 秒, 覆盖若干天和整点
+    for (std::time_t time = start; time < start + 5 * 86400; time += 433) {
+        std::string text;
+        cache.append_asctime(text, time);
+        EXPECT_EQ(text, std::asctime(std::localtime(&time))) << time;
+    }
+    // 同一小时内的时间不再调用 localtime
+    EXPECT_LT(cache.misses(), 5 * 24 + 2);
+
+    std::string text;
+    std::time_t time = start + 59;
+    cache.append_short(text, time);
+    char expected[32];
+    std::strftime(expected, sizeof(expected), "%Y-%m-%d %H:%M", std::localtime(&time));
+    EXPECT_EQ(text, expected);
+}
+
+TEST(TimestampCacheTest, OffsetChangesOffTheHour) {
+#ifdef _WIN32
+    GTEST_SKIP() << "uses a POSIX TZ rule";
+#else
+    // 像 Lord Howe 岛一样夏令时只差 30 分钟, 并且在当地时间 2:30 切换, 不在整点上
+    const char* saved = std::getenv("TZ");
+    std::string old_tz = saved ? saved : "";
+    setenv("TZ", "LHST-10:30LHDT-11,M10.1.0/2:30,M4.1.0/2:30", 1);
+    tzset();
+
+    TimestampCache cache;
+    // 2023-04-01 和 2023-09-30 (UTC) 各一整天, 包含两次切换
+    for (std::time_t start : { std::time_t(1680307200), std::time_t(1696032000) }) {
+        for (std::time_t time = start; time < start + 86400; time += 61) {
+            std::string text;
+            cache.append_asctime(text, time);
+            EXPECT_EQ(text, std::asctime(std::localtime(&time))) << time;
+        }
+    }
+
+    if (saved) {
+        setenv("TZ", old_tz.c_str(), 1);
+    }
+    else {
+        unsetenv("TZ");
+    }
+    tzset();
+#endif
+}
+
+TEST_F(PrintTest, RendererKeepsTheDetailedFormat) {
+    TaskManager manager(test_file);
+    std::vector<const Task*> all_tasks = manager.list_tasks();
+    // 与原来逐行输出的格式逐字节相同
+    std::ostringstream expected;
+    for (const Task* task : all_tasks) {
+        std::time_t created_at = task->get_created_at();
+        std::time_t updated_at = task->get_updated_at();
+        expected << "-------------------------\n"
+            << "Task ID: " << task->get_id() << "\n"
+            << "Description: " << task->get_description() << "\n"
+            << "Status: " << status_to_string(task->get_status()) << "\n"
+            << "Created At: " << std::asctime(std::localtime(&created_at))
+            << "Updated At: " << std::asctime(std::localtime(&updated_at))
+            << "-------------------------\n"
+            << "------------------------\n";
+    }
+    TaskRenderer renderer;
+    std::ostringstream out;
+    renderer.append_tasks(all_tasks, out);
+    renderer.write(out);
+    EXPECT_EQ(out.str(), expected.str());
+    EXPECT_TRUE(renderer.view().empty());
+}
+
+TEST_F(PrintTest, TableHasOneLinePerTask) {
+    TaskManager manager(test_file);
+    manager.update_task_description(3, "Line one\nline two");
+    std::vector<const Task*> all_tasks = manager.list_tasks();
+    testing::internal::CaptureStdout();
+    print_tasks(all_tasks, RenderStyle::Table);
+    std::string output = testing::internal::GetCapturedStdout();
+
+    std::istringstream lines(output);
+    std::string line;
+    ASSERT_TRUE(std::getline(lines, line));
+    EXPECT_EQ(line.find("    ID  STATUS"), 0);
+    for (const Task* task : all_tasks) {
+        ASSERT_TRUE(std::getline(lines, line));
+        EXPECT_EQ(std::stoi(line), task->get_id());
+        EXPECT_NE(line.find(status_to_string(task->get_status())), std::string::npos);
+    }
+    EXPECT_FALSE(std::getline(lines, line));
+    EXPECT_NE(output.find("Line one line two"), std::string::npos);
+}
+
+TEST_F(PrintTest, ConcurrentBatchesDoNotInterleave) {
+    TaskManager manager(test_file);
+    std::vector<const Task*> all_tasks = manager.list_tasks();
+    std::ostringstream out;
+    std::string batch;
+    {
+        TaskRenderer renderer(RenderStyle::Table);
+        renderer.append_tasks(all_tasks, out);
+        batch = std::string(renderer.view());
+    }
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; i++) {
+        threads.emplace_back([&] {
+            TaskRenderer renderer(RenderStyle::Table);
+            for (int round = 0; round < 100; round++) {
+                renderer.append_tasks(all_tasks, out);
+                renderer.write(out);
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    std::string output = out.str();
+    ASSERT_EQ(output.size(), batch.size() * 400);
+    for (std::size_t at = 0; at < output.size(); at += batch.size()) {
+        EXPECT_EQ(output.compare(at, batch.size(), batch), 0);
+    }
+}
+
+TEST_F(PrintTest, MachineReadableFormats) {
+    TaskManager manager(test_file);
+    manager.update_task_description(2, "Say \"hi\", then\tleave\nnow \\ ok");
+    const Task* task = manager.get_task(2);
+
+    TaskRenderer renderer(RenderStyle::JsonLines);
+    renderer.append(task);
+    nlohmann::json record = nlohmann::json::parse(renderer.view());
+    EXPECT_EQ(record["id"], 2);
+    EXPECT_EQ(record["description"], "Say \"hi\", then\tleave\nnow \\ ok");
+    EXPECT_EQ(record["status"], "IN_PROGRESS");
+    EXPECT_EQ(record["created_at"], 1672657200);
+    EXPECT_EQ(record["updated_at"], task->get_updated_at());
+    EXPECT_EQ(renderer.view().back(), '\n');
+
+    std::string updated = std::to_string(task->get_updated_at());
+    renderer.clear();
+    renderer.set_style(RenderStyle::Csv);
+    renderer.append_header();
+    renderer.append(task);
+    EXPECT_EQ(renderer.view(), "id,description,status,created_at,updated_at\r\n"
+        "2,\"Say \"\"hi\"\", then\tleave\nnow \\ ok\",IN_PROGRESS,1672657200," + updated + "\r\n");
+
+    renderer.clear();
+    renderer.set_style(RenderStyle::Tsv);
+    renderer.append(task);
+    EXPECT_EQ(renderer.view(), "2\tSay \"hi\", then\\tleave\\nnow \\\\ ok\tIN_PROGRESS\t1672657200\t" + updated + "\n");
+
+    // 机器可读的格式不输出提示文字
+    renderer.clear();
+    std::ostringstream out;
+    renderer.append_tasks({}, out);
+    EXPECT_EQ(renderer.view(), "id\tdescription\tstatus\tcreated_at\tupdated_at\n");
+
+    RenderStyle style;
+    EXPECT_TRUE(parse_render_style("jsonl", style));
+    EXPECT_EQ(style, RenderStyle::JsonLines);
+    EXPECT_FALSE(parse_render_style("xml", style));
+}
+
+TEST_F(PrintTest, ExportStreamsEveryTask) {
+    TaskManager manager(test_file);
+    for (int i = 0; i < 3000; i++) {
+        manager.add_task("Exported task " + std::to_string(i));
+    }
+    // 与 print_tasks 的列表输出相同, 但不经过任务列表
+    std::vector<const Task*> all_tasks = manager.list_tasks();
+    testing::internal::CaptureStdout();
+    print_tasks(all_tasks, RenderStyle::JsonLines);
+    std::string expected = testing::internal::GetCapturedStdout();
+    ASSERT_GT(expected.size(), TaskRenderer::flush_threshold);
+
+    std::ostringstream out;
+    EXPECT_EQ(export_tasks(manager, out, RenderStyle::JsonLines), all_tasks.size());
+    EXPECT_EQ(out.str(), expected);
+
+    std::ostringstream done;
+    EXPECT_EQ(export_tasks(manager, done, RenderStyle::Csv, TaskStatus::DONE), 1);
+    EXPECT_EQ(done.str().find("id,description"), 0);
+    EXPECT_NE(done.str().find("\r\n3,Test task 3,DONE,"), std::string::npos);
+}
+
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
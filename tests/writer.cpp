@@ -0,0 +1,96 @@
+#include <gtest/gtest.h>
+#include "task-tracker/background_writer.h"
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+TEST(BackgroundWriterTest, CoalescesRecordsAndSnapshots) {
+    std::vector<std::string> writes;
+    {
+        BackgroundWriter writer(
+            [&](const std::string& snapshot, std::uint64_t) { writes.push_back("snapshot:" + snapshot); },
+            [&](const std::string& lines, std::size_t count) { writes.push_back(std::to_string(count) + ":" + lines); },
+            std::chrono::seconds(30), 1000);
+        writer.submit_records("a\n", 1);
+        writer.submit_records("b\n", 1);
+        writer.flush();
+        ASSERT_EQ(writes.size(), 1);
+        EXPECT_EQ(writes[0], "2:a\nb\n");
+
+        // 快照覆盖了它之前尚未写出的记录
+        writer.submit_records("c\n", 1);
+        writer.submit_snapshot("first", 1);
+        writer.submit_snapshot("second", 2);
+        writer.submit_records("d\n", 1);
+    }
+    ASSERT_EQ(writes.size(), 3);
+    EXPECT_EQ(writes[1], "snapshot:second");
+    EXPECT_EQ(writes[2], "1:d\n");
+}
+
+TEST(BackgroundWriterTest, WritesWhenEnoughRecordsArePending) {
+    std::atomic<std::size_t> written{ 0 };
+    BackgroundWriter writer(
+        [](const std::string&, std::uint64_t) {},
+        [&](const std::string&, std::size_t count) { written += count; },
+        std::chrono::seconds(30), 4);
+    for (int i = 0; i < 4; i++) {
+        writer.submit_records("x\n", 1);
+    }
+    // 达到 max_pending 后不必等满 30 秒, 也不需要 flush()
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (written < 4 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_EQ(written, 4);
+}
+
+TEST(BackgroundWriterTest, FlushRethrowsWriteErrors) {
+    BackgroundWriter writer(
+        [](const std::string&, std::uint64_t) { throw std::runtime_error("disk full"); },
+        [](const std::string&, std::size_t) {},
+        std::chrono::milliseconds(1), 10);
+    writer.submit_snapshot("bytes", 0);
+    EXPECT_THROW(writer.flush(), std::runtime_error);
+    // 错误只报告一次
+    writer.submit_records("x\n", 1);
+    EXPECT_NO_THROW(writer.flush());
+}
+
+TEST(BackgroundWriterTest, FailedSnapshotKeepsSupersededRecords) {
+    std::vector<std::string> writes;
+    BackgroundWriter writer(
+        [](const std::string&, std::uint64_t) { throw std::runtime_error("disk full"); },
+        [&](const std::string& lines, std::size_t count) { writes.push_back(std::to_string(count) + ":" + lines); },
+        std::chrono::seconds(30), 1000);
+    writer.submit_records("a\n", 1);
+    writer.submit_snapshot("covers a", 0);
+    writer.submit_records("b\n", 1);
+    EXPECT_THROW(writer.flush(), std::runtime_error);
+    // 快照没有写成, 被它取代的记录仍然写入 journal, 并排在之后的记录前面
+    ASSERT_EQ(writes.size(), 1);
+    EXPECT_EQ(writes[0], "2:a\nb\n");
+}
+
+TEST(BackgroundWriterTest, NextSubmitReportsWriteErrors) {
+    BackgroundWriter writer(
+        [](const std::string&, std::uint64_t) { throw std::runtime_error("disk full"); },
+        [](const std::string&, std::size_t) {},
+        std::chrono::milliseconds(1), 10);
+    writer.submit_snapshot("bytes", 0);
+    // 不必等到 flush(): 后台写入失败之后的下一次提交就会报告
+    bool reported = false;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (!reported && std::chrono::steady_clock::now() < deadline) {
+        try {
+            writer.submit_records("x\n", 1);
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        catch (const std::runtime_error&) {
+            reported = true;
+        }
+    }
+    EXPECT_TRUE(reported);
+    EXPECT_NO_THROW(writer.flush());
+}